@@ -5,36 +5,43 @@
 #include <QFileDialog>
 #include <QHeaderView>
 #include <QInputDialog>
+#include <QListWidget>
 #include <QListView>
 #include <QPushButton>
 #include <QProgressBar>
 #include <QString>
+#include <QThread>
 #include <QTimer>
-#include <QStandardItem>
-#include <QStandardItemModel>
+#include <QStatusBar>
 
 #include "ui_CellLineage.h"
 #include "CellLineage.h"
+#include "QGeneTableModel.h"
 
 #include <vtkAlgorithmOutput.h>
 #include <vtkAnnotationLink.h>
-#include <vtkConvertSelection.h>
+#include <vtkCellGeneIndex.h>
 #include <vtkDataRepresentation.h>
-#include <vtkDelimitedTextReader.h>
+#include <vtkDoubleArray.h>
 #include <vtkEventQtSlotConnect.h>
-#include <vtkGraph.h>
+#include <vtkFloatArray.h>
+#include <vtkGeneCoexpression.h>
+#include <vtkGeneExpressionReader.h>
+#include <vtkGeneOnsetAnalysis.h>
+#include <vtkGeneQuery.h>
 #include <vtkIdTypeArray.h>
+#include <vtkLineageTreeReader.h>
 #include <vtkLineageView.h>
-#include <vtkOutEdgeIterator.h>
 #include <vtkPointData.h>
 #include <vtkQtTreeView.h>
+#include <vtkSelection.h>
 #include <vtkSelectionNode.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
-#include <vtkTableToGraph.h>
 #include <vtkTableWriter.h>
 #include <vtkTree.h>
-#include <vtkTreeReader.h>
+#include <vtkTrivialProducer.h>
+#include <vtkUnsignedCharArray.h>
 #include <vtkQtTreeModelAdapter.h>
 #include <vtkVariant.h>
 #include <vtkViewTheme.h>
@@ -69,6 +76,29 @@ private:
   vector<vtkView*> Views;
 };
 
+// Generations shown first when opening a lineage progressively, and the
+// number of generations read next, doubled with every batch.
+#define CELL_LINEAGE_FIRST_GENERATIONS 8
+#define CELL_LINEAGE_GENERATION_STEP 4
+
+// Runs the lineage reader off the GUI thread. The reader and its output
+// are left alone by the GUI until finished() is received.
+class CellLineageLoader : public QThread
+{
+public:
+  CellLineageLoader(vtkLineageTreeReader* reader, QObject* parent)
+    : QThread(parent), Reader(reader) { }
+
+protected:
+  virtual void run()
+  {
+    this->Reader->Update();
+  }
+
+private:
+  vtkLineageTreeReader* Reader;
+};
+
 // Constructor
 CellLineage::
 CellLineage( QWidget* iParent, Qt::WindowFlags iFlags ) :
@@ -77,7 +107,9 @@ CellLineage( QWidget* iParent, Qt::WindowFlags iFlags ) :
   this->ui = new Ui_CellLineage;
   this->ui->setupUi(this);
 
-  this->LineageReader       = vtkTreeReader::New();
+  this->LineageReader       = vtkLineageTreeReader::New();
+  this->Lineage             = vtkTree::New();
+  this->LineageSource       = vtkTrivialProducer::New();
   this->LineageView         = vtkLineageView::New();
   this->VolumeReader        = vtkXMLImageDataReader::New();
   this->VolumeView          = vtkVolumeViewer::New();
@@ -96,8 +128,20 @@ CellLineage( QWidget* iParent, Qt::WindowFlags iFlags ) :
 
   this->ui->treeTextView->layout()->addWidget(this->QtTreeView->GetWidget());
 
-  this->GeneTable = 0;
-  this->GeneGraph = 0;
+  // The views show the lineage held by the source, whose tree is replaced
+  // as deeper generations are read
+  this->LineageSource->SetOutput(this->Lineage);
+  this->LineageLoader = new CellLineageLoader(this->LineageReader, this);
+  this->LoadedGeneration = -1;
+  this->GenerationStep = 0;
+  connect(this->LineageLoader, SIGNAL(finished()), this, SLOT(slotLineageBatchLoaded()));
+
+  this->GeneIndex = vtkCellGeneIndex::New();
+  this->GeneQuery = vtkGeneQuery::New();
+  this->OnsetAnalysis = vtkGeneOnsetAnalysis::New();
+  this->Coexpression = vtkGeneCoexpression::New();
+  this->GeneLevels = vtkFloatArray::New();
+  this->GeneLevels->SetName("GeneLevel");
 
   // Lineage Viewer needs to get my render window
   this->LineageView->SetInteractor(this->ui->vtkLineageViewWidget->GetInteractor());
@@ -125,6 +169,8 @@ CellLineage( QWidget* iParent, Qt::WindowFlags iFlags ) :
     this, SLOT(slotSetElbow(int)));
   connect(this->ui->elbowAngleSlider, SIGNAL(valueChanged(int)),
     this, SLOT(slotSetElbowAngle(int)));
+  connect(this->ui->curveCheckBox, SIGNAL(stateChanged(int)),
+    this, SLOT(slotSetCurve(int)));
   connect(this->ui->distanceCheckBox, SIGNAL(stateChanged(int)),
     this, SLOT(slotSetDistanceByTime(int)));
   connect(this->ui->colorEdgesCheckBox, SIGNAL(stateChanged(int)),
@@ -151,6 +197,38 @@ CellLineage( QWidget* iParent, Qt::WindowFlags iFlags ) :
   connect(this->ui->actionOpenGeneData, SIGNAL(triggered()), this, SLOT(slotOpenGeneData()));
   connect(this->ui->actionOpenDataFile, SIGNAL(triggered()), this, SLOT(slotOpenVolumeData()));
   connect(this->ui->actionExit, SIGNAL(triggered()), this, SLOT(slotExit()));
+  connect(this->ui->actionCollapseGeneration, SIGNAL(triggered()), this, SLOT(slotCollapseGeneration()));
+  connect(this->ui->actionCollapseAfterTime, SIGNAL(triggered()), this, SLOT(slotCollapseAfterTime()));
+  connect(this->ui->actionExpandAll, SIGNAL(triggered()), this, SLOT(slotExpandAll()));
+  connect(this->ui->actionSelectDescendants, SIGNAL(triggered()), this, SLOT(slotSelectDescendants()));
+  connect(this->ui->actionSelectAncestors, SIGNAL(triggered()), this, SLOT(slotSelectAncestors()));
+  connect(this->ui->actionSelectSiblings, SIGNAL(triggered()), this, SLOT(slotSelectSiblings()));
+  connect(this->ui->actionSelectSameGeneration, SIGNAL(triggered()), this, SLOT(slotSelectSameGeneration()));
+  connect(this->ui->actionSelectGeneration, SIGNAL(triggered()), this, SLOT(slotSelectGeneration()));
+  connect(this->ui->actionColorByGeneCount, SIGNAL(triggered()), this, SLOT(slotColorByGeneCount()));
+  connect(this->ui->actionColorByOnsetCount, SIGNAL(triggered()), this, SLOT(slotColorByOnsetCount()));
+  connect(this->ui->actionColorBySubtreeOnsetCount, SIGNAL(triggered()), this, SLOT(slotColorBySubtreeOnsetCount()));
+  connect(this->ui->actionColorBySelectedGene, SIGNAL(triggered()), this, SLOT(slotColorBySelectedGene()));
+  connect(this->ui->actionColorByGeneLevel, SIGNAL(triggered()), this, SLOT(slotColorByGeneLevel()));
+  connect(this->ui->actionPrecomputeSimilarGenes, SIGNAL(triggered()), this, SLOT(slotPrecomputeSimilarGenes()));
+  connect(this->ui->actionCosineSimilarity, SIGNAL(toggled(bool)), this, SLOT(slotSetCosineSimilarity(bool)));
+  connect(this->ui->similarGenesListWidget, SIGNAL(itemActivated(QListWidgetItem*)),
+    this, SLOT(slotSimilarGeneActivated(QListWidgetItem*)));
+  connect(this->ui->geneQueryLineEdit, SIGNAL(returnPressed()), this, SLOT(slotGeneQuery()));
+
+  // Gene list, filtered by the search box
+  this->GeneModel = new QGeneTableModel(this);
+  this->ui->geneTableView->setModel(this->GeneModel);
+  connect(
+    this->ui->geneTableView->selectionModel(),
+    SIGNAL(selectionChanged(const QItemSelection&, const QItemSelection&)),
+    this, SLOT(slotGeneSelectionChanged()));
+  connect(
+    this->ui->geneTableView->selectionModel(),
+    SIGNAL(currentRowChanged(const QModelIndex&, const QModelIndex&)),
+    this, SLOT(slotCurrentGeneChanged()));
+  connect(this->ui->geneSearchLineEdit, SIGNAL(textChanged(const QString&)),
+    this->GeneModel, SLOT(setPrefix(const QString&)));
 
   this->SelectingGenesFromCells = false;
   this->SelectingCellsFromGenes = false;
@@ -158,7 +236,11 @@ CellLineage( QWidget* iParent, Qt::WindowFlags iFlags ) :
 
 CellLineage::~CellLineage()
 {
+  this->LineageLoader->wait();
+  delete this->LineageLoader;
   this->LineageReader->Delete();
+  this->Lineage->Delete();
+  this->LineageSource->Delete();
   this->LineageView->Delete();
   this->VolumeReader->Delete();
   this->VolumeView->Delete();
@@ -166,17 +248,11 @@ CellLineage::~CellLineage()
   this->AnnotationLink->Delete();
   this->Updater->Delete();
   this->Connect->Delete();
-
-  if (this->GeneTable != NULL)
-    {
-    this->GeneTable->Delete();
-    this->GeneTable = NULL;
-    }
-  if (this->GeneGraph != NULL)
-    {
-    this->GeneGraph->Delete();
-    this->GeneGraph = NULL;
-    }
+  this->GeneIndex->Delete();
+  this->GeneQuery->Delete();
+  this->OnsetAnalysis->Delete();
+  this->Coexpression->Delete();
+  this->GeneLevels->Delete();
 }
 
 // Description:
@@ -354,86 +430,69 @@ void CellLineage::slotOpenGeneData()
     this,
     "Select the gene expression data file",
     QDir::homePath(),
-    "Comma Separated Values Files (*.csv);;All Files (*.*)");
+    "Comma Separated Values Files (*.csv);;"
+    "Gene Adjacency Files (*.adj);;All Files (*.*)");
 
   if (fileName.isNull())
     {
     return;
     }
 
-  // Read in the gene table
-  vtkDelimitedTextReader* reader = vtkDelimitedTextReader::New();
+  // Read in the expressed (cell, gene) pairs, the expression matrix, or
+  // the adjacency written by TableToAdjacencyList -b
+  vtkGeneExpressionReader* reader = vtkGeneExpressionReader::New();
   reader->SetFileName(fileName.toStdString().c_str());
-  reader->SetMergeConsecutiveDelimiters(false);
-  reader->SetHaveHeaders(true);
-  reader->Update();
-  this->GeneTable = reader->GetOutput();
-  this->GeneTable->Register(0);
-  reader->Delete();
-
-  // Make a graph of the gene table
-  vtkTableToGraph* tableToGraph = vtkTableToGraph::New();
-  tableToGraph->SetInput(this->GeneTable);
-  tableToGraph->AddLinkVertex("cell", "cell");
-  tableToGraph->AddLinkVertex("gene", "gene");
-  tableToGraph->AddLinkEdge("cell", "gene");
-  tableToGraph->Update();
-  this->GeneGraph = tableToGraph->GetOutput();
-  this->GeneGraph->Register(0);
-  tableToGraph->Delete();
-
-  // Make mapping from table ids to graph vertices and back.
-  // Make mapping from tree ids to graph vertices and back.
-  vtkStringArray* domainCol = vtkStringArray::SafeDownCast(
-    this->GeneGraph->GetVertexData()->GetAbstractArray("domain"));
-  vtkStringArray* valueCol = vtkStringArray::SafeDownCast(
-    this->GeneGraph->GetVertexData()->GetAbstractArray("label"));
-  for (vtkIdType v = 0; v < this->GeneGraph->GetNumberOfVertices(); v++)
-    {
-    vtkStdString d = domainCol->GetValue(v);
-    vtkStdString val = valueCol->GetValue(v);
-    if (d == "cell")
-      {
-      this->CellToVertex[val] = v;
-      }
-    else
-      {
-      this->GeneToVertex[val] = v;
-      }
-    }
-
-  // Make a list of gene names
-  // Make GeneToTableRow map
-  map<vtkStdString, vtkIdType>::iterator it, itEnd;
-  it = this->GeneToVertex.begin();
-  itEnd = this->GeneToVertex.end();
-  QList<QStandardItem*> genes;
-  for (vtkIdType r = 0; it != itEnd; ++it, ++r)
+  if (!reader->Read())
     {
-    this->GeneToTableRow[it->first] = r;
-    genes.append(new QStandardItem(QString(it->first.c_str())));
+    reader->Delete();
+    return;
     }
-  QStandardItemModel* model = new QStandardItemModel;
-  model->appendColumn(genes);
-  model->setHeaderData(0, Qt::Horizontal, QVariant("Gene"));
-  this->ui->geneTableView->setModel(model);
 
-  // Make CellToTreePedigree map
+  // Index the genes of every cell of the tree and back. What was read is
+  // only needed to build the index.
   vtkTree* tree = vtkTree::SafeDownCast(
     this->QtTreeView->GetRepresentation()->GetInputConnection()->
       GetProducer()->GetOutputDataObject(0));
   vtkStringArray* nameArr = vtkStringArray::SafeDownCast(
     tree->GetVertexData()->GetAbstractArray("name"));
-  for (vtkIdType i = 0; i < nameArr->GetNumberOfTuples(); ++i)
+  if (reader->GetFormat() == vtkGeneExpressionReader::MATRIX)
+    {
+    this->GeneIndex->Build(nameArr, reader->GetCellNames(),
+      reader->GetGeneNames(), reader->GetMatrix(), reader->GetLevels());
+    }
+  else if (reader->GetFormat() == vtkGeneExpressionReader::BINARY)
+    {
+    this->GeneIndex->Build(nameArr, reader->GetCellNames(),
+      reader->GetGeneNames(), reader->GetCellGeneOffsets(),
+      reader->GetCellGenes(), reader->GetGeneCellOffsets(),
+      reader->GetGeneCells());
+    }
+  else
     {
-    this->CellToTreePedigree[nameArr->GetValue(i)] = i;
+    this->GeneIndex->Build(nameArr, reader->GetCellNames(), reader->GetCells(),
+      reader->GetGeneNames(), reader->GetGenes(), reader->GetLevels());
     }
+  reader->Delete();
+
+  // Find where every gene switches on along the lineage, the totals per
+  // cell become vertex arrays of the tree
+  this->OnsetAnalysis->Update(this->GeneIndex, tree);
+  this->OnsetAnalysis->AddArrays(tree->GetVertexData());
+  tree->Modified();
+
+  // Genes are compared to each other on demand, or all at once with the
+  // result kept next to the gene file
+  this->Coexpression->Update(this->GeneIndex);
+  this->Coexpression->SetCacheFileName((fileName + ".similar").toStdString().c_str());
+  this->ui->similarGenesListWidget->clear();
+
+  // Show the genes, with the number of cells expressing them and the
+  // start time of the first one
+  this->ui->geneSearchLineEdit->clear();
+  this->GeneModel->setIndex(this->GeneIndex,
+    tree->GetVertexData()->GetArray("StartTime"));
 
   // Connect signals to slots
-  connect(
-    this->ui->geneTableView->selectionModel(),
-    SIGNAL(selectionChanged(const QItemSelection&, const QItemSelection&)),
-    this, SLOT(slotGeneSelectionChanged()));
   this->Connect->Connect(
     this->QtTreeView->GetRepresentation(), vtkCommand::SelectionChangedEvent,
     this, SLOT(slotSelectGenesFromCells(vtkObject*, unsigned long, void*, void*)));
@@ -446,55 +505,80 @@ void CellLineage::slotGeneSelectionChanged()
 {
   if (!this->SelectingGenesFromCells)
     {
-    // Convert the gene selection into a cell selection.
-    QItemSelection cellSelection;
+    // Gene rows map to gene ids, cells come out as tree pedigree ids.
     QModelIndexList geneList = this->ui->geneTableView->selectionModel()->selectedRows();
-    //vtkTreeToQtModelAdapter* model = qobject_cast<vtkTreeToQtModelAdapter*>(this->ui->treeTextView->model());
-
-    vtkSmartPointer<vtkSelection> selection =
-      vtkSmartPointer<vtkSelection>::New();
-    vtkSmartPointer<vtkSelectionNode> selectionNode =
-      vtkSmartPointer<vtkSelectionNode>::New();
-    vtkSmartPointer<vtkStringArray> selectionArr =
-      vtkSmartPointer<vtkStringArray>::New();
-    selectionArr->SetName("name");
-    selectionNode->SetSelectionList(selectionArr);
-    selectionNode->SetContentType(vtkSelectionNode::VALUES);
-    selectionNode->SetFieldType(vtkSelectionNode::VERTEX);
-    selection->AddNode(selectionNode);
-
-    vtkStringArray* valueArray = vtkStringArray::SafeDownCast(
-      this->GeneGraph->GetVertexData()->GetAbstractArray("label"));
-    vtkSmartPointer<vtkOutEdgeIterator> it =
-      vtkSmartPointer<vtkOutEdgeIterator>::New();
-    QAbstractItemModel* tableModel = this->ui->geneTableView->model();
+    vtkSmartPointer<vtkIdTypeArray> geneIds =
+      vtkSmartPointer<vtkIdTypeArray>::New();
     for (int g = 0; g < geneList.size(); g++)
       {
-      QString gene = tableModel->data(geneList[g]).toString();
-      vtkIdType geneVertex = this->GeneToVertex[gene.toStdString()];
+      geneIds->InsertNextValue(this->GeneModel->geneOfRow(geneList[g].row()));
+      }
+    vtkSmartPointer<vtkIdTypeArray> cellIds =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+    this->GeneIndex->GetCellsOfGenes(geneIds, cellIds);
+    this->selectCells(cellIds);
+    }
+}
 
-      // Get adjacent graph edges
-      this->GeneGraph->GetOutEdges(geneVertex, it);
-      while (it->HasNext())
-        {
-        vtkOutEdgeType e = it->Next();
-        vtkIdType cellVertex = e.Target;
-        vtkStdString cellName = valueArray->GetValue(cellVertex);
-        vtkIdType pedigree = this->CellToTreePedigree[cellName];
-        selectionArr->InsertNextValue(cellName);
-        //cerr << "selecting cell (" << cellVertex << "," << cellName << "," << pedigree << ") from gene: (" << gene.toStdString() << "," << geneVertex << ")" << endl;
-        //QModelIndex cellIndex = model->PedigreeToQModelIndex(pedigree);
-        //cellSelection.select(cellIndex, cellIndex);
-        }
+// Select the cells matching the gene query
+void CellLineage::slotGeneQuery()
+{
+  vtkTree* tree = this->Lineage;
+  vtkSmartPointer<vtkIdTypeArray> cellIds =
+    vtkSmartPointer<vtkIdTypeArray>::New();
+  this->GeneQuery->SetQuery(this->ui->geneQueryLineEdit->text().toStdString().c_str());
+  if (!this->GeneQuery->Evaluate(this->GeneIndex, tree, cellIds))
+    {
+    this->statusBar()->showMessage(this->GeneQuery->GetErrorMessage());
+    return;
+    }
+  this->statusBar()->showMessage(
+    QString("%1 cells match").arg(cellIds->GetNumberOfTuples()));
+
+  this->selectCells(cellIds);
+}
+
+// Select cells given by pedigree id in all views
+void CellLineage::selectCells(vtkIdTypeArray* cellIds)
+{
+  // Pedigree ids are the vertex indices of the tree as read, so they make
+  // an index selection as they are, without looking at cell names.
+  vtkSmartPointer<vtkSelection> selection =
+    vtkSmartPointer<vtkSelection>::New();
+  vtkSmartPointer<vtkSelectionNode> selectionNode =
+    vtkSmartPointer<vtkSelectionNode>::New();
+  selectionNode->SetContentType(vtkSelectionNode::INDICES);
+  selectionNode->SetFieldType(vtkSelectionNode::VERTEX);
+  selectionNode->SetSelectionList(cellIds);
+  selection->AddNode(selectionNode);
+
+  // Select through the representation, so that the views are updated as
+  // for any other selection, but keep the gene selection as it is.
+  this->SelectingCellsFromGenes = true;
+  this->LineageView->GetRepresentation()->Select(this->LineageView, selection);
+  this->SelectingCellsFromGenes = false;
+  this->LineageView->Render();
+}
+
+// Add to selection the runs of rows marked in rows but not in exclude.
+static void CellLineageSelectRowRuns(QAbstractItemModel* model,
+  const vector<unsigned char>& rows,
+  const vector<unsigned char>& exclude, QItemSelection& selection)
+{
+  int numRows = static_cast<int>(rows.size());
+  for (int row = 0; row < numRows; )
+    {
+    if (!rows[row] || exclude[row])
+      {
+      row++;
+      continue;
       }
-    //this->SelectingCellsFromGenes = true;
-    vtkSmartPointer<vtkSelection> converted;
-    converted.TakeReference(vtkConvertSelection::ToIndexSelection(selection, this->LineageReader->GetOutput()));
-    this->AnnotationLink->SetCurrentSelection(converted);
-    this->QtTreeView->Update();
-    this->LineageView->Render();
-    //this->ui->treeTextView->selectionModel()->select(cellSelection, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
-    //this->SelectingCellsFromGenes = false;
+    int first = row;
+    while (row < numRows && rows[row] && !exclude[row])
+      {
+      row++;
+      }
+    selection.select(model->index(first, 0), model->index(row - 1, 0));
     }
 }
 
@@ -513,41 +597,47 @@ void CellLineage::slotSelectGenesFromCells(vtkObject*, unsigned long, void*, voi
     }
   if (!this->SelectingCellsFromGenes && arr)
     {
-    QAbstractItemModel* tableModel = this->ui->geneTableView->model();
-    QItemSelection geneSelection;
-    vtkStringArray* valueArray = vtkStringArray::SafeDownCast(
-      this->GeneGraph->GetVertexData()->GetAbstractArray("label"));
-    vtkSmartPointer<vtkOutEdgeIterator> it =
-      vtkSmartPointer<vtkOutEdgeIterator>::New();
-    vtkTree* tree = vtkTree::SafeDownCast(
-      this->QtTreeView->GetRepresentation()->GetInputConnection()->
-        GetProducer()->GetOutputDataObject(0));
-    vtkStringArray* nameArray = vtkStringArray::SafeDownCast(
-      tree->GetVertexData()->GetAbstractArray("name"));
-    for (vtkIdType i = 0; i < arr->GetNumberOfTuples(); i++)
+    // Selected ids are tree pedigree ids, genes come out as gene ids and
+    // are marked by the row showing them.
+    vtkSmartPointer<vtkIdTypeArray> geneIds =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+    this->GeneIndex->GetGenesOfCells(arr, geneIds);
+    int numRows = this->GeneModel->rowCount();
+    vector<unsigned char> selected(numRows, 0);
+    for (vtkIdType i = 0; i < geneIds->GetNumberOfTuples(); i++)
       {
-      if (arr->GetValue(i) >= nameArray->GetNumberOfTuples())
+      int row = this->GeneModel->rowOfGene(geneIds->GetValue(i));
+      if (row >= 0)
         {
-        continue;
+        selected[row] = 1;
         }
+      }
 
-      vtkStdString cell = nameArray->GetValue(arr->GetValue(i));
-      vtkIdType cellVertex = this->CellToVertex[cell];
-
-      // Get adjacent graph edges
-      this->GeneGraph->GetOutEdges(cellVertex, it);
-      while (it->HasNext())
+    // Only change the rows whose state differs, as a few ranges.
+    QItemSelectionModel* selectionModel = this->ui->geneTableView->selectionModel();
+    vector<unsigned char> wasSelected(numRows, 0);
+    const QItemSelection current = selectionModel->selection();
+    for (int r = 0; r < current.size(); r++)
+      {
+      for (int row = current[r].top(); row <= current[r].bottom() && row < numRows; row++)
         {
-        vtkOutEdgeType e = it->Next();
-        vtkIdType geneVertex = e.Target;
-        vtkStdString geneName = valueArray->GetValue(geneVertex);
-        vtkIdType row = this->GeneToTableRow[geneName];
-        QModelIndex geneIndex = tableModel->index(row, 0);
-        geneSelection.select(geneIndex, geneIndex);
+        wasSelected[row] = 1;
         }
       }
+    QItemSelection toSelect;
+    QItemSelection toDeselect;
+    CellLineageSelectRowRuns(this->GeneModel, selected, wasSelected, toSelect);
+    CellLineageSelectRowRuns(this->GeneModel, wasSelected, selected, toDeselect);
+
     this->SelectingGenesFromCells = true;
-    this->ui->geneTableView->selectionModel()->select(geneSelection, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    if (!toDeselect.isEmpty())
+      {
+      selectionModel->select(toDeselect, QItemSelectionModel::Deselect | QItemSelectionModel::Rows);
+      }
+    if (!toSelect.isEmpty())
+      {
+      selectionModel->select(toSelect, QItemSelectionModel::Select | QItemSelectionModel::Rows);
+      }
     this->SelectingGenesFromCells = false;
     }
 }
@@ -555,19 +645,29 @@ void CellLineage::slotSelectGenesFromCells(vtkObject*, unsigned long, void*, voi
 // Action to be taken upon lineage file open
 void CellLineage::slotOpenLineageData()
 {
-  // Browse for and read the lineage data
+  // Browse for and read the lineage data, a progressive read shows it
+  // once its first generations are read
   if (this->readLineageData())
     {
     return;
     }
+  this->showLineage();
+}
 
+// Show the lineage in the views
+void CellLineage::showLineage()
+{
   // Set up the lineage view of this data
   this->LineageView->AddRepresentationFromInputConnection(
-    this->LineageReader->GetOutputPort());
+    this->LineageSource->GetOutputPort());
   this->QtTreeView->AddRepresentationFromInputConnection(
-    this->LineageReader->GetOutputPort());
+    this->LineageSource->GetOutputPort());
   this->QtTreeView->Update();
 
+  // Collapsed nodes show how many cells they hide
+  this->LineageView->SetCollapsedColorFieldName("DescendantCount");
+  this->LineageView->SetCollapsedSizeFieldName("LeafCount");
+
   // Set up the text view of the lineage data
   this->setUpLineageListView();
 
@@ -580,12 +680,257 @@ void CellLineage::slotOpenLineageData()
     this, SLOT(slotSelectionChanged()));
 }
 
+void CellLineage::slotLineageBatchLoaded()
+{
+  // Take the tree from the reader, leaving the loader nothing shared with
+  // the views: the next read initializes its output on the loader thread,
+  // and reference counts are not thread safe.
+  vtkTree* batch = this->LineageReader->GetOutput();
+  bool first = this->LoadedGeneration < 0;
+  if (batch->GetNumberOfVertices() == 0)
+    {
+    this->statusBar()->showMessage("Could not read the lineage");
+    this->ui->actionOpenLineageFile->setEnabled(true);
+    this->setGeneActionsEnabled(true);
+    return;
+    }
+  this->Lineage->ShallowCopy(batch);
+  this->Lineage->Modified();
+  batch->Initialize();
+  this->LoadedGeneration = this->LineageReader->GetMaximumGeneration();
+
+  // Selections and collapsed cells are kept by pedigree id, which is the
+  // same for a cell in every batch
+  if (first)
+    {
+    this->showLineage();
+    }
+  else
+    {
+    this->LineageView->Render();
+    }
+
+  if (this->LineageReader->GetTruncated())
+    {
+    this->statusBar()->showMessage(
+      QString("Loading lineage, %1 generations shown...").arg(this->LoadedGeneration + 1));
+    this->LineageReader->SetMaximumGeneration(this->LoadedGeneration + this->GenerationStep);
+    this->GenerationStep *= 2;
+    this->LineageReader->Modified();
+    this->LineageLoader->start();
+    return;
+    }
+
+  // Expanding every row of a large tree takes long, the text view of the
+  // whole lineage is left collapsed
+  this->QtTreeView->Update();
+  this->QtTreeView->ResizeColumnToContents(0);
+  this->statusBar()->showMessage(
+    QString("Lineage loaded, %1 cells").arg(this->Lineage->GetNumberOfVertices()));
+  this->ui->actionOpenLineageFile->setEnabled(true);
+  this->setGeneActionsEnabled(true);
+}
+
 void CellLineage::slotSetDistanceByTime(int state)
 {
   this->LineageView->SetDistanceArrayName(state ? "EndTime" : NULL);
   this->LineageView->Render();
 }
 
+void CellLineage::slotCollapseGeneration()
+{
+  bool ok;
+  int generation = QInputDialog::getInteger(this, "Collapse Below Generation",
+    "Generation:", 5, 0, 100000, 1, &ok);
+  if (ok)
+    {
+    this->LineageView->CollapseGeneration(generation);
+    this->LineageView->Render();
+    }
+}
+
+void CellLineage::slotCollapseAfterTime()
+{
+  bool ok;
+  double time = QInputDialog::getDouble(this, "Collapse After Time",
+    "Time:", this->globalTime, -1e9, 1e9, 2, &ok);
+  if (ok)
+    {
+    this->LineageView->CollapseAfterTime(time);
+    this->LineageView->Render();
+    }
+}
+
+void CellLineage::slotExpandAll()
+{
+  this->LineageView->ExpandAll();
+  this->LineageView->Render();
+}
+
+void CellLineage::slotSelectDescendants()
+{
+  this->LineageView->SelectRelatives(vtkLineageView::SELECT_DESCENDANTS);
+}
+
+void CellLineage::slotSelectAncestors()
+{
+  this->LineageView->SelectRelatives(vtkLineageView::SELECT_ANCESTORS);
+}
+
+void CellLineage::slotSelectSiblings()
+{
+  this->LineageView->SelectRelatives(vtkLineageView::SELECT_SIBLINGS);
+}
+
+void CellLineage::slotSelectSameGeneration()
+{
+  this->LineageView->SelectRelatives(vtkLineageView::SELECT_GENERATION);
+}
+
+void CellLineage::slotSelectGeneration()
+{
+  bool ok;
+  int generation = QInputDialog::getInteger(this, "Select Generation",
+    "Generation:", 0, 0, 100000, 1, &ok);
+  if (ok)
+    {
+    this->LineageView->SelectGeneration(generation);
+    }
+}
+
+void CellLineage::slotColorByGeneCount()
+{
+  this->LineageView->SetVertexColorFieldName("GeneCount");
+  this->LineageView->Render();
+}
+
+void CellLineage::slotColorByOnsetCount()
+{
+  this->LineageView->SetVertexColorFieldName("OnsetCount");
+  this->LineageView->Render();
+}
+
+void CellLineage::slotColorBySubtreeOnsetCount()
+{
+  this->LineageView->SetVertexColorFieldName("SubtreeOnsetCount");
+  this->LineageView->Render();
+}
+
+void CellLineage::slotColorBySelectedGene()
+{
+  QModelIndex current = this->ui->geneTableView->currentIndex();
+  if (!current.isValid())
+    {
+    this->statusBar()->showMessage("No gene selected");
+    return;
+    }
+  vtkIdType gene = this->GeneModel->geneOfRow(current.row());
+  vtkUnsignedCharArray* state = this->OnsetAnalysis->GetGeneState(gene);
+  if (!state)
+    {
+    return;
+    }
+
+  // The state array is shared by all genes, replacing the previous one
+  vtkTree* tree = this->Lineage;
+  tree->GetVertexData()->AddArray(state);
+  tree->Modified();
+  this->statusBar()->showMessage(
+    QString("Coloring by %1").arg(this->GeneIndex->GetGeneNames()->GetValue(gene).c_str()));
+  this->LineageView->SetVertexColorFieldName("GeneExpressionState");
+  this->LineageView->Render();
+}
+
+void CellLineage::slotColorByGeneLevel()
+{
+  QModelIndex current = this->ui->geneTableView->currentIndex();
+  if (!current.isValid())
+    {
+    this->statusBar()->showMessage("No gene selected");
+    return;
+    }
+  vtkIdType gene = this->GeneModel->geneOfRow(current.row());
+  this->GeneIndex->GetGeneLevels(gene, this->GeneLevels);
+  vtkTree* tree = this->Lineage;
+  tree->GetVertexData()->AddArray(this->GeneLevels);
+  this->GeneLevels->Modified();
+  tree->Modified();
+
+  // A few very high levels should not flatten all the others. Most cells
+  // do not express the gene, so the percentile is of the expressed ones.
+  this->LineageView->SetVertexColorPercentiles(0.0, 0.99);
+  this->LineageView->VertexColorPercentilesSkipZerosOn();
+  this->LineageView->SetVertexColorFieldName("GeneLevel");
+  this->LineageView->SetVertexColorPercentiles(0.0, 1.0);
+  this->LineageView->VertexColorPercentilesSkipZerosOff();
+  this->LineageView->Render();
+}
+
+void CellLineage::slotCurrentGeneChanged()
+{
+  this->slotShowSimilarGenes();
+  if (this->GeneIndex->HasLevels())
+    {
+    this->slotColorByGeneLevel();
+    }
+}
+
+void CellLineage::slotPrecomputeSimilarGenes()
+{
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+  this->statusBar()->showMessage("Comparing all genes...");
+  int ok = this->Coexpression->Precompute();
+  QApplication::restoreOverrideCursor();
+  this->statusBar()->showMessage(ok ? "Similar genes found" : "Could not compare genes");
+  this->slotShowSimilarGenes();
+}
+
+void CellLineage::slotSetCosineSimilarity(bool on)
+{
+  this->Coexpression->SetMetric(
+    on ? vtkGeneCoexpression::COSINE : vtkGeneCoexpression::JACCARD);
+  this->slotShowSimilarGenes();
+}
+
+void CellLineage::slotShowSimilarGenes()
+{
+  this->ui->similarGenesListWidget->clear();
+  QModelIndex current = this->ui->geneTableView->currentIndex();
+  if (!current.isValid())
+    {
+    return;
+    }
+  vtkSmartPointer<vtkIdTypeArray> genes =
+    vtkSmartPointer<vtkIdTypeArray>::New();
+  vtkSmartPointer<vtkDoubleArray> similarities =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  this->Coexpression->GetNeighbors(this->GeneModel->geneOfRow(current.row()),
+    genes, similarities);
+  vtkStringArray* names = this->GeneIndex->GetGeneNames();
+  for (vtkIdType i = 0; i < genes->GetNumberOfTuples(); ++i)
+    {
+    QListWidgetItem* item = new QListWidgetItem(
+      QString("%1 (%2)").arg(names->GetValue(genes->GetValue(i)).c_str())
+        .arg(similarities->GetValue(i), 0, 'f', 3),
+      this->ui->similarGenesListWidget);
+    item->setData(Qt::UserRole, static_cast<qlonglong>(genes->GetValue(i)));
+    }
+}
+
+void CellLineage::slotSimilarGeneActivated(QListWidgetItem* item)
+{
+  int gene = static_cast<int>(item->data(Qt::UserRole).toLongLong());
+
+  // The gene may be hidden by the search text
+  if (this->GeneModel->rowOfGene(gene) < 0)
+    {
+    this->ui->geneSearchLineEdit->clear();
+    }
+  int row = this->GeneModel->rowOfGene(gene);
+  this->ui->geneTableView->selectRow(row);
+  this->ui->geneTableView->scrollTo(this->GeneModel->index(row, 0));
+}
+
 void CellLineage::slotSetElbow(int state)
 {
   this->LineageView->SetElbow(state?1:0);
@@ -598,11 +943,30 @@ void CellLineage::slotSetElbowAngle(int value)
   this->LineageView->Render();
 }
 
+void CellLineage::slotSetCurve(int state)
+{
+  this->LineageView->SetCurve(state?1:0);
+  this->LineageView->Render();
+}
+
 void CellLineage::slotSelectionChanged()
 {
   this->LineageView->Render();
 }
 
+void CellLineage::setGeneActionsEnabled(bool enabled)
+{
+  this->ui->actionOpenGeneData->setEnabled(enabled);
+  this->ui->geneWidget->setEnabled(enabled);
+  this->ui->actionColorByGeneCount->setEnabled(enabled);
+  this->ui->actionColorByOnsetCount->setEnabled(enabled);
+  this->ui->actionColorBySubtreeOnsetCount->setEnabled(enabled);
+  this->ui->actionColorBySelectedGene->setEnabled(enabled);
+  this->ui->actionColorByGeneLevel->setEnabled(enabled);
+  this->ui->actionPrecomputeSimilarGenes->setEnabled(enabled);
+  this->ui->actionCosineSimilarity->setEnabled(enabled);
+}
+
 // Set up the lineage list view of the data
 void CellLineage::setUpLineageListView()
 {
@@ -623,16 +987,46 @@ int CellLineage::readLineageData()
     this,
     "Select the lineage tree file",
     QDir::homePath(),
-    "VTK Tree Files (*.vtk);;All Files (*.*)");
+    "Lineage Files (*.vtk *.lin);;Tracking Tables (*.csv);;All Files (*.*)");
 
   if (fileName.isNull())
     {
     return -1;
     }
 
-  // Create lineage reader
+  // Read the lineage, legacy VTK tree files, tracking tables and binary
+  // lineage files written by LineageToBinary alike
   this->LineageReader->SetFileName( fileName.toAscii() );
+  if (this->ui->actionOpenProgressively->isChecked())
+    {
+    // Read the first generations on the loader thread, the deeper ones
+    // follow in batches. Gene data is only indexed on the whole lineage,
+    // the index of the previous one is dropped rather than applied to
+    // partial trees numbered differently.
+    this->ui->actionOpenLineageFile->setEnabled(false);
+    this->setGeneActionsEnabled(false);
+    this->GeneIndex->Initialize();
+    this->Coexpression->Update(this->GeneIndex);
+    this->Coexpression->SetCacheFileName(0);
+    this->ui->similarGenesListWidget->clear();
+    this->GeneModel->setIndex(this->GeneIndex, 0);
+    this->statusBar()->showMessage("Loading lineage...");
+    this->LoadedGeneration = -1;
+    this->GenerationStep = CELL_LINEAGE_GENERATION_STEP;
+    this->LineageReader->SetMaximumGeneration(CELL_LINEAGE_FIRST_GENERATIONS - 1);
+    // The same file and generations as before must still be read again.
+    this->LineageReader->Modified();
+    this->LineageLoader->start();
+    return 1;
+    }
+  // The output is emptied once taken, as for a progressive read, so the
+  // reader must run again even for the same file.
+  this->LineageReader->SetMaximumGeneration(-1);
+  this->LineageReader->Modified();
   this->LineageReader->Update();
+  this->Lineage->ShallowCopy(this->LineageReader->GetOutput());
+  this->Lineage->Modified();
+  this->LineageReader->GetOutput()->Initialize();
   return 0;
 }
 
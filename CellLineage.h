@@ -12,30 +12,39 @@
 #include "vtkSmartPointer.h"    // Required for smart pointer internal ivars.
 #include "vtkStdString.h"
 
-#include <vtksys/stl/map>
-using vtksys_stl::map;
-
 // Forward Qt class declarations
 class Ui_CellLineage;
+class QGeneTableModel;
+class QListWidgetItem;
 class vtkObject;
 class vtkQtTreeView;
 class vtkTreeToQtModelAdapter;
 
 // Forward VTK class declarations
 class vtkAnnotationLink;
+class vtkCellGeneIndex;
 class vtkCommand;
 class vtkDataRepresentation;
 class vtkEventQtSlotConnect;
-class vtkGraph;
+class vtkFloatArray;
+class vtkGeneCoexpression;
+class vtkGeneOnsetAnalysis;
+class vtkGeneQuery;
+class vtkIdTypeArray;
+class vtkLineageTreeReader;
 class vtkLineageView;
 class vtkTable;
-class vtkTreeReader;
+class vtkTree;
+class vtkTrivialProducer;
 class vtkVolumeViewer;
 class vtkXMLImageDataReader;
 
 // The view updater
 class CellLineageUpdater;
 
+// The lineage reading thread
+class CellLineageLoader;
+
 class CellLineage : public QMainWindow
 {
   Q_OBJECT
@@ -94,10 +103,43 @@ public slots:
   // Set the elbow angle
   void slotSetElbowAngle(int value);
 
+  // Description:
+  // Set when curved edges are turned on
+  void slotSetCurve(int state);
+
   // Description:
   // Set when distance by time is turned on
   void slotSetDistanceByTime(int state);
 
+  // Description:
+  // Bulk collapse and expand of the lineage tree
+  void slotCollapseGeneration();
+  void slotCollapseAfterTime();
+  void slotExpandAll();
+
+  // Description:
+  // Extend the selection to the relatives of the selected cells
+  void slotSelectDescendants();
+  void slotSelectAncestors();
+  void slotSelectSiblings();
+  void slotSelectSameGeneration();
+  void slotSelectGeneration();
+
+  // Description:
+  // Color the lineage by the number of genes expressed, switched on, or
+  // switched on for a whole subtree at each cell, or by the state of each
+  // cell for the current gene
+  void slotColorByGeneCount();
+  void slotColorByOnsetCount();
+  void slotColorBySubtreeOnsetCount();
+  void slotColorBySelectedGene();
+  void slotColorByGeneLevel();
+
+  // Description:
+  // Find the genes most similar to every gene, and choose the similarity
+  void slotPrecomputeSimilarGenes();
+  void slotSetCosineSimilarity(bool on);
+
 protected:
 
 protected slots:
@@ -118,10 +160,31 @@ protected slots:
   // The gene selection changed
   void slotGeneSelectionChanged();
 
+  // Description:
+  // Select the cells matching the gene query
+  void slotGeneQuery();
+
+  // Description:
+  // Show the similar genes of the new current gene, and color the lineage
+  // by its expression levels if the gene data has levels
+  void slotCurrentGeneChanged();
+
+  // Description:
+  // List the genes expressed in cells similar to those of the current gene
+  void slotShowSimilarGenes();
+
+  // Description:
+  // Make a listed similar gene the current gene
+  void slotSimilarGeneActivated(QListWidgetItem* item);
+
   // Description:
   // Select genes expressed in cells
   void slotSelectGenesFromCells(vtkObject*, unsigned long, void*, void*);
 
+  // Description:
+  // Show the generations the loader thread has read and read the next ones
+  void slotLineageBatchLoaded();
+
   // Description:
   // VCR slots
   void slotVCRPlay();
@@ -135,9 +198,13 @@ private:
 
   // Methods
 
-  // Description: Browse for and read the Lineage data
+  // Description: Browse for and read the Lineage data, or start reading
+  // it by generations on the loader thread
   int readLineageData();
 
+  // Description: Show the lineage read in the views
+  void showLineage();
+
   // Description: Browse for and read the volume data
   int readVolumeData();
 
@@ -147,8 +214,20 @@ private:
   // Description: Set up the Lineage list view of the data
   void setUpLineageListView();
 
+  // Description: Select cells, given by pedigree id, in all views
+  void selectCells(vtkIdTypeArray* cellIds);
+
+  // Description: Enable or disable opening gene data, the gene panel and
+  // the actions using the gene index
+  void setGeneActionsEnabled(bool enabled);
+
   // Members
-  vtkTreeReader*           LineageReader;
+  vtkLineageTreeReader*    LineageReader;
+  vtkTree*                 Lineage;
+  vtkTrivialProducer*      LineageSource;
+  CellLineageLoader*       LineageLoader;
+  int                      LoadedGeneration;
+  int                      GenerationStep;
   vtkLineageView*          LineageView;
   vtkDataRepresentation*   LineageViewRep;
   vtkXMLImageDataReader*   VolumeReader;
@@ -157,18 +236,17 @@ private:
   vtkDataRepresentation*   QtTreeViewRep;
   vtkAnnotationLink*       AnnotationLink;
   QString volumeDataDir;
-  vtkTable* GeneTable;
-  vtkGraph* GeneGraph;
+  vtkCellGeneIndex* GeneIndex;
+  vtkGeneQuery* GeneQuery;
+  vtkGeneOnsetAnalysis* OnsetAnalysis;
+  vtkGeneCoexpression* Coexpression;
+  vtkFloatArray* GeneLevels;
+  QGeneTableModel* GeneModel;
   bool SelectingGenesFromCells;
   bool SelectingCellsFromGenes;
   CellLineageUpdater* Updater;
   vtkEventQtSlotConnect* Connect;
 
-  map<vtkStdString, vtkIdType> CellToVertex;
-  map<vtkStdString, vtkIdType> GeneToVertex;
-  map<vtkStdString, vtkIdType> CellToTreePedigree;
-  map<vtkStdString, vtkIdType> GeneToTableRow;
-
   // Designer form
   Ui_CellLineage *ui;
 
@@ -0,0 +1,50 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkLineageTreeReader.h"
+#include "vtkLineageTreeWriter.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+#include "vtkTree.h"
+
+// Converts a lineage tree to the binary lineage format that CellLineage
+// opens without parsing. The input is a legacy VTK tree file, a cell
+// tracking table, or a binary lineage file to be rewritten.
+//
+// Usage: LineageToBinary lineage.vtk lineage.lin
+
+int main( int argc, char** argv )
+{
+  if (argc != 3)
+    {
+    cerr << "Usage: LineageToBinary lineage.vtk lineage.lin" << endl;
+    return 1;
+    }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  timer->StartTimer();
+  vtkSmartPointer<vtkLineageTreeReader> reader = vtkSmartPointer<vtkLineageTreeReader>::New();
+  reader->SetFileName(argv[1]);
+  reader->Update();
+  vtkTree* tree = reader->GetOutput();
+  if (!tree || tree->GetNumberOfVertices() == 0)
+    {
+    cerr << "Could not read a tree from " << argv[1] << endl;
+    return 1;
+    }
+  timer->StopTimer();
+  cout << "Read " << tree->GetNumberOfVertices() << " vertices in "
+       << timer->GetElapsedTime() << " s" << endl;
+
+  timer->StartTimer();
+  vtkSmartPointer<vtkLineageTreeWriter> writer = vtkSmartPointer<vtkLineageTreeWriter>::New();
+  writer->SetInput(tree);
+  writer->SetFileName(argv[2]);
+  if (!writer->Write())
+    {
+    return 1;
+    }
+  timer->StopTimer();
+  cout << "Wrote " << argv[2] << " in " << timer->GetElapsedTime() << " s" << endl;
+  return 0;
+}
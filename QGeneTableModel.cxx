@@ -0,0 +1,203 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "QGeneTableModel.h"
+
+#include <vtkCellGeneIndex.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkStringArray.h>
+
+//-----------------------------------------------------------------------------
+
+QGeneTableModel::QGeneTableModel(QObject *p)
+  : QAbstractTableModel(p)
+{
+  this->onsets = vtkSmartPointer<vtkDoubleArray>::New();
+  this->first = 0;
+  this->last = 0;
+}
+
+QGeneTableModel::~QGeneTableModel()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void QGeneTableModel::setIndex(vtkCellGeneIndex *idx, vtkDataArray *startTimes)
+{
+  this->setRange(0, 0);
+  this->geneIndex = idx;
+  int numGenes = idx ? static_cast<int>(idx->GetNumberOfGenes()) : 0;
+  this->cellCounts.resize(numGenes);
+  for (int g = 0; g < numGenes; g++)
+    {
+    this->cellCounts[g] = static_cast<int>(idx->GetNumberOfCellsOfGene(g));
+    }
+  this->onsets->Initialize();
+  if (idx)
+    {
+    idx->GetGeneMinimum(startTimes, this->onsets);
+    }
+  this->_prefix = QString();
+  this->setRange(0, numGenes);
+}
+
+int QGeneTableModel::geneOfRow(int row) const
+{
+  return (row >= 0 && row < this->last - this->first) ? this->first + row : -1;
+}
+
+int QGeneTableModel::rowOfGene(int gene) const
+{
+  return (gene >= this->first && gene < this->last) ? gene - this->first : -1;
+}
+
+//-----------------------------------------------------------------------------
+
+void QGeneTableModel::setPrefix(const QString &prefix)
+{
+  this->_prefix = prefix;
+  int a, b;
+  this->prefixRange(prefix.toStdString(), a, b);
+  this->setRange(a, b);
+}
+
+void QGeneTableModel::prefixRange(const std::string &prefix, int &a, int &b) const
+{
+  vtkStringArray *names = this->geneIndex ? this->geneIndex->GetGeneNames() : NULL;
+  int numGenes = names ? static_cast<int>(names->GetNumberOfTuples()) : 0;
+
+  // Names starting with prefix follow those less than prefix.
+  int lo = 0;
+  int hi = numGenes;
+  while (lo < hi)
+    {
+    int mid = (lo + hi) / 2;
+    if (names->GetValue(mid) < prefix)
+      {
+      lo = mid + 1;
+      }
+    else
+      {
+      hi = mid;
+      }
+    }
+  a = lo;
+  hi = numGenes;
+  while (lo < hi)
+    {
+    int mid = (lo + hi) / 2;
+    if (names->GetValue(mid).compare(0, prefix.size(), prefix) == 0)
+      {
+      lo = mid + 1;
+      }
+    else
+      {
+      hi = mid;
+      }
+    }
+  b = lo;
+}
+
+void QGeneTableModel::setRange(int a, int b)
+{
+  if (a >= b || b <= this->first || a >= this->last)
+    {
+    // Nothing in common, replace all rows.
+    if (this->last > this->first)
+      {
+      this->beginRemoveRows(QModelIndex(), 0, this->last - this->first - 1);
+      this->first = this->last = 0;
+      this->endRemoveRows();
+      }
+    if (b > a)
+      {
+      this->beginInsertRows(QModelIndex(), 0, b - a - 1);
+      this->first = a;
+      this->last = b;
+      this->endInsertRows();
+      }
+    return;
+    }
+
+  if (a > this->first)
+    {
+    this->beginRemoveRows(QModelIndex(), 0, a - this->first - 1);
+    this->first = a;
+    this->endRemoveRows();
+    }
+  else if (a < this->first)
+    {
+    this->beginInsertRows(QModelIndex(), 0, this->first - a - 1);
+    this->first = a;
+    this->endInsertRows();
+    }
+  if (b < this->last)
+    {
+    this->beginRemoveRows(QModelIndex(), b - this->first, this->last - this->first - 1);
+    this->last = b;
+    this->endRemoveRows();
+    }
+  else if (b > this->last)
+    {
+    this->beginInsertRows(QModelIndex(), this->last - this->first, b - this->first - 1);
+    this->last = b;
+    this->endInsertRows();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int QGeneTableModel::rowCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : this->last - this->first;
+}
+
+int QGeneTableModel::columnCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : NumberOfColumns;
+}
+
+QVariant QGeneTableModel::data(const QModelIndex &idx, int role) const
+{
+  int gene = this->geneOfRow(idx.row());
+  if (role != Qt::DisplayRole || gene < 0)
+    {
+    return QVariant();
+    }
+  switch (idx.column())
+    {
+    case NameColumn:
+      return QString(this->geneIndex->GetGeneNames()->GetValue(gene).c_str());
+    case CellCountColumn:
+      return this->cellCounts[gene];
+    case OnsetColumn:
+      if (gene < this->onsets->GetNumberOfTuples() &&
+          this->onsets->GetValue(gene) != VTK_DOUBLE_MAX)
+        {
+        return this->onsets->GetValue(gene);
+        }
+      break;
+    }
+  return QVariant();
+}
+
+QVariant QGeneTableModel::headerData(int section, Qt::Orientation orientation,
+                                     int role) const
+{
+  if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+    {
+    return QAbstractTableModel::headerData(section, orientation, role);
+    }
+  switch (section)
+    {
+    case NameColumn:
+      return QString("Gene");
+    case CellCountColumn:
+      return QString("Cells");
+    case OnsetColumn:
+      return QString("Onset");
+    }
+  return QVariant();
+}
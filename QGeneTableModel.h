@@ -0,0 +1,91 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#ifndef _QGeneTableModel_h
+#define _QGeneTableModel_h
+
+#include <QAbstractTableModel>
+
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+class vtkCellGeneIndex;
+class vtkDataArray;
+class vtkDoubleArray;
+
+// .SECTION Name QGeneTableModel
+//
+// .SECTION Description
+// This class presents the genes of a vtkCellGeneIndex to Qt views without
+// creating any item per gene: the name, number of expressing cells and
+// onset time (earliest start time of an expressing cell) of gene g are
+// read from arrays when a view asks for them.
+//
+// The genes shown can be narrowed to those whose name starts with a prefix.
+// The gene names of the index are sorted, so the matching genes are one
+// contiguous range of gene ids found by binary search. Changing the prefix
+// only inserts or removes rows at both ends of the range and never resets
+// the model, so views keep their selection and scroll position. Prefix
+// matching is case sensitive.
+
+class QGeneTableModel : public QAbstractTableModel
+{
+  Q_OBJECT;
+
+public:
+  enum Column
+    {
+    NameColumn,
+    CellCountColumn,
+    OnsetColumn,
+    NumberOfColumns
+    };
+
+  QGeneTableModel(QObject *parent = NULL);
+  virtual ~QGeneTableModel();
+
+  /// Show the genes of index. Cell counts and onset times are computed
+  /// here, from the start time of every cell (may be NULL).
+  void setIndex(vtkCellGeneIndex *index, vtkDataArray *startTimes);
+
+  /// The gene id shown in a row, -1 if there is no such row.
+  int geneOfRow(int row) const;
+
+  /// The row showing a gene id, -1 if it is filtered out.
+  int rowOfGene(int gene) const;
+
+  /// See setPrefix.
+  inline const QString &prefix() const { return this->_prefix; }
+
+  virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+  virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+  virtual QVariant headerData(int section, Qt::Orientation orientation,
+                              int role = Qt::DisplayRole) const;
+
+public slots:
+  /// Only show the genes whose name starts with prefix.
+  void setPrefix(const QString &prefix);
+
+protected:
+  /// The range [first, last) of gene ids whose name starts with prefix.
+  void prefixRange(const std::string &prefix, int &first, int &last) const;
+
+  /// Move the shown range of gene ids to [first, last), inserting and
+  /// removing rows at its ends.
+  void setRange(int first, int last);
+
+private:
+  QGeneTableModel(const QGeneTableModel &);   // Not implemented
+  void operator=(const QGeneTableModel &);     // Not implemented
+
+  vtkSmartPointer<vtkCellGeneIndex> geneIndex;
+  std::vector<int> cellCounts;
+  vtkSmartPointer<vtkDoubleArray> onsets;
+  QString _prefix;
+  int first;
+  int last;
+};
+
+#endif //_QGeneTableModel_h
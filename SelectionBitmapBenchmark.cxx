@@ -0,0 +1,122 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkIdTypeArray.h"
+#include "vtkMath.h"
+#include "vtkSelection.h"
+#include "vtkSelectionBitmap.h"
+#include "vtkSelectionNode.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+
+#include <stdlib.h>
+
+// Times repeated union selections, as done by rubber band selections with
+// the union modifier, through vtkSelection::Union on id lists and through
+// vtkSelectionBitmap, converting back to a vtkSelection after every union.
+//
+// Usage: SelectionBitmapBenchmark [numberOfIds] [idsPerSelection] [selections]
+
+static vtkIdTypeArray* RandomIds(vtkIdType count, vtkIdType range)
+{
+  vtkIdTypeArray* ids = vtkIdTypeArray::New();
+  ids->SetNumberOfValues(count);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    ids->SetValue(i, static_cast<vtkIdType>(vtkMath::Random(0, range)));
+    }
+  return ids;
+}
+
+int main( int argc, char** argv )
+{
+  vtkIdType range = argc > 1 ? atoi(argv[1]) : 500000;
+  vtkIdType perSelection = argc > 2 ? atoi(argv[2]) : 20000;
+  int numSelections = argc > 3 ? atoi(argv[3]) : 50;
+  if (range <= 0 || perSelection <= 0 || numSelections <= 0)
+    {
+    cerr << "Usage: SelectionBitmapBenchmark [numberOfIds] [idsPerSelection] [selections]" << endl;
+    return 1;
+    }
+
+  vtkMath::RandomSeed(1234);
+  vtkIdTypeArray** selections = new vtkIdTypeArray*[numSelections];
+  for (int s = 0; s < numSelections; ++s)
+    {
+    selections[s] = RandomIds(perSelection, range);
+    }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+
+  // Current path: a new selection unioned with the previous one.
+  timer->StartTimer();
+  vtkSmartPointer<vtkSelection> current = vtkSmartPointer<vtkSelection>::New();
+  for (int s = 0; s < numSelections; ++s)
+    {
+    vtkSmartPointer<vtkSelection> selection = vtkSmartPointer<vtkSelection>::New();
+    vtkSmartPointer<vtkSelectionNode> node = vtkSmartPointer<vtkSelectionNode>::New();
+    node->SetContentType(vtkSelectionNode::INDICES);
+    node->SetFieldType(vtkSelectionNode::VERTEX);
+    node->SetSelectionList(selections[s]);
+    selection->AddNode(node);
+    if (s > 0)
+      {
+      selection->Union(current);
+      }
+    current = selection;
+    }
+  timer->StopTimer();
+  vtkIdTypeArray* listIds =
+    vtkIdTypeArray::SafeDownCast(current->GetNode(0)->GetSelectionList());
+  cout << "vtkSelection::Union:  " << timer->GetElapsedTime() << " s, "
+       << listIds->GetNumberOfTuples() << " ids" << endl;
+
+  // Bitmap path, converted to a selection after every union.
+  timer->StartTimer();
+  vtkSmartPointer<vtkSelectionBitmap> bitmap = vtkSmartPointer<vtkSelectionBitmap>::New();
+  vtkSmartPointer<vtkSelection> converted = vtkSmartPointer<vtkSelection>::New();
+  for (int s = 0; s < numSelections; ++s)
+    {
+    bitmap->AddIds(selections[s]);
+    bitmap->GetSelection(converted, vtkSelectionNode::VERTEX);
+    }
+  timer->StopTimer();
+  cout << "vtkSelectionBitmap:   " << timer->GetElapsedTime() << " s, "
+       << bitmap->GetNumberOfIds() << " ids" << endl;
+
+  // Set operations between two bitmaps alone.
+  vtkSmartPointer<vtkSelectionBitmap> other = vtkSmartPointer<vtkSelectionBitmap>::New();
+  other->AddIds(selections[0]);
+  const char* names[3] = { "Union", "Intersect", "Subtract" };
+  for (int op = 0; op < 3; ++op)
+    {
+    vtkSmartPointer<vtkSelectionBitmap> result = vtkSmartPointer<vtkSelectionBitmap>::New();
+    timer->StartTimer();
+    for (int s = 0; s < numSelections; ++s)
+      {
+      result->DeepCopy(bitmap);
+      if (op == 0)
+        {
+        result->Union(other);
+        }
+      else if (op == 1)
+        {
+        result->Intersect(other);
+        }
+      else
+        {
+        result->Subtract(other);
+        }
+      }
+    timer->StopTimer();
+    cout << "vtkSelectionBitmap::" << names[op] << ": "
+         << timer->GetElapsedTime() / numSelections << " s" << endl;
+    }
+
+  for (int s = 0; s < numSelections; ++s)
+    {
+    selections[s]->Delete();
+    }
+  delete [] selections;
+  return 0;
+}
@@ -1,12 +1,19 @@
 // Copyright 2009 Sandia Corporation, Kitware Inc.
 // See LICENSE.txt for details.
 
-#include "vtkAbstractArray.h"
-#include "vtkDelimitedTextReader.h"
+#include "vtkGeneAdjacencyHeader.h"
+#include "vtkMultiThreader.h"
 #include "vtkSmartPointer.h"
-#include "vtkStdString.h"
-#include "vtkTable.h"
-#include "vtkVariant.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/map>
+#include <vtksys/stl/string>
+#include <vtksys/stl/vector>
 
 // Converts file of the form
 // Cell Name,gene1,gene2,gene3,...,geneN
@@ -22,34 +29,894 @@
 // cell2,gene3
 // ...
 // cellM,geneN
+//
+// The file is streamed through a fixed size buffer, so memory does not
+// grow with the number of rows, only with the length of the longest row
+// and the number of genes. With -j, every buffer is split at line
+// boundaries among that many threads, and their output is written in
+// input order.
+//
+// Sparse matrices are read as well, given the names of their cells (-c)
+// and genes (-g), one per line, of which only the text up to the first
+// tab is kept:
+//
+// - Matrix Market coordinate files, "%%MatrixMarket matrix coordinate
+//   real|integer|pattern general" banner, % comments, a "rows columns
+//   entries" line, then one "row column [value]" line per entry,
+//   numbered from 1;
+// - triplet files, one "row,column[,value]" line per entry numbered from
+//   0, separated by commas, tabs or spaces, after an optional header.
+//
+// Rows are cells and columns genes, unless -T is given or the size of a
+// Matrix Market file only matches the names the other way around, as in
+// genes by cells files. An entry without a value is expressed, one with a
+// value is when it is above the threshold given with -t, 0 by default, and
+// one whose value is not a number ("NA", "nan") is skipped. A
+// dense table is read with the same threshold if -t is given, otherwise
+// only entries equal to 1 are expressed.
+//
+// With -b, the pairs are written instead to a binary adjacency file (see
+// vtkGeneAdjacencyHeader.h) that vtkGeneExpressionReader loads without
+// parsing. The pairs are then kept in memory until the end of the input,
+// as two integers per expressed entry.
+
+// Bytes of input parsed per thread at a time.
+#define TABLE_TO_ADJACENCY_LIST_BLOCK (4 << 20)
+
+// Splits off the next comma separated field of a line, without trailing
+// carriage return and surrounding quotes. Returns the start of the next
+// field, or lineEnd.
+static const char* TableToAdjacencyListNextField(const char* p,
+  const char* lineEnd, const char*& fieldBegin, const char*& fieldEnd)
+{
+  const char* end = static_cast<const char*>(memchr(p, ',', lineEnd - p));
+  const char* next = end ? end + 1 : lineEnd;
+  end = end ? end : lineEnd;
+  if (end > p && end[-1] == '\r')
+    {
+    --end;
+    }
+  if (end - p >= 2 && *p == '"' && end[-1] == '"')
+    {
+    ++p;
+    --end;
+    }
+  fieldBegin = p;
+  fieldEnd = end;
+  return next;
+}
+
+// Whether a field holds the integer 1, reading it the way
+// vtkVariant::ToInt did: leading blanks, a sign, then digits up to the
+// first other character.
+static bool TableToAdjacencyListIsOne(const char* begin, const char* end)
+{
+  if (end - begin == 1)
+    {
+    return *begin == '1';
+    }
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    {
+    ++begin;
+    }
+  bool negative = false;
+  if (begin < end && (*begin == '+' || *begin == '-'))
+    {
+    negative = *begin++ == '-';
+    }
+  long value = 0;
+  for (; begin < end && *begin >= '0' && *begin <= '9' && value < 10; ++begin)
+    {
+    value = value * 10 + (*begin - '0');
+    }
+  return !negative && value == 1;
+}
+
+// Reads a decimal number at p, after blanks, and moves p past it. Returns
+// false if there is no number. The number is copied to a terminated buffer
+// for strtod, which rounds it correctly, and NaN is not taken as a number.
+static bool TableToAdjacencyListReadNumber(const char*& p, const char* end,
+  double& value)
+{
+  while (p < end && (*p == ' ' || *p == '\t'))
+    {
+    ++p;
+    }
+  const char* tokenEnd = p;
+  while (tokenEnd < end && *tokenEnd != ',' && *tokenEnd != '\t' &&
+         *tokenEnd != ' ' && *tokenEnd != '\r')
+    {
+    ++tokenEnd;
+    }
+  char buffer[64];
+  size_t length = static_cast<size_t>(tokenEnd - p);
+  if (length == 0 || length >= sizeof(buffer))
+    {
+    return false;
+    }
+  memcpy(buffer, p, length);
+  buffer[length] = 0;
+  char* parsed;
+  double v = strtod(buffer, &parsed);
+  if (parsed == buffer || !(v == v))
+    {
+    return false;
+    }
+  p += parsed - buffer;
+  value = v;
+  return true;
+}
+
+// Reads an unsigned integer at p, after blanks, commas or tabs, and moves
+// p past it. Returns false if there is none.
+static bool TableToAdjacencyListReadId(const char*& p, const char* end,
+  vtkTypeInt64& id)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == ','))
+    {
+    ++p;
+    }
+  const char* begin = p;
+  id = 0;
+  for (; p < end && *p >= '0' && *p <= '9' && id < (static_cast<vtkTypeInt64>(1) << 56); ++p)
+    {
+    id = id * 10 + (*p - '0');
+    }
+  return p > begin;
+}
+
+// Reads one name per line, keeping the text up to the first tab without
+// carriage return or surrounding quotes. Trailing empty lines are dropped.
+static bool TableToAdjacencyListReadNames(const char* fileName,
+  vtksys_stl::vector<vtksys_stl::string>& names)
+{
+  FILE* file = fopen(fileName, "rb");
+  if (!file)
+    {
+    return false;
+    }
+  vtksys_stl::string text;
+  char block[1 << 16];
+  size_t read;
+  while ((read = fread(block, 1, sizeof(block), file)) > 0)
+    {
+    text.append(block, read);
+    }
+  fclose(file);
+  const char* p = text.data();
+  const char* end = p + text.size();
+  while (p < end)
+    {
+    const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+    lineEnd = lineEnd ? lineEnd : end;
+    const char* nameEnd = static_cast<const char*>(memchr(p, '\t', lineEnd - p));
+    nameEnd = nameEnd ? nameEnd : lineEnd;
+    if (nameEnd > p && nameEnd[-1] == '\r')
+      {
+      --nameEnd;
+      }
+    const char* name = p;
+    if (nameEnd - name >= 2 && *name == '"' && nameEnd[-1] == '"')
+      {
+      ++name;
+      --nameEnd;
+      }
+    names.push_back(vtksys_stl::string(name, nameEnd));
+    p = lineEnd + 1;
+    }
+  while (!names.empty() && names.back().empty())
+    {
+    names.pop_back();
+    }
+  return true;
+}
+
+// The rows of the buffer parsed by one thread, and the lines they make.
+// For a binary file, the cell names of the rows and the columns set in
+// them instead: those of row r are RowGenes[RowEnds[r - 1], RowEnds[r]).
+// The entries of a sparse file are kept as pairs of cell and gene ids.
+class TableToAdjacencyListChunk
+{
+public:
+  const char* Begin;
+  const char* End;
+  vtksys_stl::string Output;
+  vtksys_stl::vector<vtksys_stl::string> RowNames;
+  vtksys_stl::vector<vtkIdType> RowEnds;
+  vtksys_stl::vector<vtkIdType> RowGenes;
+  vtksys_stl::vector<vtkIdType> PairCells;
+  vtksys_stl::vector<vtkIdType> PairGenes;
+  vtkIdType NumberOfSkippedLines;
+};
+
+class TableToAdjacencyListParser
+{
+public:
+  enum
+    {
+    DENSE,
+    MATRIX_MARKET,
+    TRIPLETS
+    };
+  enum
+    {
+    HEADER_LINE,
+    HEADER_END,
+    FIRST_ENTRY,
+    HEADER_ERROR
+    };
+
+  int Format;
+  bool Binary;
+  bool Transpose;
+  bool HasThreshold;
+  double Threshold;
+  vtkTypeInt64 NumberOfRows;
+  vtkTypeInt64 NumberOfColumns;
+  vtksys_stl::vector<vtksys_stl::string> Cells;
+  vtksys_stl::vector<vtksys_stl::string> Genes;
+  vtksys_stl::vector<TableToAdjacencyListChunk> Chunks;
+
+  TableToAdjacencyListParser()
+    {
+    this->Format = DENSE;
+    this->Binary = false;
+    this->Transpose = false;
+    this->HasThreshold = false;
+    this->Threshold = 0.0;
+    this->NumberOfRows = -1;
+    this->NumberOfColumns = -1;
+    }
+
+  // Reads a line before the entries: the gene names of a dense table, the
+  // banner, comments and size of a Matrix Market file or the optional
+  // header of a triplet file. FIRST_ENTRY means the line is not part of
+  // the header and is left for Parse.
+  int ParseHeader(const char* line, const char* lineEnd);
+
+  void Parse(TableToAdjacencyListChunk& chunk);
+  void ParseDense(TableToAdjacencyListChunk& chunk);
+  void ParseSparse(TableToAdjacencyListChunk& chunk);
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg)
+    {
+    vtkMultiThreader::ThreadInfo* info =
+      static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    TableToAdjacencyListParser* self =
+      static_cast<TableToAdjacencyListParser*>(info->UserData);
+    self->Parse(self->Chunks[info->ThreadID]);
+    return VTK_THREAD_RETURN_VALUE;
+    }
+};
+
+int TableToAdjacencyListParser::ParseHeader(const char* line, const char* lineEnd)
+{
+  if (this->Format == DENSE)
+    {
+    const char* begin;
+    const char* end;
+    const char* f = TableToAdjacencyListNextField(line, lineEnd, begin, end);
+    while (f < lineEnd)
+      {
+      f = TableToAdjacencyListNextField(f, lineEnd, begin, end);
+      this->Genes.push_back(vtksys_stl::string(begin, end));
+      }
+    return HEADER_END;
+    }
+  vtksys_stl::string text(line, lineEnd);
+  if (this->Format == MATRIX_MARKET)
+    {
+    if (!text.compare(0, 14, "%%MatrixMarket"))
+      {
+      // Only "matrix coordinate real|integer|pattern general" is read,
+      // symmetric matrices would need their mirrored entries and complex
+      // ones have two values per entry.
+      vtksys_stl::vector<vtksys_stl::string> words;
+      vtksys_stl::string::size_type w = 14;
+      while (words.size() < 5)
+        {
+        w = text.find_first_not_of(" \t\r", w);
+        if (w == vtksys_stl::string::npos)
+          {
+          break;
+          }
+        vtksys_stl::string::size_type wordEnd = text.find_first_of(" \t\r", w);
+        words.push_back(text.substr(w, wordEnd - w));
+        for (size_t c = 0; c < words.back().size(); ++c)
+          {
+          words.back()[c] = static_cast<char>(tolower(words.back()[c]));
+          }
+        w = wordEnd;
+        }
+      return words.size() == 4 && words[0] == "matrix" &&
+        words[1] == "coordinate" && (words[2] == "real" ||
+        words[2] == "integer" || words[2] == "pattern") &&
+        words[3] == "general" ? HEADER_LINE : HEADER_ERROR;
+      }
+    const char* p = line;
+    while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r'))
+      {
+      ++p;
+      }
+    if (p == lineEnd || *p == '%')
+      {
+      return HEADER_LINE;
+      }
+    vtkTypeInt64 entries;
+    return TableToAdjacencyListReadId(p, lineEnd, this->NumberOfRows) &&
+      TableToAdjacencyListReadId(p, lineEnd, this->NumberOfColumns) &&
+      TableToAdjacencyListReadId(p, lineEnd, entries) ? HEADER_END : HEADER_ERROR;
+    }
+  const char* p = line;
+  while (p < lineEnd && (*p == ' ' || *p == '\t'))
+    {
+    ++p;
+    }
+  return p < lineEnd && *p >= '0' && *p <= '9' ? FIRST_ENTRY : HEADER_END;
+}
+
+void TableToAdjacencyListParser::Parse(TableToAdjacencyListChunk& chunk)
+{
+  chunk.Output.clear();
+  chunk.RowNames.clear();
+  chunk.RowEnds.clear();
+  chunk.RowGenes.clear();
+  chunk.PairCells.clear();
+  chunk.PairGenes.clear();
+  chunk.NumberOfSkippedLines = 0;
+  if (this->Format == DENSE)
+    {
+    this->ParseDense(chunk);
+    }
+  else
+    {
+    this->ParseSparse(chunk);
+    }
+}
+
+void TableToAdjacencyListParser::ParseSparse(TableToAdjacencyListChunk& chunk)
+{
+  vtkTypeInt64 base = this->Format == MATRIX_MARKET ? 1 : 0;
+  vtkTypeInt64 numCells = static_cast<vtkTypeInt64>(this->Cells.size());
+  vtkTypeInt64 numGenes = static_cast<vtkTypeInt64>(this->Genes.size());
+  const char* p = chunk.Begin;
+  while (p < chunk.End)
+    {
+    const char* lineEnd = static_cast<const char*>(memchr(p, '\n', chunk.End - p));
+    lineEnd = lineEnd ? lineEnd : chunk.End;
+    const char* f = p;
+    p = lineEnd + 1;
+    while (f < lineEnd && (*f == ' ' || *f == '\t' || *f == '\r'))
+      {
+      ++f;
+      }
+    if (f == lineEnd || *f == '%' || *f == '#')
+      {
+      continue;
+      }
+    vtkTypeInt64 row;
+    vtkTypeInt64 column;
+    if (!TableToAdjacencyListReadId(f, lineEnd, row) ||
+        !TableToAdjacencyListReadId(f, lineEnd, column))
+      {
+      ++chunk.NumberOfSkippedLines;
+      continue;
+      }
+    vtkTypeInt64 cell = (this->Transpose ? column : row) - base;
+    vtkTypeInt64 gene = (this->Transpose ? row : column) - base;
+    if (cell < 0 || cell >= numCells || gene < 0 || gene >= numGenes)
+      {
+      ++chunk.NumberOfSkippedLines;
+      continue;
+      }
+    while (f < lineEnd && (*f == ',' || *f == '\t' || *f == ' ' || *f == '\r'))
+      {
+      ++f;
+      }
+    // Only an entry without a value column is expressed as such, values
+    // that are not numbers ("NA", "nan", "-") skip the line.
+    if (f < lineEnd)
+      {
+      double value;
+      if (!TableToAdjacencyListReadNumber(f, lineEnd, value))
+        {
+        ++chunk.NumberOfSkippedLines;
+        continue;
+        }
+      if (!(value > this->Threshold))
+        {
+        continue;
+        }
+      }
+    if (this->Binary)
+      {
+      chunk.PairCells.push_back(static_cast<vtkIdType>(cell));
+      chunk.PairGenes.push_back(static_cast<vtkIdType>(gene));
+      continue;
+      }
+    chunk.Output += this->Cells[cell];
+    chunk.Output += ',';
+    chunk.Output += this->Genes[gene];
+    chunk.Output += '\n';
+    }
+}
+
+void TableToAdjacencyListParser::ParseDense(TableToAdjacencyListChunk& chunk)
+{
+  vtksys_stl::string::size_type numGenes = this->Genes.size();
+  const char* p = chunk.Begin;
+  while (p < chunk.End)
+    {
+    const char* lineEnd = static_cast<const char*>(memchr(p, '\n', chunk.End - p));
+    lineEnd = lineEnd ? lineEnd : chunk.End;
+    const char* cellBegin;
+    const char* cellEnd;
+    const char* f = TableToAdjacencyListNextField(p, lineEnd, cellBegin, cellEnd);
+    if (cellEnd > cellBegin)
+      {
+      if (this->Binary)
+        {
+        chunk.RowNames.push_back(vtksys_stl::string(cellBegin, cellEnd));
+        }
+      const char* begin;
+      const char* end;
+      for (vtksys_stl::string::size_type g = 0; f < lineEnd && g < numGenes; ++g)
+        {
+        f = TableToAdjacencyListNextField(f, lineEnd, begin, end);
+        double value;
+        if (this->HasThreshold ?
+            !(TableToAdjacencyListReadNumber(begin, end, value) && value > this->Threshold) :
+            !TableToAdjacencyListIsOne(begin, end))
+          {
+          continue;
+          }
+        if (this->Binary)
+          {
+          chunk.RowGenes.push_back(static_cast<vtkIdType>(g));
+          continue;
+          }
+        chunk.Output.append(cellBegin, cellEnd - cellBegin);
+        chunk.Output += ',';
+        chunk.Output += this->Genes[g];
+        chunk.Output += '\n';
+        }
+      if (this->Binary)
+        {
+        chunk.RowEnds.push_back(static_cast<vtkIdType>(chunk.RowGenes.size()));
+        }
+      }
+    p = lineEnd + 1;
+    }
+}
+
+// Writes data followed by zeros up to the next multiple of 8 bytes and
+// advances offset past them.
+static bool TableToAdjacencyListWriteSection(FILE* out, const void* data,
+  size_t size, vtkTypeInt64& offset)
+{
+  static const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  size_t padded = (size + 7) & ~static_cast<size_t>(7);
+  bool ok = (size == 0 || fwrite(data, 1, size, out) == size) &&
+    (padded == size || fwrite(padding, 1, padded - size, out) == padded - size);
+  offset += static_cast<vtkTypeInt64>(padded);
+  return ok;
+}
+
+// Offsets and bytes of a table of names, as stored in a binary file.
+static void TableToAdjacencyListPackNames(
+  const vtksys_stl::vector<vtksys_stl::string>& names,
+  vtksys_stl::vector<vtkTypeInt64>& offsets, vtksys_stl::string& bytes)
+{
+  offsets.resize(names.size() + 1);
+  offsets[0] = 0;
+  for (size_t i = 0; i < names.size(); ++i)
+    {
+    bytes += names[i];
+    offsets[i + 1] = static_cast<vtkTypeInt64>(bytes.size());
+    }
+}
+
+// The (cell, column) pairs of the whole file, cells numbered in order of
+// first appearance.
+class TableToAdjacencyListPairs
+{
+public:
+  vtksys_stl::map<vtksys_stl::string, vtkIdType> CellIds;
+  vtksys_stl::vector<vtksys_stl::string> CellNames;
+  vtksys_stl::vector<vtkIdType> Cells;
+  vtksys_stl::vector<vtkIdType> Columns;
+
+  void Add(const TableToAdjacencyListChunk& chunk);
+  void AddPairs(const TableToAdjacencyListChunk& chunk);
+  bool Write(const char* fileName, const vtksys_stl::vector<vtksys_stl::string>& genes);
+};
+
+void TableToAdjacencyListPairs::Add(const TableToAdjacencyListChunk& chunk)
+{
+  vtkIdType begin = 0;
+  for (size_t r = 0; r < chunk.RowNames.size(); ++r)
+    {
+    vtksys_stl::pair<vtksys_stl::map<vtksys_stl::string, vtkIdType>::iterator, bool> it =
+      this->CellIds.insert(vtksys_stl::make_pair(chunk.RowNames[r],
+        static_cast<vtkIdType>(this->CellNames.size())));
+    if (it.second)
+      {
+      this->CellNames.push_back(chunk.RowNames[r]);
+      }
+    for (vtkIdType i = begin; i < chunk.RowEnds[r]; ++i)
+      {
+      this->Cells.push_back(it.first->second);
+      this->Columns.push_back(chunk.RowGenes[i]);
+      }
+    begin = chunk.RowEnds[r];
+    }
+}
+
+// Entries of a sparse file, whose cells are already numbered.
+void TableToAdjacencyListPairs::AddPairs(const TableToAdjacencyListChunk& chunk)
+{
+  this->Cells.insert(this->Cells.end(), chunk.PairCells.begin(), chunk.PairCells.end());
+  this->Columns.insert(this->Columns.end(), chunk.PairGenes.begin(), chunk.PairGenes.end());
+}
+
+// Sorts the genes by name and lays the pairs out by cell and by gene.
+bool TableToAdjacencyListPairs::Write(const char* fileName,
+  const vtksys_stl::vector<vtksys_stl::string>& genes)
+{
+  vtkIdType numCells = static_cast<vtkIdType>(this->CellNames.size());
+  vtkIdType numGenes = static_cast<vtkIdType>(genes.size());
+  if (static_cast<vtkTypeUInt64>(numCells) > 0xFFFFFFFFULL ||
+      static_cast<vtkTypeUInt64>(numGenes) > 0xFFFFFFFFULL)
+    {
+    return false;
+    }
+  vtksys_stl::vector<vtksys_stl::pair<vtksys_stl::string, vtkIdType> > order(numGenes);
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    order[g] = vtksys_stl::make_pair(genes[g], g);
+    }
+  vtksys_stl::sort(order.begin(), order.end());
+  vtksys_stl::vector<vtkIdType> rank(numGenes);
+  vtksys_stl::vector<vtksys_stl::string> sortedGenes(numGenes);
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    rank[order[g].second] = g;
+    sortedGenes[g] = order[g].first;
+    }
+
+  // Bucket the pairs by cell, then sort and deduplicate every bucket.
+  vtksys_stl::vector<vtkTypeInt64> cellOffsets(numCells + 1, 0);
+  for (size_t i = 0; i < this->Cells.size(); ++i)
+    {
+    ++cellOffsets[this->Cells[i] + 1];
+    }
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    cellOffsets[c + 1] += cellOffsets[c];
+    }
+  vtksys_stl::vector<vtkTypeUInt32> cellGenes(cellOffsets[numCells]);
+  vtksys_stl::vector<vtkTypeInt64> fill(cellOffsets.begin(), cellOffsets.end() - 1);
+  for (size_t i = 0; i < this->Cells.size(); ++i)
+    {
+    cellGenes[fill[this->Cells[i]]++] = static_cast<vtkTypeUInt32>(rank[this->Columns[i]]);
+    }
+  vtkTypeInt64 numPairs = 0;
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    vtksys_stl::vector<vtkTypeUInt32>::iterator begin = cellGenes.begin() + cellOffsets[c];
+    vtksys_stl::vector<vtkTypeUInt32>::iterator end = cellGenes.begin() + cellOffsets[c + 1];
+    vtksys_stl::sort(begin, end);
+    end = vtksys_stl::unique(begin, end);
+    cellOffsets[c] = numPairs;
+    numPairs = vtksys_stl::copy(begin, end, cellGenes.begin() + numPairs) - cellGenes.begin();
+    }
+  cellOffsets[numCells] = numPairs;
+  cellGenes.resize(numPairs);
+
+  // Transpose, visiting cells in order keeps the cells of every gene sorted.
+  vtksys_stl::vector<vtkTypeInt64> geneOffsets(numGenes + 1, 0);
+  for (vtkTypeInt64 i = 0; i < numPairs; ++i)
+    {
+    ++geneOffsets[cellGenes[i] + 1];
+    }
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    geneOffsets[g + 1] += geneOffsets[g];
+    }
+  vtksys_stl::vector<vtkTypeUInt32> geneCells(numPairs);
+  fill.assign(geneOffsets.begin(), geneOffsets.end() - 1);
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    for (vtkTypeInt64 i = cellOffsets[c]; i < cellOffsets[c + 1]; ++i)
+      {
+      geneCells[fill[cellGenes[i]]++] = static_cast<vtkTypeUInt32>(c);
+      }
+    }
+
+  vtksys_stl::vector<vtkTypeInt64> cellNameOffsets;
+  vtksys_stl::vector<vtkTypeInt64> geneNameOffsets;
+  vtksys_stl::string cellNames;
+  vtksys_stl::string geneNames;
+  TableToAdjacencyListPackNames(this->CellNames, cellNameOffsets, cellNames);
+  TableToAdjacencyListPackNames(sortedGenes, geneNameOffsets, geneNames);
+
+  FILE* out = fopen(fileName, "wb");
+  if (!out)
+    {
+    return false;
+    }
+  vtkGeneAdjacencyHeader header;
+  memcpy(header.Magic, VTK_GENE_ADJACENCY_MAGIC, sizeof(header.Magic));
+  header.ByteOrder = VTK_GENE_ADJACENCY_BYTE_ORDER;
+  header.NumberOfCells = numCells;
+  header.NumberOfGenes = numGenes;
+  header.NumberOfPairs = numPairs;
+
+  // Lay the sections out once to fill in the header, then write them.
+  const void* data[8] = { &cellNameOffsets[0], cellNames.data(),
+    &geneNameOffsets[0], geneNames.data(), &cellOffsets[0],
+    numPairs ? &cellGenes[0] : 0, &geneOffsets[0], numPairs ? &geneCells[0] : 0 };
+  size_t sizes[8] = { cellNameOffsets.size() * 8, cellNames.size(),
+    geneNameOffsets.size() * 8, geneNames.size(), cellOffsets.size() * 8,
+    cellGenes.size() * 4, geneOffsets.size() * 8, geneCells.size() * 4 };
+  vtkTypeInt64* sections[8] = { &header.CellNameOffsets, &header.CellNames,
+    &header.GeneNameOffsets, &header.GeneNames, &header.CellGeneOffsets,
+    &header.CellGenes, &header.GeneCellOffsets, &header.GeneCells };
+  vtkTypeInt64 offset = sizeof(header);
+  for (int s = 0; s < 8; ++s)
+    {
+    *sections[s] = offset;
+    offset += (sizes[s] + 7) & ~static_cast<size_t>(7);
+    }
+  header.FileSize = offset;
+  offset = 0;
+  bool ok = TableToAdjacencyListWriteSection(out, &header, sizeof(header), offset);
+  for (int s = 0; s < 8; ++s)
+    {
+    ok = TableToAdjacencyListWriteSection(out, data[s], sizes[s], offset) && ok;
+    }
+  return (fclose(out) == 0) && ok;
+}
 
 int main( int argc, char** argv )
 {
-  if (argc != 2)
+  int numThreads = 1;
+  const char* fileName = 0;
+  const char* binaryFileName = 0;
+  const char* cellsFileName = 0;
+  const char* genesFileName = 0;
+  TableToAdjacencyListParser parser;
+  for (int i = 1; i < argc; ++i)
+    {
+    if (!strcmp(argv[i], "-j") && i + 1 < argc)
+      {
+      numThreads = atoi(argv[++i]);
+      }
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+      {
+      binaryFileName = argv[++i];
+      }
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+      {
+      cellsFileName = argv[++i];
+      }
+    else if (!strcmp(argv[i], "-g") && i + 1 < argc)
+      {
+      genesFileName = argv[++i];
+      }
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      {
+      // Parsed as the values are, so that a value equal to the threshold
+      // is never above it.
+      const char* threshold = argv[++i];
+      const char* thresholdEnd = threshold + strlen(threshold);
+      parser.HasThreshold = true;
+      if (!TableToAdjacencyListReadNumber(threshold, thresholdEnd, parser.Threshold) ||
+          threshold != thresholdEnd)
+        {
+        numThreads = 0;
+        }
+      }
+    else if (!strcmp(argv[i], "-T"))
+      {
+      parser.Transpose = true;
+      }
+    else if (!fileName)
+      {
+      fileName = argv[i];
+      }
+    else
+      {
+      fileName = 0;
+      break;
+      }
+    }
+  bool sparse = cellsFileName || genesFileName;
+  if (!fileName || numThreads < 1 || (sparse && !(cellsFileName && genesFileName)))
+    {
+    cerr << "Usage: TableToAdjacencyList [options] outTable.csv > adjTable.csv" << endl;
+    cerr << "       TableToAdjacencyList [options] -c cells.tsv -g genes.tsv "
+            "matrix.mtx|triplets.csv > adjTable.csv" << endl;
+    cerr << "Options: -j threads, -b adjTable.adj (binary output), "
+            "-t threshold, -T (rows are genes)" << endl;
+    return 1;
+    }
+  if (sparse && (!TableToAdjacencyListReadNames(cellsFileName, parser.Cells) ||
+                 !TableToAdjacencyListReadNames(genesFileName, parser.Genes)))
+    {
+    cerr << "Could not read the names in " << cellsFileName << " and "
+         << genesFileName << endl;
+    return 1;
+    }
+  FILE* in = fopen(fileName, "rb");
+  if (!in)
     {
-    cerr << "Usage: TableToAdjacencyList outTable.csv > adjTable.csv" << endl;
+    cerr << "Could not open " << fileName << endl;
     return 1;
     }
-  vtkSmartPointer<vtkDelimitedTextReader> tr =
-    vtkSmartPointer<vtkDelimitedTextReader>::New();
-  tr->SetHaveHeaders(true);
-  tr->SetMergeConsecutiveDelimiters(false);
-  tr->SetFieldDelimiterCharacters(",");
-  tr->SetFileName(argv[1]);
-  tr->Update();
-  vtkTable* tab = tr->GetOutput();
-  cout << "cell,gene" << endl;
-  for (vtkIdType row = 0; row < tab->GetNumberOfRows(); ++row)
+
+  // The buffer holds the unparsed end of the previous read followed by
+  // the next block of every thread. It only grows for a row longer than
+  // a block.
+  size_t blockSize = static_cast<size_t>(TABLE_TO_ADJACENCY_LIST_BLOCK) * numThreads;
+  vtksys_stl::vector<char> buffer(blockSize);
+  size_t size = 0;
+  bool done = false;
+  parser.Binary = binaryFileName != 0;
+  TableToAdjacencyListPairs pairs;
+  if (sparse)
     {
-    vtkStdString cell = tab->GetValue(row, 0).ToString();
-    for (vtkIdType col = 1; col < tab->GetNumberOfColumns(); ++col)
+    pairs.CellNames = parser.Cells;
+    }
+  vtkIdType skipped = 0;
+  bool startRead = false;
+  bool haveHeader = false;
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(TableToAdjacencyListParser::Execute, &parser);
+
+  if (!parser.Binary)
+    {
+    fputs("cell,gene\n", stdout);
+    }
+  while (!done)
+    {
+    if (buffer.size() - size < blockSize)
+      {
+      buffer.resize(size + blockSize);
+      }
+    size_t read = fread(&buffer[0] + size, 1, buffer.size() - size, in);
+    size += read;
+    done = read == 0;
+    const char* data = &buffer[0];
+    const char* dataEnd = data + size;
+
+    // Only whole lines are parsed, until the end of the file.
+    const char* lastLine = dataEnd;
+    if (!done)
+      {
+      while (lastLine > data && lastLine[-1] != '\n')
+        {
+        --lastLine;
+        }
+      if (lastLine == data)
+        {
+        continue;
+        }
+      }
+
+    // The header is read a line at a time, it may span several reads.
+    const char* p = data;
+    if (!startRead)
+      {
+      if (size >= 3 && !strncmp(p, "\xEF\xBB\xBF", 3))
+        {
+        p += 3;
+        }
+      if (sparse)
+        {
+        parser.Format = size >= 14 && !strncmp(p, "%%MatrixMarket", 14) ?
+          TableToAdjacencyListParser::MATRIX_MARKET :
+          TableToAdjacencyListParser::TRIPLETS;
+        }
+      startRead = true;
+      }
+    while (!haveHeader && p < lastLine)
+      {
+      const char* lineEnd = static_cast<const char*>(memchr(p, '\n', lastLine - p));
+      lineEnd = lineEnd ? lineEnd : lastLine;
+      int line = parser.ParseHeader(p, lineEnd);
+      if (line == TableToAdjacencyListParser::HEADER_ERROR)
+        {
+        cerr << "Not a coordinate real, integer or pattern general Matrix Market file: "
+             << fileName << endl;
+        return 1;
+        }
+      haveHeader = line != TableToAdjacencyListParser::HEADER_LINE;
+      if (line != TableToAdjacencyListParser::FIRST_ENTRY)
+        {
+        p = lineEnd < lastLine ? lineEnd + 1 : lastLine;
+        }
+      if (haveHeader && parser.Format == TableToAdjacencyListParser::MATRIX_MARKET)
+        {
+        // A genes by cells matrix is recognized by its size.
+        vtkTypeInt64 numCells = static_cast<vtkTypeInt64>(parser.Cells.size());
+        vtkTypeInt64 numGenes = static_cast<vtkTypeInt64>(parser.Genes.size());
+        if (parser.NumberOfRows == numGenes && parser.NumberOfColumns == numCells &&
+            numCells != numGenes)
+          {
+          parser.Transpose = true;
+          }
+        if ((parser.Transpose ? parser.NumberOfColumns : parser.NumberOfRows) != numCells ||
+            (parser.Transpose ? parser.NumberOfRows : parser.NumberOfColumns) != numGenes)
+          {
+          cerr << "Warning: the matrix is " << parser.NumberOfRows << " x "
+               << parser.NumberOfColumns << " for " << numCells << " cells and "
+               << numGenes << " genes" << endl;
+          }
+        }
+      }
+
+    // One chunk per thread, starting at line boundaries.
+    size_t bodySize = static_cast<size_t>(lastLine - p);
+    int numChunks = bodySize < (1 << 16) ? 1 : numThreads;
+    parser.Chunks.resize(numChunks);
+    for (int t = 0; t < numChunks; ++t)
+      {
+      const char* begin = p + static_cast<size_t>(
+        static_cast<double>(bodySize) * t / numChunks);
+      while (t > 0 && begin < lastLine && begin[-1] != '\n')
+        {
+        ++begin;
+        }
+      parser.Chunks[t].Begin = begin;
+      if (t > 0)
+        {
+        parser.Chunks[t - 1].End = begin;
+        }
+      }
+    parser.Chunks[numChunks - 1].End = lastLine;
+    if (numChunks == 1)
+      {
+      parser.Parse(parser.Chunks[0]);
+      }
+    else
       {
-      if (tab->GetValue(row, col).ToInt() == 1)
+      threader->SetNumberOfThreads(numChunks);
+      threader->SingleMethodExecute();
+      }
+    for (int t = 0; t < numChunks; ++t)
+      {
+      skipped += parser.Chunks[t].NumberOfSkippedLines;
+      if (parser.Binary && sparse)
+        {
+        pairs.AddPairs(parser.Chunks[t]);
+        }
+      else if (parser.Binary)
         {
-        vtkStdString gene = tab->GetColumn(col)->GetName();
-        cout << cell << "," << gene << endl;
+        pairs.Add(parser.Chunks[t]);
         }
       }
+    for (int t = 0; t < numChunks && !parser.Binary; ++t)
+      {
+      const vtksys_stl::string& output = parser.Chunks[t].Output;
+      fwrite(output.data(), 1, output.size(), stdout);
+      }
+
+    // Keep the unparsed partial line for the next read.
+    size = static_cast<size_t>(dataEnd - lastLine);
+    memmove(&buffer[0], lastLine, size);
+    }
+  fclose(in);
+  if (skipped > 0)
+    {
+    cerr << "Warning: skipped " << skipped << " entries that are unreadable "
+            "or out of the names given" << endl;
+    }
+  if (parser.Binary && !pairs.Write(binaryFileName, parser.Genes))
+    {
+    cerr << "Could not write " << binaryFileName << endl;
+    return 1;
     }
-  return 0;
+  return fflush(stdout) == 0 ? 0 : 1;
 }
@@ -0,0 +1,134 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkDataSetAttributes.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMutableDirectedGraph.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+#include "vtkTree.h"
+#include "vtkTreeCollapseFilter.h"
+
+#include <stdlib.h>
+
+// Times vtkTreeCollapseFilter on two synthetic lineages of the same size:
+// a deep one, a spine where every vertex also has one leaf child, and a
+// wide one, a balanced binary tree. Each tree is run with nothing
+// collapsed, with every 97th leaf collapsed (nothing is cut, the whole
+// tree is still walked) and after CollapseGeneration / ExpandAll, every
+// time as for a new input, walking the whole tree.
+//
+// Usage: TreeCollapseBenchmark [numberOfVertices] [repeats]
+
+static vtkTree* SyntheticTree(vtkIdType numVertices, bool deep)
+{
+  vtkSmartPointer<vtkMutableDirectedGraph> builder =
+    vtkSmartPointer<vtkMutableDirectedGraph>::New();
+  vtkSmartPointer<vtkIdTypeArray> pedigrees = vtkSmartPointer<vtkIdTypeArray>::New();
+  pedigrees->SetName("PedigreeVertexId");
+  vtkSmartPointer<vtkDoubleArray> startTimes = vtkSmartPointer<vtkDoubleArray>::New();
+  startTimes->SetName("StartTime");
+  vtkSmartPointer<vtkDoubleArray> endTimes = vtkSmartPointer<vtkDoubleArray>::New();
+  endTimes->SetName("EndTime");
+
+  builder->AddVertex();
+  for (vtkIdType v = 1; v < numVertices; ++v)
+    {
+    // Deep: odd vertices form the spine, even ones hang off it as leaves.
+    vtkIdType parent = deep ? v - 1 - (v > 1 && v % 2 == 1) : (v - 1) / 2;
+    builder->AddChild(parent);
+    }
+  for (vtkIdType v = 0; v < numVertices; ++v)
+    {
+    pedigrees->InsertNextValue(v);
+    startTimes->InsertNextValue(v);
+    endTimes->InsertNextValue(v + 1);
+    }
+  builder->GetVertexData()->AddArray(pedigrees);
+  builder->GetVertexData()->AddArray(startTimes);
+  builder->GetVertexData()->AddArray(endTimes);
+
+  vtkTree* tree = vtkTree::New();
+  if (!tree->CheckedShallowCopy(builder))
+    {
+    tree->Delete();
+    return 0;
+    }
+  return tree;
+}
+
+// Best time of repeats updates of the filter. The input is modified before
+// each one, otherwise the filter would only splice the (empty) difference
+// with the collapsed nodes of the previous update.
+static double TimeUpdate(vtkTreeCollapseFilter* filter, vtkTree* tree, int repeats)
+{
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double best = VTK_DOUBLE_MAX;
+  for (int r = 0; r < repeats; ++r)
+    {
+    tree->Modified();
+    timer->StartTimer();
+    filter->Update();
+    timer->StopTimer();
+    if (timer->GetElapsedTime() < best)
+      {
+      best = timer->GetElapsedTime();
+      }
+    }
+  return best;
+}
+
+int main( int argc, char** argv )
+{
+  vtkIdType numVertices = argc > 1 ? atoi(argv[1]) : 1000000;
+  int repeats = argc > 2 ? atoi(argv[2]) : 3;
+  if (numVertices <= 1 || repeats <= 0)
+    {
+    cerr << "Usage: TreeCollapseBenchmark [numberOfVertices] [repeats]" << endl;
+    return 1;
+    }
+
+  const char* names[2] = { "deep", "wide" };
+  for (int shape = 0; shape < 2; ++shape)
+    {
+    vtkTree* tree = SyntheticTree(numVertices, shape == 0);
+    if (!tree)
+      {
+      cerr << "Could not build the " << names[shape] << " tree" << endl;
+      return 1;
+      }
+
+    vtkSmartPointer<vtkTreeCollapseFilter> filter =
+      vtkSmartPointer<vtkTreeCollapseFilter>::New();
+    filter->SetInput(tree);
+
+    cout << names[shape] << ", nothing collapsed:   "
+         << TimeUpdate(filter, tree, repeats) << " s" << endl;
+
+    vtkSmartPointer<vtkIdTypeArray> leaves = vtkSmartPointer<vtkIdTypeArray>::New();
+    for (vtkIdType v = 1; v < numVertices; ++v)
+      {
+      if (v % 97 == 0 && tree->IsLeaf(v))
+        {
+        leaves->InsertNextValue(v);
+        }
+      }
+    filter->SetCollapsedNodes(leaves);
+    cout << names[shape] << ", " << leaves->GetNumberOfTuples()
+         << " leaves collapsed: " << TimeUpdate(filter, tree, repeats) << " s, "
+         << filter->GetOutput()->GetNumberOfVertices() << " vertices" << endl;
+
+    filter->CollapseGeneration(8);
+    cout << names[shape] << ", generation 8:        "
+         << TimeUpdate(filter, tree, repeats) << " s, "
+         << filter->GetOutput()->GetNumberOfVertices() << " vertices" << endl;
+
+    filter->ExpandAll();
+    cout << names[shape] << ", expanded again:      "
+         << TimeUpdate(filter, tree, repeats) << " s" << endl;
+
+    tree->Delete();
+    }
+  return 0;
+}
@@ -0,0 +1,166 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkArrayRange.h"
+
+#include "vtkDataArray.h"
+#include "vtkObjectFactory.h"
+
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkArrayRange, "$Revision$");
+vtkStandardNewMacro(vtkArrayRange);
+
+// Bins of the percentile histogram.
+#define VTK_ARRAY_RANGE_BINS 1024
+
+// Minimum and maximum of values, skipping NaN. Four independent
+// accumulators break the dependency between iterations so that the loop
+// vectorizes; comparisons with NaN are false, so NaN never replaces a
+// number once the accumulators start from one.
+template <class T>
+int vtkArrayRangeMinMax(const T* values, vtkIdType numValues, double range[2])
+{
+  vtkIdType first = 0;
+  while (first < numValues && !(values[first] == values[first]))
+    {
+    ++first;
+    }
+  if (first == numValues)
+    {
+    return 0;
+    }
+  T lo[4] = { values[first], values[first], values[first], values[first] };
+  T hi[4] = { values[first], values[first], values[first], values[first] };
+  vtkIdType i = first;
+  for (; i + 4 <= numValues; i += 4)
+    {
+    for (int k = 0; k < 4; ++k)
+      {
+      T v = values[i + k];
+      lo[k] = v < lo[k] ? v : lo[k];
+      hi[k] = v > hi[k] ? v : hi[k];
+      }
+    }
+  for (; i < numValues; ++i)
+    {
+    T v = values[i];
+    lo[0] = v < lo[0] ? v : lo[0];
+    hi[0] = v > hi[0] ? v : hi[0];
+    }
+  for (int k = 1; k < 4; ++k)
+    {
+    lo[0] = lo[k] < lo[0] ? lo[k] : lo[0];
+    hi[0] = hi[k] > hi[0] ? hi[k] : hi[0];
+    }
+  range[0] = static_cast<double>(lo[0]);
+  range[1] = static_cast<double>(hi[0]);
+  return 1;
+}
+
+// Count the values falling in each of numBins bins over range, leaving
+// zeros out with skipZeros.
+template <class T>
+void vtkArrayRangeHistogram(const T* values, vtkIdType numValues,
+  const double range[2], vtkIdType* bins, int numBins, int skipZeros)
+{
+  double scale = numBins / (range[1] - range[0]);
+  for (vtkIdType i = 0; i < numValues; ++i)
+    {
+    double v = static_cast<double>(values[i]);
+    if (v >= range[0] && v <= range[1] && !(skipZeros && v == 0.0))
+      {
+      int b = static_cast<int>((v - range[0]) * scale);
+      ++bins[b < numBins ? b : numBins - 1];
+      }
+    }
+}
+
+int vtkArrayRange::ComputeRange(vtkDataArray* array, double range[2])
+{
+  if (!array || array->GetNumberOfTuples() == 0)
+    {
+    return 0;
+    }
+  if (array->GetNumberOfComponents() != 1)
+    {
+    array->GetRange(range, -1);
+    return 1;
+    }
+  int found = 0;
+  vtkIdType numValues = array->GetNumberOfTuples();
+  switch (array->GetDataType())
+    {
+    vtkTemplateMacro(found = vtkArrayRangeMinMax(
+      static_cast<VTK_TT*>(array->GetVoidPointer(0)), numValues, range));
+    }
+  return found;
+}
+
+int vtkArrayRange::ComputePercentileRange(vtkDataArray* array, double low,
+  double high, double range[2], int skipZeros)
+{
+  double full[2];
+  if (!vtkArrayRange::ComputeRange(array, full))
+    {
+    return 0;
+    }
+  if (array->GetNumberOfComponents() != 1 || full[0] == full[1] ||
+      (low <= 0.0 && high >= 1.0))
+    {
+    range[0] = full[0];
+    range[1] = full[1];
+    return 1;
+    }
+
+  vtksys_stl::vector<vtkIdType> bins(VTK_ARRAY_RANGE_BINS, 0);
+  vtkIdType numValues = array->GetNumberOfTuples();
+  switch (array->GetDataType())
+    {
+    vtkTemplateMacro(vtkArrayRangeHistogram(
+      static_cast<VTK_TT*>(array->GetVoidPointer(0)), numValues, full,
+      &bins[0], VTK_ARRAY_RANGE_BINS, skipZeros));
+    }
+  vtkIdType total = 0;
+  for (int b = 0; b < VTK_ARRAY_RANGE_BINS; ++b)
+    {
+    total += bins[b];
+    }
+  if (total == 0)
+    {
+    range[0] = full[0];
+    range[1] = full[1];
+    return 1;
+    }
+
+  // The lower bound is the start of the bin holding the low fraction, the
+  // upper bound the end of the bin holding the high fraction.
+  double width = (full[1] - full[0]) / VTK_ARRAY_RANGE_BINS;
+  double lowCount = low * total;
+  double highCount = high * total;
+  vtkIdType count = 0;
+  int lowBin = -1;
+  int highBin = VTK_ARRAY_RANGE_BINS - 1;
+  for (int b = 0; b < VTK_ARRAY_RANGE_BINS; ++b)
+    {
+    count += bins[b];
+    if (lowBin < 0 && count > lowCount)
+      {
+      lowBin = b;
+      }
+    if (count >= highCount)
+      {
+      highBin = b;
+      break;
+      }
+    }
+  lowBin = lowBin < 0 ? highBin : lowBin;
+  range[0] = low <= 0.0 ? full[0] : full[0] + lowBin * width;
+  range[1] = highBin == VTK_ARRAY_RANGE_BINS - 1 ? full[1] : full[0] + (highBin + 1) * width;
+  return 1;
+}
+
+void vtkArrayRange::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+}
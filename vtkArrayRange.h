@@ -0,0 +1,58 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkArrayRange - fast value range and percentiles of an array
+//
+// .SECTION Description
+// vtkArrayRange computes the range of the values of a single component
+// array, or the values at given percentiles, straight from its memory.
+// The range is found with independent minimum and maximum accumulators
+// that compilers turn into vector instructions, NaN values being skipped.
+// Percentiles come from a histogram of the values over that range, so
+// they are exact to within 1/1024 of the range, in two passes and no
+// sort.
+//
+// Unlike vtkDataArray::GetRange, nothing is cached in the array, so the
+// values may be changed in place between calls.
+
+#ifndef __vtkArrayRange_h
+#define __vtkArrayRange_h
+
+#include "vtkObject.h"
+
+class vtkDataArray;
+
+class vtkArrayRange : public vtkObject
+{
+public:
+  static vtkArrayRange *New();
+  vtkTypeRevisionMacro(vtkArrayRange,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Set range to the smallest and largest values of the array. Returns 0,
+  // leaving range unchanged, if the array holds no number. Arrays with
+  // several components fall back to the range of their magnitude.
+  static int ComputeRange(vtkDataArray* array, double range[2]);
+
+  // Description:
+  // Set range to the values below which the fractions low and high of the
+  // values of the array lie, e.g. 0.02 and 0.98 to leave out outliers.
+  // With skipZeros, the fractions are of the non-zero values only, for
+  // sparse arrays such as expression levels where zeros would otherwise
+  // pull the percentiles down; the range still starts at the minimum of
+  // the array when low is 0. Returns 0 if the array holds no number.
+  static int ComputePercentileRange(vtkDataArray* array, double low,
+                                    double high, double range[2],
+                                    int skipZeros = 0);
+
+protected:
+  vtkArrayRange() {}
+  ~vtkArrayRange() {}
+
+private:
+  vtkArrayRange(const vtkArrayRange&);  // Not implemented.
+  void operator=(const vtkArrayRange&);  // Not implemented.
+};
+
+#endif
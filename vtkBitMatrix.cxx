@@ -0,0 +1,229 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkBitMatrix.h"
+
+#include "vtkIdTypeArray.h"
+#include "vtkObjectFactory.h"
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkBitMatrix, "$Revision$");
+vtkStandardNewMacro(vtkBitMatrix);
+
+static inline int vtkBitMatrixPopCount(vtkTypeUInt64 w)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll(w);
+#else
+  int count = 0;
+  for (; w; w &= w - 1)
+    {
+    ++count;
+    }
+  return count;
+#endif
+}
+
+static inline int vtkBitMatrixTrailingZeros(vtkTypeUInt64 w)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(w);
+#else
+  int count = 0;
+  for (; !(w & 1); w >>= 1)
+    {
+    ++count;
+    }
+  return count;
+#endif
+}
+
+class vtkBitMatrixInternals
+{
+public:
+  vtksys_stl::vector<vtkTypeUInt64> Rows;
+  vtksys_stl::vector<vtkTypeUInt64> Columns;
+  vtksys_stl::vector<vtkTypeUInt64> Accumulator;
+
+  // Ors the given lines (rows or columns) of words into Accumulator, then
+  // appends the positions of its set bits to result.
+  void Collect(const vtkTypeUInt64* lines, vtkIdType wordsPerLine,
+    vtkIdType numLines, vtkIdTypeArray* ids, vtkIdTypeArray* result);
+};
+
+void vtkBitMatrixInternals::Collect(const vtkTypeUInt64* lines,
+  vtkIdType wordsPerLine, vtkIdType numLines, vtkIdTypeArray* ids,
+  vtkIdTypeArray* result)
+{
+  this->Accumulator.assign(wordsPerLine, 0);
+  vtkTypeUInt64* acc = wordsPerLine > 0 ? &this->Accumulator[0] : 0;
+  vtkIdType numIds = ids->GetNumberOfTuples();
+  for (vtkIdType k = 0; k < numIds; ++k)
+    {
+    vtkIdType line = ids->GetValue(k);
+    if (line < 0 || line >= numLines)
+      {
+      continue;
+      }
+    const vtkTypeUInt64* words = lines + line * wordsPerLine;
+    for (vtkIdType w = 0; w < wordsPerLine; ++w)
+      {
+      acc[w] |= words[w];
+      }
+    }
+
+  vtkIdType count = 0;
+  for (vtkIdType w = 0; w < wordsPerLine; ++w)
+    {
+    count += vtkBitMatrixPopCount(acc[w]);
+    }
+  vtkIdType* out = result->WritePointer(result->GetNumberOfTuples(), count);
+  for (vtkIdType w = 0; w < wordsPerLine; ++w)
+    {
+    for (vtkTypeUInt64 bits = acc[w]; bits; bits &= bits - 1)
+      {
+      *out++ = w * 64 + vtkBitMatrixTrailingZeros(bits);
+      }
+    }
+}
+
+vtkBitMatrix::vtkBitMatrix()
+{
+  this->NumberOfRows = 0;
+  this->NumberOfColumns = 0;
+  this->WordsPerRow = 0;
+  this->WordsPerColumn = 0;
+  this->Internals = new vtkBitMatrixInternals;
+}
+
+vtkBitMatrix::~vtkBitMatrix()
+{
+  delete this->Internals;
+}
+
+void vtkBitMatrix::SetSize(vtkIdType numberOfRows, vtkIdType numberOfColumns)
+{
+  this->NumberOfRows = numberOfRows > 0 ? numberOfRows : 0;
+  this->NumberOfColumns = numberOfColumns > 0 ? numberOfColumns : 0;
+  this->WordsPerRow = (this->NumberOfColumns + 63) / 64;
+  this->WordsPerColumn = (this->NumberOfRows + 63) / 64;
+  this->Internals->Rows.assign(this->NumberOfRows * this->WordsPerRow, 0);
+  this->Internals->Columns.assign(this->NumberOfColumns * this->WordsPerColumn, 0);
+  this->Modified();
+}
+
+void vtkBitMatrix::Initialize()
+{
+  this->SetSize(0, 0);
+  vtksys_stl::vector<vtkTypeUInt64>().swap(this->Internals->Rows);
+  vtksys_stl::vector<vtkTypeUInt64>().swap(this->Internals->Columns);
+  vtksys_stl::vector<vtkTypeUInt64>().swap(this->Internals->Accumulator);
+}
+
+void vtkBitMatrix::SetBit(vtkIdType row, vtkIdType column)
+{
+  this->Internals->Rows[row * this->WordsPerRow + column / 64] |=
+    static_cast<vtkTypeUInt64>(1) << (column % 64);
+  this->Internals->Columns[column * this->WordsPerColumn + row / 64] |=
+    static_cast<vtkTypeUInt64>(1) << (row % 64);
+}
+
+int vtkBitMatrix::GetBit(vtkIdType row, vtkIdType column)
+{
+  return static_cast<int>(
+    (this->Internals->Rows[row * this->WordsPerRow + column / 64] >> (column % 64)) & 1);
+}
+
+vtkTypeUInt64* vtkBitMatrix::GetRow(vtkIdType row)
+{
+  return this->WordsPerRow > 0 ? &this->Internals->Rows[row * this->WordsPerRow] : 0;
+}
+
+vtkTypeUInt64* vtkBitMatrix::GetColumn(vtkIdType column)
+{
+  return this->WordsPerColumn > 0 ?
+    &this->Internals->Columns[column * this->WordsPerColumn] : 0;
+}
+
+void vtkBitMatrix::UpdateColumns()
+{
+  vtksys_stl::fill(this->Internals->Columns.begin(), this->Internals->Columns.end(), 0);
+  for (vtkIdType r = 0; r < this->NumberOfRows; ++r)
+    {
+    const vtkTypeUInt64* words = this->GetRow(r);
+    vtkTypeUInt64 rowBit = static_cast<vtkTypeUInt64>(1) << (r % 64);
+    vtkIdType rowWord = r / 64;
+    for (vtkIdType w = 0; w < this->WordsPerRow; ++w)
+      {
+      for (vtkTypeUInt64 bits = words[w]; bits; bits &= bits - 1)
+        {
+        vtkIdType c = w * 64 + vtkBitMatrixTrailingZeros(bits);
+        this->Internals->Columns[c * this->WordsPerColumn + rowWord] |= rowBit;
+        }
+      }
+    }
+  this->Modified();
+}
+
+vtkIdType vtkBitMatrix::GetRowCount(vtkIdType row)
+{
+  const vtkTypeUInt64* words = this->GetRow(row);
+  vtkIdType count = 0;
+  for (vtkIdType w = 0; w < this->WordsPerRow; ++w)
+    {
+    count += vtkBitMatrixPopCount(words[w]);
+    }
+  return count;
+}
+
+vtkIdType vtkBitMatrix::GetColumnCount(vtkIdType column)
+{
+  const vtkTypeUInt64* words = this->GetColumn(column);
+  vtkIdType count = 0;
+  for (vtkIdType w = 0; w < this->WordsPerColumn; ++w)
+    {
+    count += vtkBitMatrixPopCount(words[w]);
+    }
+  return count;
+}
+
+vtkIdType vtkBitMatrix::GetNumberOfSetBits()
+{
+  vtkIdType count = 0;
+  vtksys_stl::vector<vtkTypeUInt64>::const_iterator it = this->Internals->Rows.begin();
+  for (; it != this->Internals->Rows.end(); ++it)
+    {
+    count += vtkBitMatrixPopCount(*it);
+    }
+  return count;
+}
+
+void vtkBitMatrix::GetColumnsOfRows(vtkIdTypeArray* rows, vtkIdTypeArray* result)
+{
+  if (this->NumberOfRows == 0 || this->NumberOfColumns == 0)
+    {
+    return;
+    }
+  this->Internals->Collect(this->GetRow(0), this->WordsPerRow,
+    this->NumberOfRows, rows, result);
+}
+
+void vtkBitMatrix::GetRowsOfColumns(vtkIdTypeArray* columns, vtkIdTypeArray* result)
+{
+  if (this->NumberOfRows == 0 || this->NumberOfColumns == 0)
+    {
+    return;
+    }
+  this->Internals->Collect(this->GetColumn(0), this->WordsPerColumn,
+    this->NumberOfColumns, columns, result);
+}
+
+void vtkBitMatrix::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "NumberOfRows: " << this->NumberOfRows << endl;
+  os << indent << "NumberOfColumns: " << this->NumberOfColumns << endl;
+  os << indent << "NumberOfSetBits: " << this->GetNumberOfSetBits() << endl;
+}
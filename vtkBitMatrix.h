@@ -0,0 +1,92 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkBitMatrix - dense boolean matrix packed in 64 bit words
+//
+// .SECTION Description
+// vtkBitMatrix stores a boolean matrix with one bit per entry, twice: row
+// by row and column by column, every row and column padded to whole 64 bit
+// words. The two copies let both the columns set in a group of rows and
+// the rows set in a group of columns be found by or-ing words and
+// counting bits, without walking any per entry list. It is used for cell
+// by gene expression data read as a dense matrix, where a bit per entry is
+// far smaller than a list of (cell, gene) pairs.
+//
+// Entries are written with SetBit, or directly into the row words, after
+// which UpdateColumns rebuilds the column copy.
+
+#ifndef __vtkBitMatrix_h
+#define __vtkBitMatrix_h
+
+#include "vtkObject.h"
+
+class vtkIdTypeArray;
+class vtkBitMatrixInternals;
+
+class vtkBitMatrix : public vtkObject
+{
+public:
+  static vtkBitMatrix *New();
+  vtkTypeRevisionMacro(vtkBitMatrix,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Resize the matrix and clear all its entries.
+  void SetSize(vtkIdType numberOfRows, vtkIdType numberOfColumns);
+
+  // Description:
+  // Release the matrix.
+  void Initialize();
+
+  // Description:
+  // The size of the matrix.
+  vtkGetMacro(NumberOfRows, vtkIdType);
+  vtkGetMacro(NumberOfColumns, vtkIdType);
+
+  // Description:
+  // Set or get entry (row, column). SetBit updates both copies.
+  void SetBit(vtkIdType row, vtkIdType column);
+  int GetBit(vtkIdType row, vtkIdType column);
+
+  // Description:
+  // The words of a row (GetWordsPerRow of them, bit c of the row is bit
+  // c % 64 of word c / 64) or of a column. Rows may be written directly,
+  // followed by UpdateColumns.
+  vtkIdType GetWordsPerRow() { return this->WordsPerRow; }
+  vtkIdType GetWordsPerColumn() { return this->WordsPerColumn; }
+  vtkTypeUInt64* GetRow(vtkIdType row);
+  vtkTypeUInt64* GetColumn(vtkIdType column);
+
+  // Description:
+  // Rebuild the column copy from the rows.
+  void UpdateColumns();
+
+  // Description:
+  // The number of entries set in a row, a column or the whole matrix.
+  vtkIdType GetRowCount(vtkIdType row);
+  vtkIdType GetColumnCount(vtkIdType column);
+  vtkIdType GetNumberOfSetBits();
+
+  // Description:
+  // Append to result, in increasing order, the columns set in any of the
+  // given rows, or the rows set in any of the given columns. Ids out of
+  // range are skipped.
+  void GetColumnsOfRows(vtkIdTypeArray* rows, vtkIdTypeArray* result);
+  void GetRowsOfColumns(vtkIdTypeArray* columns, vtkIdTypeArray* result);
+
+protected:
+  vtkBitMatrix();
+  ~vtkBitMatrix();
+
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  vtkIdType WordsPerRow;
+  vtkIdType WordsPerColumn;
+  vtkBitMatrixInternals* Internals;
+
+private:
+  vtkBitMatrix(const vtkBitMatrix&);  // Not implemented.
+  void operator=(const vtkBitMatrix&);  // Not implemented.
+};
+
+#endif
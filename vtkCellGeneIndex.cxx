@@ -0,0 +1,751 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkCellGeneIndex.h"
+
+#include "vtkBitMatrix.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+#include "vtkStdString.h"
+#include "vtkStringArray.h"
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/utility>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkCellGeneIndex, "$Revision$");
+vtkStandardNewMacro(vtkCellGeneIndex);
+
+class vtkCellGeneIndexInternals
+{
+public:
+  // Scratch marks used to report every id once, cleared after each query.
+  vtksys_stl::vector<unsigned char> CellMarks;
+  vtksys_stl::vector<unsigned char> GeneMarks;
+
+  static void Collect(const vtkIdType* offsets, const vtkIdType* values,
+    vtkIdType numSources, vtkIdTypeArray* sources,
+    vtksys_stl::vector<unsigned char>& marks, vtkIdTypeArray* result);
+
+  static void LookupCells(vtkStringArray* treeCellNames,
+    vtkStringArray* cellNames, vtksys_stl::vector<vtkIdType>& pedigree);
+
+  static void SortGenes(vtkStringArray* geneNames, vtkStringArray* sorted,
+    vtksys_stl::vector<vtkIdType>& rank);
+};
+
+// Appends the adjacent ids of the given sources, skipping marked ones.
+void vtkCellGeneIndexInternals::Collect(const vtkIdType* offsets,
+  const vtkIdType* values, vtkIdType numSources, vtkIdTypeArray* sources,
+  vtksys_stl::vector<unsigned char>& marks, vtkIdTypeArray* result)
+{
+  vtkIdType first = result->GetNumberOfTuples();
+  vtkIdType numGiven = sources->GetNumberOfTuples();
+  for (vtkIdType k = 0; k < numGiven; ++k)
+    {
+    vtkIdType s = sources->GetValue(k);
+    if (s < 0 || s >= numSources)
+      {
+      continue;
+      }
+    for (vtkIdType i = offsets[s]; i < offsets[s + 1]; ++i)
+      {
+      if (!marks[values[i]])
+        {
+        marks[values[i]] = 1;
+        result->InsertNextValue(values[i]);
+        }
+      }
+    }
+  vtkIdType last = result->GetNumberOfTuples();
+  for (vtkIdType i = first; i < last; ++i)
+    {
+    marks[result->GetValue(i)] = 0;
+    }
+}
+
+// Orders gene ids by name.
+class vtkCellGeneIndexNameLess
+{
+public:
+  vtkCellGeneIndexNameLess(vtkStringArray* names) : Names(names) {}
+  bool operator()(vtkIdType a, vtkIdType b) const
+    {
+    return this->Names->GetValue(a) < this->Names->GetValue(b);
+    }
+  vtkStringArray* Names;
+};
+
+// Sets pedigree[c] to the tree vertex named cellNames[c], -1 if none.
+void vtkCellGeneIndexInternals::LookupCells(vtkStringArray* treeCellNames,
+  vtkStringArray* cellNames, vtksys_stl::vector<vtkIdType>& pedigree)
+{
+  vtkIdType numCells = treeCellNames->GetNumberOfTuples();
+  vtksys_stl::vector<vtksys_stl::pair<vtkStdString, vtkIdType> > cellLookup(numCells);
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    cellLookup[c] = vtksys_stl::make_pair(treeCellNames->GetValue(c), c);
+    }
+  vtksys_stl::sort(cellLookup.begin(), cellLookup.end());
+
+  vtkIdType numRead = cellNames->GetNumberOfTuples();
+  pedigree.resize(numRead);
+  for (vtkIdType c = 0; c < numRead; ++c)
+    {
+    vtkStdString cell = cellNames->GetValue(c);
+    vtksys_stl::vector<vtksys_stl::pair<vtkStdString, vtkIdType> >::iterator it =
+      vtksys_stl::lower_bound(cellLookup.begin(), cellLookup.end(),
+        vtksys_stl::make_pair(cell, static_cast<vtkIdType>(-1)));
+    pedigree[c] = (it == cellLookup.end() || it->first != cell) ? -1 : it->second;
+    }
+}
+
+// Fills sorted with the gene names in order, rank[g] being the position
+// of geneNames[g] in it.
+void vtkCellGeneIndexInternals::SortGenes(vtkStringArray* geneNames,
+  vtkStringArray* sorted, vtksys_stl::vector<vtkIdType>& rank)
+{
+  vtkIdType numGenes = geneNames->GetNumberOfTuples();
+  vtksys_stl::vector<vtkIdType> order(numGenes);
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    order[g] = g;
+    }
+  vtksys_stl::sort(order.begin(), order.end(), vtkCellGeneIndexNameLess(geneNames));
+  rank.resize(numGenes);
+  sorted->SetNumberOfValues(numGenes);
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    rank[order[g]] = g;
+    sorted->SetValue(g, geneNames->GetValue(order[g]));
+    }
+}
+
+vtkCellGeneIndex::vtkCellGeneIndex()
+{
+  this->GeneNames = vtkStringArray::New();
+  this->CellGeneOffsets = vtkIdTypeArray::New();
+  this->CellGenes = vtkIdTypeArray::New();
+  this->GeneCellOffsets = vtkIdTypeArray::New();
+  this->GeneCells = vtkIdTypeArray::New();
+  this->GeneLevelOffsets = vtkIdTypeArray::New();
+  this->GeneLevels = vtkFloatArray::New();
+  this->NumberOfUnmatchedRows = 0;
+  this->Matrix = 0;
+  this->Internals = new vtkCellGeneIndexInternals;
+}
+
+vtkCellGeneIndex::~vtkCellGeneIndex()
+{
+  this->GeneNames->Delete();
+  this->CellGeneOffsets->Delete();
+  this->CellGenes->Delete();
+  this->GeneCellOffsets->Delete();
+  this->GeneCells->Delete();
+  this->GeneLevelOffsets->Delete();
+  this->GeneLevels->Delete();
+  if (this->Matrix)
+    {
+    this->Matrix->Delete();
+    }
+  delete this->Internals;
+}
+
+void vtkCellGeneIndex::Initialize()
+{
+  this->GeneNames->Initialize();
+  this->CellGeneOffsets->Initialize();
+  this->CellGenes->Initialize();
+  this->GeneCellOffsets->Initialize();
+  this->GeneCells->Initialize();
+  this->GeneLevelOffsets->Initialize();
+  this->GeneLevels->Initialize();
+  this->NumberOfUnmatchedRows = 0;
+  if (this->Matrix)
+    {
+    this->Matrix->Delete();
+    this->Matrix = 0;
+    }
+  this->Internals->CellMarks.clear();
+  this->Internals->GeneMarks.clear();
+  this->Modified();
+}
+
+vtkIdType vtkCellGeneIndex::GetNumberOfCells()
+{
+  if (this->Matrix)
+    {
+    return this->Matrix->GetNumberOfRows();
+    }
+  vtkIdType numOffsets = this->CellGeneOffsets->GetNumberOfTuples();
+  return numOffsets > 0 ? numOffsets - 1 : 0;
+}
+
+vtkIdType vtkCellGeneIndex::GetNumberOfGenes()
+{
+  return this->GeneNames->GetNumberOfTuples();
+}
+
+vtkIdType vtkCellGeneIndex::GetGeneId(const char* name)
+{
+  if (!name)
+    {
+    return -1;
+    }
+  vtkIdType lo = 0;
+  vtkIdType hi = this->GetNumberOfGenes();
+  while (lo < hi)
+    {
+    vtkIdType mid = (lo + hi) / 2;
+    if (this->GeneNames->GetValue(mid) < name)
+      {
+      lo = mid + 1;
+      }
+    else
+      {
+      hi = mid;
+      }
+    }
+  return (lo < this->GetNumberOfGenes() && this->GeneNames->GetValue(lo) == name) ? lo : -1;
+}
+
+void vtkCellGeneIndex::Build(vtkStringArray* treeCellNames,
+  vtkStringArray* cellNames, vtkIdTypeArray* cells, vtkStringArray* geneNames,
+  vtkIdTypeArray* genes, vtkFloatArray* levels)
+{
+  if (!treeCellNames || !cellNames || !cells || !geneNames || !genes)
+    {
+    vtkErrorMacro("Need the cell names of the tree and the names and pairs read.");
+    this->Initialize();
+    return;
+    }
+
+  // Every name read is looked up once, then the pairs only go through ids.
+  vtkIdType numCells = treeCellNames->GetNumberOfTuples();
+  vtkIdType numRead = cellNames->GetNumberOfTuples();
+  vtksys_stl::vector<vtkIdType> pedigree;
+  vtkCellGeneIndexInternals::LookupCells(treeCellNames, cellNames, pedigree);
+
+  vtkIdType numPairs = cells->GetNumberOfTuples();
+  vtkSmartPointer<vtkIdTypeArray> treeCells = vtkSmartPointer<vtkIdTypeArray>::New();
+  treeCells->SetNumberOfValues(numPairs);
+  const vtkIdType* pairCells = cells->GetPointer(0);
+  vtkIdType* pairTreeCells = treeCells->GetPointer(0);
+  vtkIdType unmatched = 0;
+  for (vtkIdType i = 0; i < numPairs; ++i)
+    {
+    vtkIdType c = pairCells[i];
+    pairTreeCells[i] = (c >= 0 && c < numRead) ? pedigree[c] : -1;
+    unmatched += pairTreeCells[i] < 0;
+    }
+
+  this->Build(numCells, geneNames, treeCells, genes, levels);
+  this->NumberOfUnmatchedRows = unmatched;
+}
+
+void vtkCellGeneIndex::Build(vtkStringArray* treeCellNames,
+  vtkStringArray* cellNames, vtkStringArray* geneNames, vtkBitMatrix* matrix,
+  vtkFloatArray* levels)
+{
+  this->Initialize();
+  if (!treeCellNames || !cellNames || !geneNames || !matrix)
+    {
+    vtkErrorMacro("Need the cell names of the tree and the names and matrix read.");
+    return;
+    }
+
+  vtksys_stl::vector<vtkIdType> pedigree;
+  vtkCellGeneIndexInternals::LookupCells(treeCellNames, cellNames, pedigree);
+  vtksys_stl::vector<vtkIdType> rank;
+  vtkCellGeneIndexInternals::SortGenes(geneNames, this->GeneNames, rank);
+
+  // Move every row to its tree vertex and every column to its gene id.
+  vtkIdType numCells = treeCellNames->GetNumberOfTuples();
+  vtkIdType numGenes = this->GeneNames->GetNumberOfTuples();
+  vtkIdType numRead = static_cast<vtkIdType>(pedigree.size());
+  vtkIdType numColumns = matrix->GetNumberOfColumns();
+  this->Matrix = vtkBitMatrix::New();
+  this->Matrix->SetSize(numCells, numGenes);
+  vtkIdType unmatched = 0;
+  for (vtkIdType r = 0; r < matrix->GetNumberOfRows() && r < numRead; ++r)
+    {
+    if (pedigree[r] < 0)
+      {
+      unmatched += matrix->GetRowCount(r);
+      continue;
+      }
+    const vtkTypeUInt64* words = matrix->GetRow(r);
+    vtkTypeUInt64* row = this->Matrix->GetRow(pedigree[r]);
+    for (vtkIdType w = 0; w < matrix->GetWordsPerRow(); ++w)
+      {
+      for (vtkIdType c = w * 64; words[w] && c < (w + 1) * 64 && c < numColumns; ++c)
+        {
+        if ((words[w] >> (c % 64)) & 1)
+          {
+          row[rank[c] / 64] |= static_cast<vtkTypeUInt64>(1) << (rank[c] % 64);
+          }
+        }
+      }
+    }
+  this->Matrix->UpdateColumns();
+  this->NumberOfUnmatchedRows = unmatched;
+
+  // Levels follow the set bits of the rows read. Visiting the rows by
+  // tree vertex lays them out by gene with the cells of every gene in
+  // order.
+  vtkIdType numLevels = levels ? levels->GetNumberOfTuples() : 0;
+  if (numLevels > 0 && numLevels == matrix->GetNumberOfSetBits())
+    {
+    vtksys_stl::vector<vtkIdType> rowLevels(numRead + 1, 0);
+    vtksys_stl::vector<vtkIdType> rowOfCell(numCells, -1);
+    for (vtkIdType r = 0; r < numRead; ++r)
+      {
+      rowLevels[r + 1] = rowLevels[r] +
+        (r < matrix->GetNumberOfRows() ? matrix->GetRowCount(r) : 0);
+      if (pedigree[r] >= 0)
+        {
+        rowOfCell[pedigree[r]] = r;
+        }
+      }
+    this->GeneLevelOffsets->SetNumberOfValues(numGenes + 1);
+    vtkIdType* offsets = this->GeneLevelOffsets->GetPointer(0);
+    offsets[0] = 0;
+    for (vtkIdType g = 0; g < numGenes; ++g)
+      {
+      offsets[g + 1] = offsets[g] + this->Matrix->GetColumnCount(g);
+      }
+    this->GeneLevels->SetNumberOfValues(offsets[numGenes]);
+    float* geneLevels = this->GeneLevels->GetPointer(0);
+    const float* readLevels = levels->GetPointer(0);
+    vtksys_stl::vector<vtkIdType> fill(offsets, offsets + numGenes);
+    for (vtkIdType v = 0; v < numCells; ++v)
+      {
+      vtkIdType r = rowOfCell[v];
+      if (r < 0)
+        {
+        continue;
+        }
+      const vtkTypeUInt64* words = matrix->GetRow(r);
+      vtkIdType level = rowLevels[r];
+      for (vtkIdType w = 0; w < matrix->GetWordsPerRow(); ++w)
+        {
+        for (vtkIdType c = w * 64; words[w] && c < (w + 1) * 64 && c < numColumns; ++c)
+          {
+          if ((words[w] >> (c % 64)) & 1)
+            {
+            geneLevels[fill[rank[c]]++] = readLevels[level++];
+            }
+          }
+        }
+      }
+    }
+  this->Modified();
+}
+
+void vtkCellGeneIndex::Build(vtkStringArray* treeCellNames,
+  vtkStringArray* cellNames, vtkStringArray* geneNames,
+  vtkIdTypeArray* cellGeneOffsets, vtkIdTypeArray* cellGenes,
+  vtkIdTypeArray* geneCellOffsets, vtkIdTypeArray* geneCells)
+{
+  if (!treeCellNames || !cellNames || !geneNames || !cellGeneOffsets ||
+      !cellGenes || !geneCellOffsets || !geneCells ||
+      cellGeneOffsets->GetNumberOfTuples() != cellNames->GetNumberOfTuples() + 1 ||
+      geneCellOffsets->GetNumberOfTuples() != geneNames->GetNumberOfTuples() + 1)
+    {
+    vtkErrorMacro("Need the cell names of the tree and the names and adjacency read.");
+    this->Initialize();
+    return;
+    }
+  vtkIdType numRead = cellNames->GetNumberOfTuples();
+  vtkIdType numGenes = geneNames->GetNumberOfTuples();
+  const vtkIdType* readOffsets = cellGeneOffsets->GetPointer(0);
+  const vtkIdType* readGenes = cellGenes->GetNumberOfTuples() > 0 ?
+    cellGenes->GetPointer(0) : 0;
+
+  // Genes that are not in order get renumbered by the pair build.
+  bool sorted = true;
+  for (vtkIdType g = 1; sorted && g < numGenes; ++g)
+    {
+    sorted = !(geneNames->GetValue(g) < geneNames->GetValue(g - 1));
+    }
+  if (!sorted)
+    {
+    vtkSmartPointer<vtkIdTypeArray> cells = vtkSmartPointer<vtkIdTypeArray>::New();
+    cells->SetNumberOfValues(readOffsets[numRead]);
+    for (vtkIdType c = 0; c < numRead; ++c)
+      {
+      for (vtkIdType i = readOffsets[c]; i < readOffsets[c + 1]; ++i)
+        {
+        cells->SetValue(i, c);
+        }
+      }
+    this->Build(treeCellNames, cellNames, cells, geneNames, cellGenes);
+    return;
+    }
+
+  this->Initialize();
+  vtksys_stl::vector<vtkIdType> pedigree;
+  vtkCellGeneIndexInternals::LookupCells(treeCellNames, cellNames, pedigree);
+  this->GeneNames->SetNumberOfValues(numGenes);
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    this->GeneNames->SetValue(g, geneNames->GetValue(g));
+    }
+
+  // Rows of the cells read move to their tree vertex as they are.
+  vtkIdType numCells = treeCellNames->GetNumberOfTuples();
+  vtksys_stl::vector<vtkIdType> readOfCell(numCells, -1);
+  vtkIdType unmatched = 0;
+  for (vtkIdType c = 0; c < numRead; ++c)
+    {
+    if (pedigree[c] >= 0)
+      {
+      readOfCell[pedigree[c]] = c;
+      }
+    else
+      {
+      unmatched += readOffsets[c + 1] - readOffsets[c];
+      }
+    }
+  this->CellGeneOffsets->SetNumberOfValues(numCells + 1);
+  vtkIdType* cellOffsets = this->CellGeneOffsets->GetPointer(0);
+  cellOffsets[0] = 0;
+  for (vtkIdType v = 0; v < numCells; ++v)
+    {
+    vtkIdType c = readOfCell[v];
+    cellOffsets[v + 1] = cellOffsets[v] +
+      (c >= 0 ? readOffsets[c + 1] - readOffsets[c] : 0);
+    }
+  vtkIdType numEdges = cellOffsets[numCells];
+  this->CellGenes->SetNumberOfValues(numEdges);
+  vtkIdType* genesOfCells = numEdges > 0 ? this->CellGenes->GetPointer(0) : 0;
+  for (vtkIdType v = 0; v < numCells; ++v)
+    {
+    vtkIdType c = readOfCell[v];
+    if (c >= 0)
+      {
+      vtksys_stl::copy(readGenes + readOffsets[c], readGenes + readOffsets[c + 1],
+        genesOfCells + cellOffsets[v]);
+      }
+    }
+
+  // The cells of every gene get renamed to tree vertices, they only need
+  // sorting again where the tree numbers the cells in another order.
+  const vtkIdType* readGeneOffsets = geneCellOffsets->GetPointer(0);
+  const vtkIdType* readCells = geneCells->GetNumberOfTuples() > 0 ?
+    geneCells->GetPointer(0) : 0;
+  this->GeneCellOffsets->SetNumberOfValues(numGenes + 1);
+  this->GeneCells->SetNumberOfValues(numEdges);
+  vtkIdType* geneOffsets = this->GeneCellOffsets->GetPointer(0);
+  vtkIdType* cellsOfGenes = numEdges > 0 ? this->GeneCells->GetPointer(0) : 0;
+  vtkIdType numGeneEdges = 0;
+  geneOffsets[0] = 0;
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    bool inOrder = true;
+    for (vtkIdType i = readGeneOffsets[g]; i < readGeneOffsets[g + 1]; ++i)
+      {
+      vtkIdType c = readCells[i];
+      vtkIdType v = (c >= 0 && c < numRead) ? pedigree[c] : -1;
+      if (v >= 0 && numGeneEdges < numEdges)
+        {
+        inOrder = inOrder && (numGeneEdges == geneOffsets[g] ||
+          cellsOfGenes[numGeneEdges - 1] < v);
+        cellsOfGenes[numGeneEdges++] = v;
+        }
+      }
+    if (!inOrder)
+      {
+      vtksys_stl::sort(cellsOfGenes + geneOffsets[g], cellsOfGenes + numGeneEdges);
+      }
+    geneOffsets[g + 1] = numGeneEdges;
+    }
+  if (numGeneEdges != numEdges)
+    {
+    vtkErrorMacro("The cells of the genes do not match the genes of the cells.");
+    this->Initialize();
+    return;
+    }
+
+  this->NumberOfUnmatchedRows = unmatched;
+  this->Internals->CellMarks.assign(numCells, 0);
+  this->Internals->GeneMarks.assign(numGenes, 0);
+  this->Modified();
+}
+
+void vtkCellGeneIndex::Build(vtkIdType numCells, vtkStringArray* geneNames,
+  vtkIdTypeArray* cells, vtkIdTypeArray* genes, vtkFloatArray* levels)
+{
+  this->Initialize();
+  vtkIdType numGenes = geneNames->GetNumberOfTuples();
+  vtkIdType numPairs = cells->GetNumberOfTuples();
+
+  // Number the genes by name.
+  vtksys_stl::vector<vtkIdType> rank;
+  vtkCellGeneIndexInternals::SortGenes(geneNames, this->GeneNames, rank);
+
+  // Bucket the pairs by cell, then sort and deduplicate every bucket.
+  this->CellGeneOffsets->SetNumberOfValues(numCells + 1);
+  vtkIdType* cellOffsets = this->CellGeneOffsets->GetPointer(0);
+  vtksys_stl::fill(cellOffsets, cellOffsets + numCells + 1, 0);
+  const vtkIdType* pairCells = cells->GetPointer(0);
+  const vtkIdType* pairGenes = genes->GetPointer(0);
+  for (vtkIdType i = 0; i < numPairs; ++i)
+    {
+    if (pairCells[i] >= 0 && pairCells[i] < numCells &&
+        pairGenes[i] >= 0 && pairGenes[i] < numGenes)
+      {
+      ++cellOffsets[pairCells[i] + 1];
+      }
+    }
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    cellOffsets[c + 1] += cellOffsets[c];
+    }
+  vtksys_stl::vector<vtkIdType> fill(cellOffsets, cellOffsets + numCells);
+  const float* pairLevels =
+    (levels && levels->GetNumberOfTuples() == numPairs && numPairs > 0) ?
+    levels->GetPointer(0) : 0;
+  vtksys_stl::vector<float> cellLevels;
+  vtkIdType numEdges = 0;
+  if (!pairLevels)
+    {
+    vtksys_stl::vector<vtkIdType> cellGenes(cellOffsets[numCells]);
+    for (vtkIdType i = 0; i < numPairs; ++i)
+      {
+      if (pairCells[i] >= 0 && pairCells[i] < numCells &&
+          pairGenes[i] >= 0 && pairGenes[i] < numGenes)
+        {
+        cellGenes[fill[pairCells[i]]++] = rank[pairGenes[i]];
+        }
+      }
+    for (vtkIdType c = 0; c < numCells; ++c)
+      {
+      vtksys_stl::vector<vtkIdType>::iterator begin = cellGenes.begin() + cellOffsets[c];
+      vtksys_stl::vector<vtkIdType>::iterator end = cellGenes.begin() + cellOffsets[c + 1];
+      vtksys_stl::sort(begin, end);
+      end = vtksys_stl::unique(begin, end);
+      cellOffsets[c] = numEdges;
+      numEdges = static_cast<vtkIdType>(
+        vtksys_stl::copy(begin, end, cellGenes.begin() + numEdges) - cellGenes.begin());
+      }
+    this->CellGenes->SetNumberOfValues(numEdges);
+    vtksys_stl::copy(cellGenes.begin(), cellGenes.begin() + numEdges,
+      this->CellGenes->GetPointer(0));
+    }
+  else
+    {
+    // Same with the pair index next to every gene, so that the level of
+    // the last of repeated pairs is kept.
+    vtksys_stl::vector<vtksys_stl::pair<vtkIdType, vtkIdType> > cellGenes(cellOffsets[numCells]);
+    for (vtkIdType i = 0; i < numPairs; ++i)
+      {
+      if (pairCells[i] >= 0 && pairCells[i] < numCells &&
+          pairGenes[i] >= 0 && pairGenes[i] < numGenes)
+        {
+        cellGenes[fill[pairCells[i]]++] = vtksys_stl::make_pair(rank[pairGenes[i]], i);
+        }
+      }
+    this->CellGenes->SetNumberOfValues(cellOffsets[numCells]);
+    cellLevels.resize(cellOffsets[numCells]);
+    vtkIdType* genesOfCells = this->CellGenes->GetPointer(0);
+    for (vtkIdType c = 0; c < numCells; ++c)
+      {
+      vtkIdType begin = cellOffsets[c];
+      vtkIdType end = cellOffsets[c + 1];
+      vtksys_stl::sort(cellGenes.begin() + begin, cellGenes.begin() + end);
+      cellOffsets[c] = numEdges;
+      for (vtkIdType i = begin; i < end; ++i)
+        {
+        if (i + 1 < end && cellGenes[i + 1].first == cellGenes[i].first)
+          {
+          continue;
+          }
+        genesOfCells[numEdges] = cellGenes[i].first;
+        cellLevels[numEdges++] = pairLevels[cellGenes[i].second];
+        }
+      }
+    this->CellGenes->SetNumberOfValues(numEdges);
+    }
+  cellOffsets[numCells] = numEdges;
+
+  // Transpose, visiting cells in order keeps the cells of every gene sorted.
+  this->GeneCellOffsets->SetNumberOfValues(numGenes + 1);
+  vtkIdType* geneOffsets = this->GeneCellOffsets->GetPointer(0);
+  vtksys_stl::fill(geneOffsets, geneOffsets + numGenes + 1, 0);
+  const vtkIdType* genesOfCells = this->CellGenes->GetPointer(0);
+  for (vtkIdType i = 0; i < numEdges; ++i)
+    {
+    ++geneOffsets[genesOfCells[i] + 1];
+    }
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    geneOffsets[g + 1] += geneOffsets[g];
+    }
+  this->GeneCells->SetNumberOfValues(numEdges);
+  vtkIdType* geneCells = this->GeneCells->GetPointer(0);
+  fill.assign(geneOffsets, geneOffsets + numGenes);
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    for (vtkIdType i = cellOffsets[c]; i < cellOffsets[c + 1]; ++i)
+      {
+      geneCells[fill[genesOfCells[i]]++] = c;
+      }
+    }
+  if (pairLevels)
+    {
+    this->GeneLevelOffsets->DeepCopy(this->GeneCellOffsets);
+    this->GeneLevels->SetNumberOfValues(numEdges);
+    float* geneLevels = this->GeneLevels->GetPointer(0);
+    fill.assign(geneOffsets, geneOffsets + numGenes);
+    for (vtkIdType i = 0; i < numEdges; ++i)
+      {
+      geneLevels[fill[genesOfCells[i]]++] = cellLevels[i];
+      }
+    }
+
+  this->Internals->CellMarks.assign(numCells, 0);
+  this->Internals->GeneMarks.assign(numGenes, 0);
+  this->Modified();
+}
+
+void vtkCellGeneIndex::GetCellsOfGenes(vtkIdTypeArray* genes, vtkIdTypeArray* result)
+{
+  if (this->Matrix)
+    {
+    this->Matrix->GetRowsOfColumns(genes, result);
+    return;
+    }
+  if (this->GetNumberOfGenes() == 0)
+    {
+    return;
+    }
+  vtkCellGeneIndexInternals::Collect(this->GeneCellOffsets->GetPointer(0),
+    this->GeneCells->GetPointer(0), this->GetNumberOfGenes(), genes,
+    this->Internals->CellMarks, result);
+}
+
+void vtkCellGeneIndex::GetGenesOfCells(vtkIdTypeArray* cells, vtkIdTypeArray* result)
+{
+  if (this->Matrix)
+    {
+    this->Matrix->GetColumnsOfRows(cells, result);
+    return;
+    }
+  if (this->GetNumberOfCells() == 0)
+    {
+    return;
+    }
+  vtkCellGeneIndexInternals::Collect(this->CellGeneOffsets->GetPointer(0),
+    this->CellGenes->GetPointer(0), this->GetNumberOfCells(), cells,
+    this->Internals->GeneMarks, result);
+}
+
+vtkIdType vtkCellGeneIndex::GetNumberOfCellsOfGene(vtkIdType gene)
+{
+  if (gene < 0 || gene >= this->GetNumberOfGenes())
+    {
+    return 0;
+    }
+  if (this->Matrix)
+    {
+    return this->Matrix->GetColumnCount(gene);
+    }
+  return this->GeneCellOffsets->GetValue(gene + 1) -
+    this->GeneCellOffsets->GetValue(gene);
+}
+
+int vtkCellGeneIndex::HasLevels()
+{
+  return this->GeneLevelOffsets->GetNumberOfTuples() > 0;
+}
+
+void vtkCellGeneIndex::GetGeneLevels(vtkIdType gene, vtkFloatArray* cellLevels)
+{
+  vtkIdType numCells = this->GetNumberOfCells();
+  cellLevels->SetNumberOfValues(numCells);
+  float* result = numCells > 0 ? cellLevels->GetPointer(0) : 0;
+  vtksys_stl::fill(result, result + numCells, 0.0f);
+  if (gene < 0 || gene >= this->GetNumberOfGenes())
+    {
+    return;
+    }
+  bool hasLevels = this->HasLevels() != 0;
+  const float* levels = hasLevels ?
+    this->GeneLevels->GetPointer(0) + this->GeneLevelOffsets->GetValue(gene) : 0;
+  if (this->Matrix)
+    {
+    const vtkTypeUInt64* words = this->Matrix->GetColumn(gene);
+    for (vtkIdType w = 0; w < this->Matrix->GetWordsPerColumn(); ++w)
+      {
+      for (vtkIdType c = w * 64; words[w] && c < (w + 1) * 64 && c < numCells; ++c)
+        {
+        if ((words[w] >> (c % 64)) & 1)
+          {
+          result[c] = hasLevels ? *levels++ : 1.0f;
+          }
+        }
+      }
+    return;
+    }
+  const vtkIdType* cells = this->GeneCells->GetPointer(0);
+  for (vtkIdType i = this->GeneCellOffsets->GetValue(gene);
+       i < this->GeneCellOffsets->GetValue(gene + 1); ++i)
+    {
+    result[cells[i]] = hasLevels ? *levels++ : 1.0f;
+    }
+}
+
+void vtkCellGeneIndex::GetGeneMinimum(vtkDataArray* cellValues, vtkDoubleArray* result)
+{
+  vtkIdType numGenes = this->GetNumberOfGenes();
+  result->SetNumberOfValues(numGenes);
+  double* minimum = numGenes > 0 ? result->GetPointer(0) : 0;
+  vtksys_stl::fill(minimum, minimum + numGenes, VTK_DOUBLE_MAX);
+  vtkIdType numCells = vtksys_stl::min(this->GetNumberOfCells(),
+    cellValues ? cellValues->GetNumberOfTuples() : 0);
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    double value = cellValues->GetTuple1(c);
+    if (this->Matrix)
+      {
+      const vtkTypeUInt64* words = this->Matrix->GetRow(c);
+      for (vtkIdType w = 0; w < this->Matrix->GetWordsPerRow(); ++w)
+        {
+        for (vtkIdType g = w * 64; words[w] && g < (w + 1) * 64 && g < numGenes; ++g)
+          {
+          if (((words[w] >> (g % 64)) & 1) && value < minimum[g])
+            {
+            minimum[g] = value;
+            }
+          }
+        }
+      }
+    else
+      {
+      const vtkIdType* offsets = this->CellGeneOffsets->GetPointer(0);
+      const vtkIdType* genes = this->CellGenes->GetPointer(0);
+      for (vtkIdType i = offsets[c]; i < offsets[c + 1]; ++i)
+        {
+        if (value < minimum[genes[i]])
+          {
+          minimum[genes[i]] = value;
+          }
+        }
+      }
+    }
+}
+
+void vtkCellGeneIndex::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "NumberOfCells: " << this->GetNumberOfCells() << endl;
+  os << indent << "NumberOfGenes: " << this->GetNumberOfGenes() << endl;
+  os << indent << "NumberOfEdges: " << (this->Matrix ?
+    this->Matrix->GetNumberOfSetBits() : this->CellGenes->GetNumberOfTuples()) << endl;
+  os << indent << "NumberOfLevels: " << this->GeneLevels->GetNumberOfTuples() << endl;
+  os << indent << "NumberOfUnmatchedRows: " << this->NumberOfUnmatchedRows << endl;
+}
@@ -0,0 +1,170 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkCellGeneIndex - cell to gene expression adjacency
+//
+// .SECTION Description
+// vtkCellGeneIndex holds which genes are expressed in which cells as two
+// compressed sparse row arrays, one listing the genes of every cell and
+// one the cells of every gene. Cells are identified by their pedigree id
+// in the lineage tree (the vertex id in the tree as read), genes by their
+// position in the sorted table of gene names, so that going from cells to
+// genes and back only walks integer arrays. Names are only looked at once,
+// when the index is built.
+//
+// An index built from a dense expression matrix keeps it as a vtkBitMatrix
+// of cells by genes instead of the sparse rows, queries then or the words
+// of the matrix rows or columns.
+
+#ifndef __vtkCellGeneIndex_h
+#define __vtkCellGeneIndex_h
+
+#include "vtkObject.h"
+
+class vtkBitMatrix;
+class vtkDataArray;
+class vtkDoubleArray;
+class vtkFloatArray;
+class vtkIdTypeArray;
+class vtkStringArray;
+class vtkCellGeneIndexInternals;
+
+class vtkCellGeneIndex : public vtkObject
+{
+public:
+  static vtkCellGeneIndex *New();
+  vtkTypeRevisionMacro(vtkCellGeneIndex,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Build the index from pairs of cell and gene ids as read by
+  // vtkGeneExpressionReader, cells being indices into cellNames. Cells are
+  // matched by name to the treeCellNames array of the tree, pairs of cells
+  // that are not in the tree are counted in NumberOfUnmatchedRows.
+  // levels, if given, holds the expression level of every pair.
+  void Build(vtkStringArray* treeCellNames, vtkStringArray* cellNames,
+             vtkIdTypeArray* cells, vtkStringArray* geneNames,
+             vtkIdTypeArray* genes, vtkFloatArray* levels = 0);
+
+  // Description:
+  // Build the index from a cells by genes matrix read by
+  // vtkGeneExpressionReader, row r being cell cellNames[r] and column g
+  // gene geneNames[g]. Cells are matched by name to the treeCellNames
+  // array of the tree. The index then keeps a bit matrix rather than the
+  // sparse rows. levels, if given, holds the level of every set bit of
+  // the matrix, row by row.
+  void Build(vtkStringArray* treeCellNames, vtkStringArray* cellNames,
+             vtkStringArray* geneNames, vtkBitMatrix* matrix,
+             vtkFloatArray* levels = 0);
+
+  // Description:
+  // Build the index from the adjacency of a binary file read by
+  // vtkGeneExpressionReader: the sorted genes of every cell of cellNames
+  // and the sorted cells of every gene, as offsets and values. Cells are
+  // matched by name to the treeCellNames array of the tree. When
+  // geneNames is sorted, as in files written by TableToAdjacencyList, the
+  // rows are copied over without sorting any pair.
+  void Build(vtkStringArray* treeCellNames, vtkStringArray* cellNames,
+             vtkStringArray* geneNames, vtkIdTypeArray* cellGeneOffsets,
+             vtkIdTypeArray* cellGenes, vtkIdTypeArray* geneCellOffsets,
+             vtkIdTypeArray* geneCells);
+
+  // Description:
+  // Build the index from the gene names and pairs of cell pedigree ids and
+  // gene ids (indices into geneNames). Gene names are sorted and the gene
+  // ids renumbered accordingly, repeated pairs are stored once, with the
+  // level of the last one when levels are given.
+  void Build(vtkIdType numberOfCells, vtkStringArray* geneNames,
+             vtkIdTypeArray* cells, vtkIdTypeArray* genes,
+             vtkFloatArray* levels = 0);
+
+  // Description:
+  // Forget the index.
+  void Initialize();
+
+  // Description:
+  // The number of cells (tree vertices) and genes indexed.
+  vtkIdType GetNumberOfCells();
+  vtkIdType GetNumberOfGenes();
+
+  // Description:
+  // The sorted gene names, gene ids index into this array.
+  vtkGetObjectMacro(GeneNames, vtkStringArray);
+
+  // Description:
+  // The id of a gene, -1 if there is no such gene.
+  vtkIdType GetGeneId(const char* name);
+
+  // Description:
+  // The genes of cell c are CellGenes[CellGeneOffsets[c],
+  // CellGeneOffsets[c + 1]), sorted. Same for the cells of a gene. Empty
+  // when the index keeps a Matrix.
+  vtkGetObjectMacro(CellGeneOffsets, vtkIdTypeArray);
+  vtkGetObjectMacro(CellGenes, vtkIdTypeArray);
+  vtkGetObjectMacro(GeneCellOffsets, vtkIdTypeArray);
+  vtkGetObjectMacro(GeneCells, vtkIdTypeArray);
+
+  // Description:
+  // The cells by genes bit matrix of an index built from a matrix, null
+  // otherwise.
+  vtkGetObjectMacro(Matrix, vtkBitMatrix);
+
+  // Description:
+  // Expression levels stored by gene: those of gene g are
+  // GeneLevels[GeneLevelOffsets[g], GeneLevelOffsets[g + 1]), one per cell
+  // expressing it in increasing cell order. Empty when the index was built
+  // without levels.
+  vtkGetObjectMacro(GeneLevelOffsets, vtkIdTypeArray);
+  vtkGetObjectMacro(GeneLevels, vtkFloatArray);
+  int HasLevels();
+
+  // Description:
+  // Set cellLevels, indexed by cell, to the level of a gene in every
+  // cell: 0 where it is not expressed, 1 where it is if the index has no
+  // levels.
+  void GetGeneLevels(vtkIdType gene, vtkFloatArray* cellLevels);
+
+  // Description:
+  // Append to result the cells expressing any of the given genes, or the
+  // genes expressed in any of the given cells, each once. Ids out of range
+  // are skipped.
+  void GetCellsOfGenes(vtkIdTypeArray* genes, vtkIdTypeArray* result);
+  void GetGenesOfCells(vtkIdTypeArray* cells, vtkIdTypeArray* result);
+
+  // Description:
+  // The number of cells expressing a gene.
+  vtkIdType GetNumberOfCellsOfGene(vtkIdType gene);
+
+  // Description:
+  // Set result[g] to the smallest value of cellValues (indexed by cell)
+  // over the cells expressing gene g, VTK_DOUBLE_MAX for genes expressed
+  // nowhere. With the StartTime array of the tree this is the onset time
+  // of every gene.
+  void GetGeneMinimum(vtkDataArray* cellValues, vtkDoubleArray* result);
+
+  // Description:
+  // Number of table rows, pairs or matrix entries whose cell was not
+  // found in the tree during the last Build.
+  vtkGetMacro(NumberOfUnmatchedRows, vtkIdType);
+
+protected:
+  vtkCellGeneIndex();
+  ~vtkCellGeneIndex();
+
+  vtkStringArray* GeneNames;
+  vtkIdTypeArray* CellGeneOffsets;
+  vtkIdTypeArray* CellGenes;
+  vtkIdTypeArray* GeneCellOffsets;
+  vtkIdTypeArray* GeneCells;
+  vtkIdTypeArray* GeneLevelOffsets;
+  vtkFloatArray* GeneLevels;
+  vtkIdType NumberOfUnmatchedRows;
+  vtkBitMatrix* Matrix;
+  vtkCellGeneIndexInternals* Internals;
+
+private:
+  vtkCellGeneIndex(const vtkCellGeneIndex&);  // Not implemented.
+  void operator=(const vtkCellGeneIndex&);  // Not implemented.
+};
+
+#endif
@@ -10,11 +10,15 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkSmartPointer.h"
 #include "vtkStringArray.h"
 
+#include <math.h>
 #include <vtksys/stl/map>
+#include <vtksys/stl/vector>
 
 vtkCxxRevisionMacro(vtkElbowGraphToPolyData, "$Revision$");
 vtkStandardNewMacro(vtkElbowGraphToPolyData);
@@ -32,6 +36,7 @@ public:
   void Initialize();
   vtkStringArray* InputNamesArray;
   vtkStringArray* OutputNamesArray;
+  vtkIdTypeArray* OutputLabelIndex;
 };
 
 vtkIdType vtkElbowGraphToPolyDataInternal::AddEdge(vtkGraph*
@@ -117,6 +122,10 @@ vtkIdType vtkElbowGraphToPolyDataInternal::StorePoint(double point[3],
       this->OutputNamesArray->SetValue(newPtIdx, this->InputNamesArray->GetValue(copyNames));
       }
     }
+  if ( this->OutputLabelIndex )
+    {
+    this->OutputLabelIndex->InsertValue(newPtIdx, removeLabel ? -1 : copyNames);
+    }
   return newPtIdx;
 }
 
@@ -125,6 +134,186 @@ void vtkElbowGraphToPolyDataInternal::Initialize()
   this->PointMapping.erase(this->PointMapping.begin(), this->PointMapping.end());
   this->InputNamesArray = 0;
   this->OutputNamesArray = 0;
+  this->OutputLabelIndex = 0;
+}
+
+// Shared state of the threads tessellating the curved edges. The first pass
+// counts the segments of every edge, the second one evaluates the curves
+// straight into the output point and connectivity arrays.
+class vtkElbowGraphToPolyDataCurves
+{
+public:
+  enum
+    {
+    COUNT_PASS,
+    EVALUATE_PASS
+    };
+
+  int Pass;
+  vtkIdType NumberOfEdges;
+  const vtkIdType* Sources;
+  const vtkIdType* Targets;
+  const double* VertexPoints;
+  const vtkIdType* VertexPointIds;
+  double XFactor;
+  double YFactor;
+  int Arc;
+  double MaximumSegmentLength;
+  int MaximumNumberOfSegments;
+
+  int* Segments;
+  const vtkIdType* InteriorOffsets;
+  const vtkIdType* CellOffsets;
+  float* OutputPoints;
+  vtkIdType* Connectivity;
+
+  void CountSegments(vtkIdType begin, vtkIdType end);
+  void Evaluate(vtkIdType begin, vtkIdType end);
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg);
+};
+
+VTK_THREAD_RETURN_TYPE vtkElbowGraphToPolyDataCurves::Execute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkElbowGraphToPolyDataCurves* self =
+    static_cast<vtkElbowGraphToPolyDataCurves*>(info->UserData);
+  vtkIdType begin = self->NumberOfEdges * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end = self->NumberOfEdges * (info->ThreadID + 1) / info->NumberOfThreads;
+  if (self->Pass == COUNT_PASS)
+    {
+    self->CountSegments(begin, end);
+    }
+  else
+    {
+    self->Evaluate(begin, end);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Polar angle of a point and the signed angle going from a to b.
+static inline double vtkElbowGraphToPolyDataAngle(const double p[3])
+{
+  return atan2(p[1], p[0]);
+}
+
+static inline double vtkElbowGraphToPolyDataDeltaAngle(double a, double b)
+{
+  double delta = b - a;
+  double pi = vtkMath::DoublePi();
+  while (delta > pi)
+    {
+    delta -= 2.0*pi;
+    }
+  while (delta < -pi)
+    {
+    delta += 2.0*pi;
+    }
+  return delta;
+}
+
+void vtkElbowGraphToPolyDataCurves::CountSegments(vtkIdType begin, vtkIdType end)
+{
+  for (vtkIdType i = begin; i < end; ++i)
+    {
+    const double* s = this->VertexPoints + 3*this->Sources[i];
+    const double* t = this->VertexPoints + 3*this->Targets[i];
+    double length;
+    if (this->Arc)
+      {
+      double rs = sqrt(s[0]*s[0] + s[1]*s[1]);
+      double rt = sqrt(t[0]*t[0] + t[1]*t[1]);
+      double da = vtkElbowGraphToPolyDataDeltaAngle(
+        vtkElbowGraphToPolyDataAngle(s), vtkElbowGraphToPolyDataAngle(t));
+      length = fabs(rt - rs) + (rs > rt ? rs : rt)*fabs(da);
+      }
+    else
+      {
+      // Average of the chord and the control polygon, a close upper
+      // estimate of the length of a quadratic Bezier curve.
+      double c[2];
+      c[0] = s[0]*this->XFactor + t[0]*(1 - this->XFactor);
+      c[1] = s[1]*this->YFactor + t[1]*(1 - this->YFactor);
+      length = 0.5*(
+        sqrt((c[0]-s[0])*(c[0]-s[0]) + (c[1]-s[1])*(c[1]-s[1])) +
+        sqrt((t[0]-c[0])*(t[0]-c[0]) + (t[1]-c[1])*(t[1]-c[1])) +
+        sqrt((t[0]-s[0])*(t[0]-s[0]) + (t[1]-s[1])*(t[1]-s[1])));
+      }
+    double n = ceil(length / this->MaximumSegmentLength);
+    if (n > this->MaximumNumberOfSegments)
+      {
+      n = this->MaximumNumberOfSegments;
+      }
+    // At least two segments so that every curve has a midpoint to
+    // carry the label, as in elbow mode.
+    this->Segments[i] = n < 2 ? 2 : static_cast<int>(n);
+    }
+}
+
+void vtkElbowGraphToPolyDataCurves::Evaluate(vtkIdType begin, vtkIdType end)
+{
+  for (vtkIdType i = begin; i < end; ++i)
+    {
+    const double* s = this->VertexPoints + 3*this->Sources[i];
+    const double* t = this->VertexPoints + 3*this->Targets[i];
+    int n = this->Segments[i];
+    double dt = 1.0 / n;
+
+    vtkIdType* cell = this->Connectivity + this->CellOffsets[i];
+    vtkIdType first = this->InteriorOffsets[i];
+    cell[0] = n + 1;
+    cell[1] = this->VertexPointIds[this->Sources[i]];
+    for (int k = 1; k < n; ++k)
+      {
+      cell[k + 1] = first + k - 1;
+      }
+    cell[n + 1] = this->VertexPointIds[this->Targets[i]];
+
+    float* out = this->OutputPoints + 3*first;
+    if (this->Arc)
+      {
+      double rs = sqrt(s[0]*s[0] + s[1]*s[1]);
+      double rt = sqrt(t[0]*t[0] + t[1]*t[1]);
+      double as = vtkElbowGraphToPolyDataAngle(s);
+      double at = vtkElbowGraphToPolyDataAngle(t);
+      // The root usually sits on the origin where the angle is meaningless.
+      if (rs == 0.0)
+        {
+        as = at;
+        }
+      double da = vtkElbowGraphToPolyDataDeltaAngle(as, at);
+      for (int k = 1; k < n; ++k)
+        {
+        double u = k*dt;
+        double r = rs + (rt - rs)*u;
+        double a = as + da*u;
+        out[0] = static_cast<float>(r*cos(a));
+        out[1] = static_cast<float>(r*sin(a));
+        out[2] = static_cast<float>(s[2] + (t[2] - s[2])*u);
+        out += 3;
+        }
+      }
+    else
+      {
+      double c[3];
+      c[0] = s[0]*this->XFactor + t[0]*(1 - this->XFactor);
+      c[1] = s[1]*this->YFactor + t[1]*(1 - this->YFactor);
+      c[2] = (s[2] + t[2])/2;
+      for (int k = 1; k < n; ++k)
+        {
+        double u = k*dt;
+        double v = 1.0 - u;
+        double b0 = v*v;
+        double b1 = 2.0*u*v;
+        double b2 = u*u;
+        out[0] = static_cast<float>(b0*s[0] + b1*c[0] + b2*t[0]);
+        out[1] = static_cast<float>(b0*s[1] + b1*c[1] + b2*t[1]);
+        out[2] = static_cast<float>(b0*s[2] + b1*c[2] + b2*t[2]);
+        out += 3;
+        }
+      }
+    }
 }
 
 vtkElbowGraphToPolyData::vtkElbowGraphToPolyData()
@@ -132,6 +321,11 @@ vtkElbowGraphToPolyData::vtkElbowGraphToPolyData()
   this->Internals = new vtkElbowGraphToPolyDataInternal;
   this->Factor = 0;
   this->Elbow = 0;
+  this->Curve = 0;
+  this->Arc = 0;
+  this->MaximumSegmentLength = 0.01;
+  this->MaximumNumberOfSegments = 32;
+  this->SparseLabels = 0;
 }
 
 vtkElbowGraphToPolyData::~vtkElbowGraphToPolyData()
@@ -145,6 +339,11 @@ void vtkElbowGraphToPolyData::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
   os << indent << "Factor " << this->Factor << endl;
   os << indent << "Elbow " << (this->Elbow?"ON":"OFF") << endl;
+  os << indent << "Curve " << (this->Curve?"ON":"OFF") << endl;
+  os << indent << "Arc " << (this->Arc?"ON":"OFF") << endl;
+  os << indent << "MaximumSegmentLength " << this->MaximumSegmentLength << endl;
+  os << indent << "MaximumNumberOfSegments " << this->MaximumNumberOfSegments << endl;
+  os << indent << "SparseLabels " << (this->SparseLabels?"ON":"OFF") << endl;
 }
 
 int vtkElbowGraphToPolyData::RequestData(
@@ -152,10 +351,6 @@ int vtkElbowGraphToPolyData::RequestData(
   vtkInformationVector **inputVector,
   vtkInformationVector *outputVector)
 {
-  if ( !this->Elbow )
-    {
-    return this->Superclass::RequestData(request, inputVector, outputVector);
-    }
   this->Internals->Initialize();
   // get the info objects
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
@@ -166,6 +361,36 @@ int vtkElbowGraphToPolyData::RequestData(
     inInfo->Get(vtkDataObject::DATA_OBJECT()));
   vtkPolyData *output = vtkPolyData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  // Sparse labels share the name array as a table instead of copying it,
+  // the output keeps the flag until it is turned back on.
+  if ( this->SparseLabels )
+    {
+    output->GetPointData()->CopyFieldOff("name");
+    }
+  else
+    {
+    output->GetPointData()->CopyFieldOn("name");
+    }
+  if ( !this->Elbow && !this->Curve )
+    {
+    int ret = this->Superclass::RequestData(request, inputVector, outputVector);
+    if ( ret && this->SparseLabels )
+      {
+      // Points and vertices match one to one.
+      vtkIdTypeArray* labelIndex = this->PrepareSparseLabels(input, output);
+      vtkIdType numPts = output->GetNumberOfPoints();
+      labelIndex->SetNumberOfValues(numPts);
+      for (vtkIdType i = 0; i < numPts; i++)
+        {
+        labelIndex->SetValue(i, i);
+        }
+      }
+    return ret;
+    }
+  if ( this->Curve )
+    {
+    return this->RequestCurves(input, output);
+    }
   vtkIdType numPts = input->GetNumberOfVertices();
   output->GetPointData()->CopyAllocate(input->GetVertexData(), 4*numPts);
 
@@ -191,6 +416,10 @@ int vtkElbowGraphToPolyData::RequestData(
     input->GetVertexData()->GetAbstractArray("name"));
   this->Internals->OutputNamesArray = vtkStringArray::SafeDownCast(
     output->GetPointData()->GetAbstractArray("name"));
+  if ( this->SparseLabels )
+    {
+    this->Internals->OutputLabelIndex = this->PrepareSparseLabels(input, output);
+    }
 
   //vtkIdType points[2];
 
@@ -222,3 +451,197 @@ int vtkElbowGraphToPolyData::RequestData(
   return 1;
 }
 
+
+int vtkElbowGraphToPolyData::RequestCurves(vtkGraph* input, vtkPolyData* output)
+{
+  vtkDataArray* edgeGhostLevels = vtkDataArray::SafeDownCast(
+    input->GetVertexData()->GetAbstractArray("vtkGhostLevels"));
+
+  // Only create curves for non-ghost edges
+  vtkIdType numEdges = input->GetNumberOfEdges();
+  vtksys_stl::vector<vtkIdType> edges;
+  edges.reserve(numEdges);
+  for (vtkIdType i = 0; i < numEdges; i++)
+    {
+    if (edgeGhostLevels == NULL || edgeGhostLevels->GetComponent(i, 0) == 0)
+      {
+      edges.push_back(i);
+      }
+    }
+  vtkIdType numCurves = static_cast<vtkIdType>(edges.size());
+
+  // Gather the vertex coordinates so the threads read plain memory and give
+  // every vertex used by an edge its output point, in order of appearance.
+  vtkIdType numVertices = input->GetNumberOfVertices();
+  vtksys_stl::vector<double> vertexPoints(3*numVertices + 3);
+  for (vtkIdType v = 0; v < numVertices; v++)
+    {
+    input->GetPoint(v, &vertexPoints[3*v]);
+    }
+  vtksys_stl::vector<vtkIdType> sources(numCurves + 1);
+  vtksys_stl::vector<vtkIdType> targets(numCurves + 1);
+  vtksys_stl::vector<vtkIdType> vertexPointIds(numVertices + 1, -1);
+  vtksys_stl::vector<vtkIdType> vertexOrder;
+  vertexOrder.reserve(numVertices);
+  for (vtkIdType i = 0; i < numCurves; i++)
+    {
+    sources[i] = input->GetSourceVertex(edges[i]);
+    targets[i] = input->GetTargetVertex(edges[i]);
+    vtkIdType ends[2] = { sources[i], targets[i] };
+    for (int e = 0; e < 2; e++)
+      {
+      if (vertexPointIds[ends[e]] < 0)
+        {
+        vertexPointIds[ends[e]] = static_cast<vtkIdType>(vertexOrder.size());
+        vertexOrder.push_back(ends[e]);
+        }
+      }
+    }
+  vtkIdType numVertexPoints = static_cast<vtkIdType>(vertexOrder.size());
+
+  vtkElbowGraphToPolyDataCurves curves;
+  curves.NumberOfEdges = numCurves;
+  curves.Sources = &sources[0];
+  curves.Targets = &targets[0];
+  curves.VertexPoints = &vertexPoints[0];
+  curves.VertexPointIds = &vertexPointIds[0];
+  curves.XFactor = this->Factor >= 0 ? this->Factor : 1;
+  curves.YFactor = this->Factor >= 0 ? 1 : -this->Factor;
+  curves.Arc = this->Arc;
+  curves.MaximumSegmentLength = this->MaximumSegmentLength;
+  curves.MaximumNumberOfSegments = this->MaximumNumberOfSegments;
+
+  vtkSmartPointer<vtkMultiThreader> threader =
+    vtkSmartPointer<vtkMultiThreader>::New();
+  if (numCurves < 1024)
+    {
+    threader->SetNumberOfThreads(1);
+    }
+  threader->SetSingleMethod(vtkElbowGraphToPolyDataCurves::Execute, &curves);
+
+  // Count the segments of every curve, then lay out the interior points
+  // after the vertex points and the cells in the connectivity array.
+  vtksys_stl::vector<int> segments(numCurves + 1);
+  curves.Segments = &segments[0];
+  curves.Pass = vtkElbowGraphToPolyDataCurves::COUNT_PASS;
+  threader->SingleMethodExecute();
+
+  vtksys_stl::vector<vtkIdType> interiorOffsets(numCurves + 1);
+  vtksys_stl::vector<vtkIdType> cellOffsets(numCurves + 1);
+  vtkIdType numPoints = numVertexPoints;
+  vtkIdType connectivitySize = 0;
+  for (vtkIdType i = 0; i < numCurves; i++)
+    {
+    interiorOffsets[i] = numPoints;
+    cellOffsets[i] = connectivitySize;
+    numPoints += segments[i] - 1;
+    connectivitySize += segments[i] + 2;
+    }
+
+  vtkPoints* outputPoints = vtkPoints::New();
+  outputPoints->SetDataTypeToFloat();
+  outputPoints->SetNumberOfPoints(numPoints);
+  output->SetPoints(outputPoints);
+  outputPoints->Delete();
+  for (vtkIdType p = 0; p < numVertexPoints; p++)
+    {
+    outputPoints->SetPoint(p, &vertexPoints[3*vertexOrder[p]]);
+    }
+
+  vtkIdTypeArray* connectivity = vtkIdTypeArray::New();
+  connectivity->SetNumberOfValues(connectivitySize);
+
+  curves.InteriorOffsets = &interiorOffsets[0];
+  curves.CellOffsets = &cellOffsets[0];
+  curves.OutputPoints = static_cast<float*>(outputPoints->GetVoidPointer(0));
+  curves.Connectivity = connectivity->GetPointer(0);
+  curves.Pass = vtkElbowGraphToPolyDataCurves::EVALUATE_PASS;
+  threader->SingleMethodExecute();
+
+  vtkCellArray* newLines = vtkCellArray::New();
+  newLines->SetCells(numCurves, connectivity);
+  output->SetLines(newLines);
+  newLines->Delete();
+  connectivity->Delete();
+
+  // Copy the vertex data. As with elbows, the vertex points carry no label
+  // and the middle of each curve is labeled with the target vertex name.
+  vtkDataSetAttributes* inputVertexData = input->GetVertexData();
+  vtkPointData* outputPointData = output->GetPointData();
+  outputPointData->CopyAllocate(inputVertexData, numPoints);
+  vtkStringArray* inputNames = vtkStringArray::SafeDownCast(
+    inputVertexData->GetAbstractArray("name"));
+  vtkStringArray* outputNames = vtkStringArray::SafeDownCast(
+    outputPointData->GetAbstractArray("name"));
+  vtkIdTypeArray* labelIndex = 0;
+  if (this->SparseLabels)
+    {
+    labelIndex = this->PrepareSparseLabels(input, output);
+    labelIndex->SetNumberOfValues(numPoints);
+    }
+  for (vtkIdType p = 0; p < numVertexPoints; p++)
+    {
+    outputPointData->CopyData(inputVertexData, vertexOrder[p], p);
+    if (outputNames)
+      {
+      outputNames->SetValue(p, "");
+      }
+    if (labelIndex)
+      {
+      labelIndex->SetValue(p, -1);
+      }
+    }
+  for (vtkIdType i = 0; i < numCurves; i++)
+    {
+    vtkIdType middle = interiorOffsets[i] + segments[i]/2 - 1;
+    for (vtkIdType p = interiorOffsets[i]; p < interiorOffsets[i] + segments[i] - 1; p++)
+      {
+      outputPointData->CopyData(inputVertexData, sources[i], p);
+      if (outputNames)
+        {
+        outputNames->SetValue(p, (p == middle && inputNames) ?
+          inputNames->GetValue(targets[i]) : vtkStdString(""));
+        }
+      if (labelIndex)
+        {
+        labelIndex->SetValue(p, p == middle ? targets[i] : -1);
+        }
+      }
+    }
+
+  // Cells correspond to the non-ghost edges, so pass the cell data along.
+  vtkDataSetAttributes* inputEdgeData = input->GetEdgeData();
+  vtkCellData* outputCellData = output->GetCellData();
+  if (edgeGhostLevels == NULL)
+    {
+    outputCellData->PassData(inputEdgeData);
+    }
+  else
+    {
+    outputCellData->CopyAllocate(inputEdgeData, numCurves);
+    for (vtkIdType i = 0; i < numCurves; i++)
+      {
+      outputCellData->CopyData(inputEdgeData, edges[i], i);
+      }
+    }
+  output->Squeeze();
+
+  return 1;
+}
+
+vtkIdTypeArray* vtkElbowGraphToPolyData::PrepareSparseLabels(vtkGraph* input,
+  vtkPolyData* output)
+{
+  vtkIdTypeArray* labelIndex = vtkIdTypeArray::New();
+  labelIndex->SetName("LabelIndex");
+  output->GetPointData()->AddArray(labelIndex);
+  labelIndex->Delete();
+
+  // The input names are shared, not copied.
+  vtkAbstractArray* names = input->GetVertexData()->GetAbstractArray("name");
+  if (names)
+    {
+    output->GetFieldData()->AddArray(names);
+    }
+  return labelIndex;
+}
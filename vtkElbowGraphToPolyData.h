@@ -10,6 +10,18 @@
 // vertex data is passed along to the point data, and the edge data is passed
 // along to the cell data.
 //
+// When Curve is on, edges are instead drawn as smooth curves: quadratic
+// Bezier curves using the elbow corner as control point, or arcs about the
+// layout origin when Arc is on (useful with radial layouts).  The number of
+// segments of each curve adapts to its length so that no segment is longer
+// than MaximumSegmentLength; the curves are evaluated in parallel.
+//
+// When SparseLabels is on, the "name" vertex array is not copied to every
+// output point. The points get instead a "LabelIndex" array holding the
+// index of the vertex whose name labels the point, or -1, and the input
+// name array is shared as the label table in the output field data.
+// vtkResolveLabelIndices turns them back into strings for labeling.
+//
 // Only the owned graph edges (i.e. edges with ghost level 0) are copied
 // into the vtkPolyData.
 
@@ -19,6 +31,7 @@
 #include "vtkGraphToPolyData.h"
 
 class vtkElbowGraphToPolyDataInternal;
+class vtkIdTypeArray;
 
 class vtkElbowGraphToPolyData : public vtkGraphToPolyData
 {
@@ -38,6 +51,37 @@ public:
   vtkBooleanMacro(Elbow, int);
   vtkGetMacro(Elbow, int);
 
+  // Description:
+  // Turn curved edges on or off. Takes precedence over Elbow.
+  vtkSetClampMacro(Curve, int, 0, 1);
+  vtkBooleanMacro(Curve, int);
+  vtkGetMacro(Curve, int);
+
+  // Description:
+  // When on, curved edges follow arcs about the origin instead of
+  // Bezier curves.
+  vtkSetClampMacro(Arc, int, 0, 1);
+  vtkBooleanMacro(Arc, int);
+  vtkGetMacro(Arc, int);
+
+  // Description:
+  // The longest segment allowed along a curved edge, in world coordinates.
+  // Set it from the size of a pixel to tessellate in screen space.
+  vtkSetClampMacro(MaximumSegmentLength, double, 1e-9, VTK_DOUBLE_MAX);
+  vtkGetMacro(MaximumSegmentLength, double);
+
+  // Description:
+  // The most segments used for a single curved edge.
+  vtkSetClampMacro(MaximumNumberOfSegments, int, 2, 1024);
+  vtkGetMacro(MaximumNumberOfSegments, int);
+
+  // Description:
+  // Carry labels as indices into the input name array instead of
+  // copying a string to every output point.
+  vtkSetClampMacro(SparseLabels, int, 0, 1);
+  vtkBooleanMacro(SparseLabels, int);
+  vtkGetMacro(SparseLabels, int);
+
 protected:
   vtkElbowGraphToPolyData();
   ~vtkElbowGraphToPolyData();
@@ -46,10 +90,24 @@ protected:
   // Convert the vtkGraph into vtkPolyData.
   int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
 
+  // Description:
+  // Convert the edges of the graph into tessellated curves.
+  int RequestCurves(vtkGraph* input, vtkPolyData* output);
+
+  // Description:
+  // Add the label index array and the shared name table to the output.
+  // Call after the output point data has been allocated.
+  vtkIdTypeArray* PrepareSparseLabels(vtkGraph* input, vtkPolyData* output);
+
   vtkElbowGraphToPolyDataInternal* Internals;
 
   double Factor;
   int Elbow;
+  int Curve;
+  int Arc;
+  double MaximumSegmentLength;
+  int MaximumNumberOfSegments;
+  int SparseLabels;
 
 private:
   vtkElbowGraphToPolyData(const vtkElbowGraphToPolyData&);  // Not implemented.
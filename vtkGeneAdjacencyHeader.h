@@ -0,0 +1,58 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkGeneAdjacencyHeader - header of binary cell gene adjacency files
+//
+// .SECTION Description
+// A binary adjacency file, written by TableToAdjacencyList -b and read by
+// vtkGeneExpressionReader, holds which genes are expressed in which cells
+// in the layout vtkCellGeneIndex keeps in memory, so that loading it is a
+// copy rather than a parse. It starts with this header, followed by
+// sections that are all 8 byte aligned, located by their byte offset from
+// the start of the file:
+//
+// - CellNameOffsets, NumberOfCells + 1 int64: cell c is named by the bytes
+//   [CellNameOffsets[c], CellNameOffsets[c + 1]) of CellNames;
+// - CellNames, the cell names back to back, without terminators;
+// - GeneNameOffsets and GeneNames, the same for the genes, which are
+//   sorted by name;
+// - CellGeneOffsets, NumberOfCells + 1 int64, and CellGenes,
+//   NumberOfPairs uint32: the genes of cell c are
+//   CellGenes[CellGeneOffsets[c], CellGeneOffsets[c + 1]), in increasing
+//   order;
+// - GeneCellOffsets, NumberOfGenes + 1 int64, and GeneCells, NumberOfPairs
+//   uint32: the cells of every gene, the same way.
+//
+// Cell and gene ids take 32 bits, so a pair costs 8 bytes over both
+// directions, less than its line in a text edge list.
+//
+// Values are in the byte order of the machine that wrote the file,
+// ByteOrder tells it apart from a file written with the other order.
+
+#ifndef __vtkGeneAdjacencyHeader_h
+#define __vtkGeneAdjacencyHeader_h
+
+#include "vtkType.h"
+
+#define VTK_GENE_ADJACENCY_MAGIC "CLGADJ01"
+#define VTK_GENE_ADJACENCY_BYTE_ORDER 0x0102030405060708LL
+
+struct vtkGeneAdjacencyHeader
+{
+  char Magic[8];
+  vtkTypeInt64 ByteOrder;
+  vtkTypeInt64 FileSize;
+  vtkTypeInt64 NumberOfCells;
+  vtkTypeInt64 NumberOfGenes;
+  vtkTypeInt64 NumberOfPairs;
+  vtkTypeInt64 CellNameOffsets;
+  vtkTypeInt64 CellNames;
+  vtkTypeInt64 GeneNameOffsets;
+  vtkTypeInt64 GeneNames;
+  vtkTypeInt64 CellGeneOffsets;
+  vtkTypeInt64 CellGenes;
+  vtkTypeInt64 GeneCellOffsets;
+  vtkTypeInt64 GeneCells;
+};
+
+#endif
@@ -0,0 +1,628 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkGeneCoexpression.h"
+
+#include "vtkBitMatrix.h"
+#include "vtkCellGeneIndex.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/map>
+#include <vtksys/stl/vector>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+vtkCxxRevisionMacro(vtkGeneCoexpression, "$Revision$");
+vtkStandardNewMacro(vtkGeneCoexpression);
+
+// Genes compared together by Precompute, and the number of words of
+// every gene read at once, so that both blocks stay in cache.
+#define VTK_COEXPRESSION_BLOCK 32
+#define VTK_COEXPRESSION_TILE 512
+
+static const char vtkGeneCoexpressionMagic[8] =
+  { 'C', 'L', 'C', 'O', 'E', 'X', 'P', '1' };
+
+static inline int vtkGeneCoexpressionPopCount(vtkTypeUInt64 w)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll(w);
+#else
+  int count = 0;
+  for (; w; w &= w - 1)
+    {
+    ++count;
+    }
+  return count;
+#endif
+}
+
+// The number of bits set in both a and b.
+static vtkIdType vtkGeneCoexpressionIntersect(const vtkTypeUInt64* a,
+  const vtkTypeUInt64* b, vtkIdType numWords)
+{
+  vtkIdType c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+  vtkIdType w = 0;
+  for (; w + 4 <= numWords; w += 4)
+    {
+    c0 += vtkGeneCoexpressionPopCount(a[w] & b[w]);
+    c1 += vtkGeneCoexpressionPopCount(a[w + 1] & b[w + 1]);
+    c2 += vtkGeneCoexpressionPopCount(a[w + 2] & b[w + 2]);
+    c3 += vtkGeneCoexpressionPopCount(a[w + 3] & b[w + 3]);
+    }
+  for (; w < numWords; ++w)
+    {
+    c0 += vtkGeneCoexpressionPopCount(a[w] & b[w]);
+    }
+  return c0 + c1 + c2 + c3;
+}
+
+static inline double vtkGeneCoexpressionSimilarity(int metric,
+  vtkIdType both, vtkIdType a, vtkIdType b)
+{
+  if (both == 0)
+    {
+    return 0.0;
+    }
+  if (metric == vtkGeneCoexpression::COSINE)
+    {
+    return both / sqrt(static_cast<double>(a) * static_cast<double>(b));
+    }
+  return static_cast<double>(both) / (a + b - both);
+}
+
+// The highest similarity a gene expressed in a cells can have with one
+// expressed in b cells, reached when one set holds the other.
+static inline double vtkGeneCoexpressionBound(int metric, vtkIdType a, vtkIdType b)
+{
+  double ratio = a < b ? static_cast<double>(a) / b : static_cast<double>(b) / a;
+  return metric == vtkGeneCoexpression::COSINE ? sqrt(ratio) : ratio;
+}
+
+class vtkGeneCoexpressionNeighbor
+{
+public:
+  vtkIdType Gene;
+  double Similarity;
+};
+
+// Most similar first, lower gene ids first among equals. As a heap order
+// it keeps the least similar neighbor on top.
+class vtkGeneCoexpressionBetter
+{
+public:
+  bool operator()(const vtkGeneCoexpressionNeighbor& a,
+                  const vtkGeneCoexpressionNeighbor& b) const
+    {
+    return a.Similarity > b.Similarity ||
+      (a.Similarity == b.Similarity && a.Gene < b.Gene);
+    }
+};
+
+// Keep the k best neighbors seen in heap.
+static inline void vtkGeneCoexpressionInsert(vtkGeneCoexpressionNeighbor* heap,
+  int& size, int k, vtkIdType gene, double similarity)
+{
+  vtkGeneCoexpressionNeighbor n;
+  n.Gene = gene;
+  n.Similarity = similarity;
+  vtkGeneCoexpressionBetter better;
+  if (size < k)
+    {
+    heap[size++] = n;
+    vtksys_stl::push_heap(heap, heap + size, better);
+    }
+  else if (better(n, heap[0]))
+    {
+    vtksys_stl::pop_heap(heap, heap + size, better);
+    heap[size - 1] = n;
+    vtksys_stl::push_heap(heap, heap + size, better);
+    }
+}
+
+class vtkGeneCoexpressionInternals
+{
+public:
+  // The cells of every gene as bits, in Bits unless they are columns of
+  // the index matrix.
+  vtksys_stl::vector<vtkTypeUInt64> Bits;
+  vtksys_stl::vector<const vtkTypeUInt64*> Columns;
+  vtksys_stl::vector<vtkIdType> Counts;
+  vtkIdType NumberOfWords;
+  vtkIdType NumberOfCells;
+
+  // Neighbors of single genes, found with QueryMetric and QueryNeighbors.
+  vtksys_stl::map<vtkIdType, vtksys_stl::vector<vtkGeneCoexpressionNeighbor> > Queries;
+  int QueryMetric;
+  int QueryNeighbors;
+
+  // Neighbors of all genes, AllNeighbors slots per gene, unused slots
+  // having gene -1.
+  vtksys_stl::vector<vtkGeneCoexpressionNeighbor> All;
+  int AllMetric;
+  int AllNeighbors;
+
+  vtkIdType GetNumberOfGenes()
+    {
+    return static_cast<vtkIdType>(this->Columns.size());
+    }
+
+  // Identifies the genes compared, to match a cache file with them.
+  vtkTypeUInt64 GetSignature()
+    {
+    vtkTypeUInt64 hash = 14695981039346656037ULL;
+    for (size_t g = 0; g < this->Columns.size(); ++g)
+      {
+      for (vtkIdType w = 0; w < this->NumberOfWords; ++w)
+        {
+        hash = (hash ^ this->Columns[g][w]) * 1099511628211ULL;
+        }
+      hash = (hash ^ g) * 1099511628211ULL;
+      }
+    return hash;
+    }
+};
+
+// Neighbors of one gene, every thread comparing it to a range of genes.
+class vtkGeneCoexpressionQuery
+{
+public:
+  vtkGeneCoexpressionInternals* Internals;
+  vtkIdType Gene;
+  int Metric;
+  int NumberOfNeighbors;
+  vtksys_stl::vector<vtksys_stl::vector<vtkGeneCoexpressionNeighbor> > Heaps;
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg)
+    {
+    vtkMultiThreader::ThreadInfo* info =
+      static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    vtkGeneCoexpressionQuery* self =
+      static_cast<vtkGeneCoexpressionQuery*>(info->UserData);
+    vtkGeneCoexpressionInternals* internals = self->Internals;
+    vtkIdType numGenes = internals->GetNumberOfGenes();
+    vtkIdType begin = numGenes * info->ThreadID / info->NumberOfThreads;
+    vtkIdType end = numGenes * (info->ThreadID + 1) / info->NumberOfThreads;
+    int k = self->NumberOfNeighbors;
+    vtksys_stl::vector<vtkGeneCoexpressionNeighbor>& heap = self->Heaps[info->ThreadID];
+    heap.resize(k);
+    int size = 0;
+    const vtkTypeUInt64* column = internals->Columns[self->Gene];
+    vtkIdType count = internals->Counts[self->Gene];
+    for (vtkIdType g = begin; g < end; ++g)
+      {
+      vtkIdType other = internals->Counts[g];
+      if (g == self->Gene || other == 0 || (size == k &&
+          vtkGeneCoexpressionBound(self->Metric, count, other) < heap[0].Similarity))
+        {
+        continue;
+        }
+      vtkIdType both = vtkGeneCoexpressionIntersect(column,
+        internals->Columns[g], internals->NumberOfWords);
+      if (both > 0)
+        {
+        vtkGeneCoexpressionInsert(&heap[0], size, k, g,
+          vtkGeneCoexpressionSimilarity(self->Metric, both, count, other));
+        }
+      }
+    heap.resize(size);
+    return VTK_THREAD_RETURN_VALUE;
+    }
+};
+
+// Neighbors of all genes. Every thread takes every NumberOfThreads-th
+// block of genes and compares it to itself and all following blocks, so
+// that every pair is compared once, keeping its own neighbors of all
+// genes.
+class vtkGeneCoexpressionAllPairs
+{
+public:
+  vtkGeneCoexpressionInternals* Internals;
+  int Metric;
+  int NumberOfNeighbors;
+  vtksys_stl::vector<vtksys_stl::vector<vtkGeneCoexpressionNeighbor> > Heaps;
+  vtksys_stl::vector<vtksys_stl::vector<int> > Sizes;
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg)
+    {
+    vtkMultiThreader::ThreadInfo* info =
+      static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    static_cast<vtkGeneCoexpressionAllPairs*>(info->UserData)->Run(
+      info->ThreadID, info->NumberOfThreads);
+    return VTK_THREAD_RETURN_VALUE;
+    }
+
+  void Run(int thread, int numThreads)
+    {
+    vtkGeneCoexpressionInternals* internals = this->Internals;
+    vtkIdType numGenes = internals->GetNumberOfGenes();
+    vtkIdType numWords = internals->NumberOfWords;
+    int k = this->NumberOfNeighbors;
+    vtkGeneCoexpressionNeighbor* heaps = &this->Heaps[thread][0];
+    int* sizes = &this->Sizes[thread][0];
+    vtkIdType numBlocks = (numGenes + VTK_COEXPRESSION_BLOCK - 1) / VTK_COEXPRESSION_BLOCK;
+    vtkIdType both[VTK_COEXPRESSION_BLOCK][VTK_COEXPRESSION_BLOCK];
+    for (vtkIdType bi = thread; bi < numBlocks; bi += numThreads)
+      {
+      vtkIdType iBegin = bi * VTK_COEXPRESSION_BLOCK;
+      vtkIdType iEnd = vtksys_stl::min(iBegin + VTK_COEXPRESSION_BLOCK, numGenes);
+      for (vtkIdType bj = bi; bj < numBlocks; ++bj)
+        {
+        vtkIdType jBegin = bj * VTK_COEXPRESSION_BLOCK;
+        vtkIdType jEnd = vtksys_stl::min(jBegin + VTK_COEXPRESSION_BLOCK, numGenes);
+        memset(both, 0, sizeof(both));
+        for (vtkIdType w = 0; w < numWords; w += VTK_COEXPRESSION_TILE)
+          {
+          vtkIdType tile = vtksys_stl::min(
+            static_cast<vtkIdType>(VTK_COEXPRESSION_TILE), numWords - w);
+          for (vtkIdType i = iBegin; i < iEnd; ++i)
+            {
+            if (internals->Counts[i] == 0)
+              {
+              continue;
+              }
+            const vtkTypeUInt64* a = internals->Columns[i] + w;
+            for (vtkIdType j = (bi == bj ? i + 1 : jBegin); j < jEnd; ++j)
+              {
+              both[i - iBegin][j - jBegin] += vtkGeneCoexpressionIntersect(
+                a, internals->Columns[j] + w, tile);
+              }
+            }
+          }
+        for (vtkIdType i = iBegin; i < iEnd; ++i)
+          {
+          for (vtkIdType j = (bi == bj ? i + 1 : jBegin); j < jEnd; ++j)
+            {
+            vtkIdType n = both[i - iBegin][j - jBegin];
+            if (n == 0)
+              {
+              continue;
+              }
+            double s = vtkGeneCoexpressionSimilarity(this->Metric, n,
+              internals->Counts[i], internals->Counts[j]);
+            vtkGeneCoexpressionInsert(heaps + i * k, sizes[i], k, j, s);
+            vtkGeneCoexpressionInsert(heaps + j * k, sizes[j], k, i, s);
+            }
+          }
+        }
+      }
+    }
+};
+
+vtkGeneCoexpression::vtkGeneCoexpression()
+{
+  this->Metric = JACCARD;
+  this->NumberOfNeighbors = 10;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->CacheFileName = 0;
+  this->Index = 0;
+  this->IndexMTime = 0;
+  this->Internals = new vtkGeneCoexpressionInternals;
+  this->Internals->NumberOfWords = 0;
+  this->Internals->NumberOfCells = 0;
+  this->Internals->QueryMetric = -1;
+  this->Internals->QueryNeighbors = 0;
+  this->Internals->AllMetric = -1;
+  this->Internals->AllNeighbors = 0;
+}
+
+vtkGeneCoexpression::~vtkGeneCoexpression()
+{
+  this->SetCacheFileName(0);
+  delete this->Internals;
+}
+
+void vtkGeneCoexpression::Update(vtkCellGeneIndex* index)
+{
+  if (!index)
+    {
+    vtkErrorMacro("Need a gene index.");
+    return;
+    }
+  if (index == this->Index && index->GetMTime() == this->IndexMTime)
+    {
+    return;
+    }
+  this->Index = index;
+  this->IndexMTime = index->GetMTime();
+
+  vtkGeneCoexpressionInternals* internals = this->Internals;
+  internals->Queries.clear();
+  internals->All.clear();
+  internals->AllMetric = -1;
+  internals->AllNeighbors = 0;
+  internals->Bits.clear();
+
+  vtkIdType numGenes = index->GetNumberOfGenes();
+  vtkIdType numCells = index->GetNumberOfCells();
+  internals->NumberOfCells = numCells;
+  internals->Columns.resize(numGenes);
+  internals->Counts.resize(numGenes);
+  vtkBitMatrix* matrix = index->GetMatrix();
+  if (matrix)
+    {
+    internals->NumberOfWords = matrix->GetWordsPerColumn();
+    for (vtkIdType g = 0; g < numGenes; ++g)
+      {
+      internals->Columns[g] = matrix->GetColumn(g);
+      }
+    }
+  else
+    {
+    // Scatter the sparse cells of every gene into bits.
+    vtkIdType numWords = (numCells + 63) / 64;
+    internals->NumberOfWords = numWords;
+    internals->Bits.assign(numGenes * numWords, 0);
+    const vtkIdType* offsets = index->GetGeneCellOffsets()->GetPointer(0);
+    const vtkIdType* cells = index->GetGeneCells()->GetPointer(0);
+    for (vtkIdType g = 0; g < numGenes; ++g)
+      {
+      vtkTypeUInt64* column = numWords ? &internals->Bits[g * numWords] : 0;
+      for (vtkIdType i = offsets[g]; i < offsets[g + 1]; ++i)
+        {
+        column[cells[i] / 64] |= static_cast<vtkTypeUInt64>(1) << (cells[i] % 64);
+        }
+      internals->Columns[g] = column;
+      }
+    }
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    internals->Counts[g] = index->GetNumberOfCellsOfGene(g);
+    }
+  this->Modified();
+}
+
+double vtkGeneCoexpression::GetSimilarity(vtkIdType geneA, vtkIdType geneB)
+{
+  vtkGeneCoexpressionInternals* internals = this->Internals;
+  vtkIdType numGenes = internals->GetNumberOfGenes();
+  if (geneA < 0 || geneA >= numGenes || geneB < 0 || geneB >= numGenes)
+    {
+    return 0.0;
+    }
+  vtkIdType both = vtkGeneCoexpressionIntersect(internals->Columns[geneA],
+    internals->Columns[geneB], internals->NumberOfWords);
+  return vtkGeneCoexpressionSimilarity(this->Metric, both,
+    internals->Counts[geneA], internals->Counts[geneB]);
+}
+
+void vtkGeneCoexpression::GetNeighbors(vtkIdType gene, vtkIdTypeArray* genes,
+  vtkDoubleArray* similarities)
+{
+  genes->Initialize();
+  similarities->Initialize();
+  vtkGeneCoexpressionInternals* internals = this->Internals;
+  vtkIdType numGenes = internals->GetNumberOfGenes();
+  if (gene < 0 || gene >= numGenes)
+    {
+    return;
+    }
+  int k = this->NumberOfNeighbors;
+
+  // Precomputed neighbors hold those of any smaller number of neighbors.
+  const vtkGeneCoexpressionNeighbor* found = 0;
+  int numFound = 0;
+  if (internals->AllMetric == this->Metric && internals->AllNeighbors >= k)
+    {
+    found = &internals->All[gene * internals->AllNeighbors];
+    while (numFound < k && found[numFound].Gene >= 0)
+      {
+      ++numFound;
+      }
+    }
+  else
+    {
+    if (internals->QueryMetric != this->Metric || internals->QueryNeighbors != k)
+      {
+      internals->Queries.clear();
+      internals->QueryMetric = this->Metric;
+      internals->QueryNeighbors = k;
+      }
+    vtksys_stl::map<vtkIdType, vtksys_stl::vector<vtkGeneCoexpressionNeighbor> >::iterator it =
+      internals->Queries.find(gene);
+    if (it == internals->Queries.end())
+      {
+      vtkGeneCoexpressionQuery query;
+      query.Internals = internals;
+      query.Gene = gene;
+      query.Metric = this->Metric;
+      query.NumberOfNeighbors = k;
+      int numThreads = static_cast<int>(vtksys_stl::min(
+        static_cast<vtkIdType>(this->NumberOfThreads), numGenes / 256 + 1));
+      query.Heaps.resize(numThreads);
+      vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+      threader->SetNumberOfThreads(numThreads);
+      threader->SetSingleMethod(vtkGeneCoexpressionQuery::Execute, &query);
+      threader->SingleMethodExecute();
+
+      vtksys_stl::vector<vtkGeneCoexpressionNeighbor> merged;
+      for (int t = 0; t < numThreads; ++t)
+        {
+        merged.insert(merged.end(), query.Heaps[t].begin(), query.Heaps[t].end());
+        }
+      vtksys_stl::sort(merged.begin(), merged.end(), vtkGeneCoexpressionBetter());
+      if (static_cast<int>(merged.size()) > k)
+        {
+        merged.resize(k);
+        }
+      it = internals->Queries.insert(vtksys_stl::make_pair(gene, merged)).first;
+      }
+    numFound = static_cast<int>(it->second.size());
+    found = numFound ? &it->second[0] : 0;
+    }
+
+  genes->SetNumberOfValues(numFound);
+  similarities->SetNumberOfValues(numFound);
+  for (int i = 0; i < numFound; ++i)
+    {
+    genes->SetValue(i, found[i].Gene);
+    similarities->SetValue(i, found[i].Similarity);
+    }
+}
+
+int vtkGeneCoexpression::Precompute()
+{
+  if (!this->Index)
+    {
+    vtkErrorMacro("No gene index, call Update first.");
+    return 0;
+    }
+  vtkGeneCoexpressionInternals* internals = this->Internals;
+  int k = this->NumberOfNeighbors;
+  if (internals->AllMetric == this->Metric && internals->AllNeighbors == k)
+    {
+    return 1;
+    }
+  if (this->CacheFileName && this->ReadCache())
+    {
+    return 1;
+    }
+
+  vtkIdType numGenes = internals->GetNumberOfGenes();
+  vtkIdType numBlocks = (numGenes + VTK_COEXPRESSION_BLOCK - 1) / VTK_COEXPRESSION_BLOCK;
+  int numThreads = static_cast<int>(vtksys_stl::min(
+    static_cast<vtkIdType>(this->NumberOfThreads), numBlocks));
+  numThreads = numThreads > 0 ? numThreads : 1;
+  vtkGeneCoexpressionAllPairs pairs;
+  pairs.Internals = internals;
+  pairs.Metric = this->Metric;
+  pairs.NumberOfNeighbors = k;
+  pairs.Heaps.resize(numThreads);
+  pairs.Sizes.resize(numThreads);
+  for (int t = 0; t < numThreads; ++t)
+    {
+    pairs.Heaps[t].resize(numGenes * k + 1);
+    pairs.Sizes[t].resize(numGenes + 1, 0);
+    }
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkGeneCoexpressionAllPairs::Execute, &pairs);
+  threader->SingleMethodExecute();
+
+  // Keep the best of the neighbors every thread found.
+  vtkGeneCoexpressionNeighbor none;
+  none.Gene = -1;
+  none.Similarity = 0.0;
+  internals->All.assign(numGenes * k, none);
+  vtksys_stl::vector<vtkGeneCoexpressionNeighbor> merged;
+  for (vtkIdType g = 0; g < numGenes; ++g)
+    {
+    merged.clear();
+    for (int t = 0; t < numThreads; ++t)
+      {
+      const vtkGeneCoexpressionNeighbor* heap = &pairs.Heaps[t][g * k];
+      merged.insert(merged.end(), heap, heap + pairs.Sizes[t][g]);
+      }
+    vtksys_stl::sort(merged.begin(), merged.end(), vtkGeneCoexpressionBetter());
+    vtksys_stl::copy(merged.begin(),
+      merged.begin() + vtksys_stl::min(merged.size(), static_cast<size_t>(k)),
+      internals->All.begin() + g * k);
+    }
+  internals->AllMetric = this->Metric;
+  internals->AllNeighbors = k;
+
+  if (this->CacheFileName && !this->WriteCache())
+    {
+    vtkWarningMacro("Could not write " << this->CacheFileName);
+    }
+  return 1;
+}
+
+int vtkGeneCoexpression::WriteCache()
+{
+  FILE* file = fopen(this->CacheFileName, "wb");
+  if (!file)
+    {
+    return 0;
+    }
+  vtkGeneCoexpressionInternals* internals = this->Internals;
+  vtkIdType numGenes = internals->GetNumberOfGenes();
+  vtkTypeInt64 header[5] = { numGenes, internals->NumberOfCells,
+    internals->AllNeighbors, internals->AllMetric,
+    static_cast<vtkTypeInt64>(internals->GetSignature()) };
+  size_t numEntries = internals->All.size();
+  vtksys_stl::vector<vtkTypeInt64> ids(numEntries);
+  vtksys_stl::vector<double> similarities(numEntries);
+  for (size_t i = 0; i < numEntries; ++i)
+    {
+    ids[i] = internals->All[i].Gene;
+    similarities[i] = internals->All[i].Similarity;
+    }
+  bool ok =
+    fwrite(vtkGeneCoexpressionMagic, 1, 8, file) == 8 &&
+    fwrite(header, sizeof(vtkTypeInt64), 5, file) == 5 &&
+    (numEntries == 0 ||
+     (fwrite(&ids[0], sizeof(vtkTypeInt64), numEntries, file) == numEntries &&
+      fwrite(&similarities[0], sizeof(double), numEntries, file) == numEntries));
+  ok = fclose(file) == 0 && ok;
+  if (!ok)
+    {
+    remove(this->CacheFileName);
+    }
+  return ok ? 1 : 0;
+}
+
+int vtkGeneCoexpression::ReadCache()
+{
+  FILE* file = fopen(this->CacheFileName, "rb");
+  if (!file)
+    {
+    return 0;
+    }
+  vtkGeneCoexpressionInternals* internals = this->Internals;
+  vtkIdType numGenes = internals->GetNumberOfGenes();
+  int k = this->NumberOfNeighbors;
+  char magic[8];
+  vtkTypeInt64 header[5];
+  size_t numEntries = static_cast<size_t>(numGenes * k);
+  vtksys_stl::vector<vtkTypeInt64> ids(numEntries);
+  vtksys_stl::vector<double> similarities(numEntries);
+
+  // A cache of other genes, cells or settings is ignored.
+  bool ok =
+    fread(magic, 1, 8, file) == 8 &&
+    memcmp(magic, vtkGeneCoexpressionMagic, 8) == 0 &&
+    fread(header, sizeof(vtkTypeInt64), 5, file) == 5 &&
+    header[0] == numGenes && header[1] == internals->NumberOfCells &&
+    header[2] == k && header[3] == this->Metric &&
+    header[4] == static_cast<vtkTypeInt64>(internals->GetSignature()) &&
+    (numEntries == 0 ||
+     (fread(&ids[0], sizeof(vtkTypeInt64), numEntries, file) == numEntries &&
+      fread(&similarities[0], sizeof(double), numEntries, file) == numEntries));
+  fclose(file);
+  if (!ok)
+    {
+    vtkDebugMacro("Ignoring cache " << this->CacheFileName);
+    return 0;
+    }
+  internals->All.resize(numEntries);
+  for (size_t i = 0; i < numEntries; ++i)
+    {
+    internals->All[i].Gene = ids[i];
+    internals->All[i].Similarity = similarities[i];
+    }
+  internals->AllMetric = this->Metric;
+  internals->AllNeighbors = k;
+  return 1;
+}
+
+void vtkGeneCoexpression::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "Metric: "
+     << (this->Metric == COSINE ? "COSINE" : "JACCARD") << endl;
+  os << indent << "NumberOfNeighbors: " << this->NumberOfNeighbors << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
+  os << indent << "CacheFileName: "
+     << (this->CacheFileName ? this->CacheFileName : "(none)") << endl;
+  os << indent << "NumberOfGenes: " << this->Internals->GetNumberOfGenes() << endl;
+  os << indent << "Precomputed: "
+     << (this->Internals->AllNeighbors > 0 ? "yes" : "no") << endl;
+}
@@ -0,0 +1,115 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkGeneCoexpression - genes expressed in similar sets of cells
+//
+// .SECTION Description
+// vtkGeneCoexpression compares the sets of cells expressing each gene of
+// a vtkCellGeneIndex, with the Jaccard similarity |A & B| / |A | B| or the
+// cosine similarity |A & B| / sqrt(|A| |B|), and finds the most similar
+// genes of every gene.
+//
+// Every gene is a bit set over the cells, taken from the columns of the
+// index matrix when it has one, so that a similarity is an and and a
+// popcount per 64 cells. GetNeighbors answers one gene at a time, with
+// the other genes split among threads and skipped when their cell count
+// alone rules them out; answers are cached. Precompute finds the
+// neighbors of all genes at once, comparing blocks of genes over cache
+// sized runs of cells with every pair done once, and can save the result
+// to CacheFileName to be loaded back instead of recomputed.
+//
+// .SECTION See Also
+// vtkCellGeneIndex vtkBitMatrix
+
+#ifndef __vtkGeneCoexpression_h
+#define __vtkGeneCoexpression_h
+
+#include "vtkObject.h"
+
+class vtkCellGeneIndex;
+class vtkDoubleArray;
+class vtkIdTypeArray;
+class vtkGeneCoexpressionInternals;
+
+class vtkGeneCoexpression : public vtkObject
+{
+public:
+  static vtkGeneCoexpression *New();
+  vtkTypeRevisionMacro(vtkGeneCoexpression,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+//BTX
+  enum
+    {
+    JACCARD,
+    COSINE
+    };
+//ETX
+
+  // Description:
+  // The similarity measure, JACCARD by default.
+  vtkSetClampMacro(Metric, int, JACCARD, COSINE);
+  vtkGetMacro(Metric, int);
+
+  // Description:
+  // The number of neighbors found per gene, 10 by default.
+  vtkSetClampMacro(NumberOfNeighbors, int, 1, 1000);
+  vtkGetMacro(NumberOfNeighbors, int);
+
+  // Description:
+  // The number of threads comparing genes, defaults to the number of
+  // processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, 256);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // The file Precompute saves the neighbors of all genes to and loads
+  // them back from. No file is used when null (the default).
+  vtkSetStringMacro(CacheFileName);
+  vtkGetStringMacro(CacheFileName);
+
+  // Description:
+  // Take the genes of index. Does nothing if the index was not modified
+  // since the last call, otherwise drops all neighbors found so far.
+  void Update(vtkCellGeneIndex* index);
+
+  // Description:
+  // The similarity of two genes.
+  double GetSimilarity(vtkIdType geneA, vtkIdType geneB);
+
+  // Description:
+  // Set genes and similarities to the NumberOfNeighbors genes most similar
+  // to gene, most similar first. Genes sharing no cell with it are left
+  // out.
+  void GetNeighbors(vtkIdType gene, vtkIdTypeArray* genes,
+                    vtkDoubleArray* similarities);
+
+  // Description:
+  // Find the neighbors of all genes, loading them from CacheFileName when
+  // it holds those of the same genes, metric and number of neighbors, and
+  // saving them to it otherwise. Returns 0 on failure.
+  int Precompute();
+
+protected:
+  vtkGeneCoexpression();
+  ~vtkGeneCoexpression();
+
+  int Metric;
+  int NumberOfNeighbors;
+  int NumberOfThreads;
+  char* CacheFileName;
+  vtkCellGeneIndex* Index;
+  unsigned long IndexMTime;
+  vtkGeneCoexpressionInternals* Internals;
+
+  // Description:
+  // Save or load the precomputed neighbors.
+  int WriteCache();
+  int ReadCache();
+
+private:
+  vtkGeneCoexpression(const vtkGeneCoexpression&);  // Not implemented.
+  void operator=(const vtkGeneCoexpression&);  // Not implemented.
+};
+
+#endif
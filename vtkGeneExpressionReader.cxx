@@ -0,0 +1,803 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkGeneExpressionReader.h"
+
+#include "vtkBitMatrix.h"
+#include "vtkFloatArray.h"
+#include "vtkGeneAdjacencyHeader.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMemoryMappedFile.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+#include "vtkStdString.h"
+#include "vtkStringArray.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/map>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkGeneExpressionReader, "$Revision$");
+vtkStandardNewMacro(vtkGeneExpressionReader);
+
+// A field of the mapped file.
+class vtkGeneExpressionReaderToken
+{
+public:
+  const char* Begin;
+  size_t Length;
+
+  vtkStdString ToString() const { return vtkStdString(this->Begin, this->Length); }
+  bool operator==(const char* s) const
+    {
+    return strlen(s) == this->Length && !strncmp(this->Begin, s, this->Length);
+    }
+};
+
+class vtkGeneExpressionReaderTokenLess
+{
+public:
+  bool operator()(const vtkGeneExpressionReaderToken& a,
+                  const vtkGeneExpressionReaderToken& b) const
+    {
+    size_t length = a.Length < b.Length ? a.Length : b.Length;
+    int c = memcmp(a.Begin, b.Begin, length);
+    return c < 0 || (c == 0 && a.Length < b.Length);
+    }
+};
+
+typedef vtksys_stl::map<vtkGeneExpressionReaderToken, vtkIdType,
+  vtkGeneExpressionReaderTokenLess> vtkGeneExpressionReaderTokenMap;
+
+// Names met in one chunk, numbered in order of appearance. Once merged,
+// GlobalIds maps them to ids over the whole file and names with a global
+// id of at least FirstNewId were first met in this chunk.
+class vtkGeneExpressionReaderNames
+{
+public:
+  vtkGeneExpressionReaderTokenMap Ids;
+  vtksys_stl::vector<vtkGeneExpressionReaderToken> Tokens;
+  vtksys_stl::vector<vtkIdType> GlobalIds;
+  vtkIdType FirstNewId;
+
+  vtkIdType Intern(const vtkGeneExpressionReaderToken& token)
+    {
+    vtkGeneExpressionReaderTokenMap::iterator it = this->Ids.find(token);
+    if (it != this->Ids.end())
+      {
+      return it->second;
+      }
+    vtkIdType id = static_cast<vtkIdType>(this->Tokens.size());
+    this->Ids.insert(vtkGeneExpressionReaderTokenMap::value_type(token, id));
+    this->Tokens.push_back(token);
+    return id;
+    }
+};
+
+// The lines of the file parsed by one thread.
+class vtkGeneExpressionReaderChunk
+{
+public:
+  const char* Begin;
+  const char* End;
+  vtkGeneExpressionReaderNames Cells;
+  vtkGeneExpressionReaderNames Genes;
+  vtksys_stl::vector<vtkIdType> PairCells;
+  vtksys_stl::vector<vtkIdType> PairGenes;
+  vtksys_stl::vector<float> PairLevels;
+  vtkIdType Offset;
+
+  // Matrix rows of the chunk cells, and the levels of their set bits in
+  // column order. Rows of cells met in an earlier chunk are merged after
+  // the parallel write.
+  vtksys_stl::vector<vtkTypeUInt64> Rows;
+  vtksys_stl::vector<vtksys_stl::vector<float> > RowLevels;
+
+  // Scratch row of the line being parsed.
+  vtksys_stl::vector<vtkTypeUInt64> Row;
+  vtksys_stl::vector<float> Levels;
+};
+
+// Reads the next comma separated field of a line, without the trailing
+// carriage return and surrounding quotes. Returns the start of the next
+// field, or lineEnd.
+static const char* vtkGeneExpressionReaderNextField(const char* p,
+  const char* lineEnd, vtkGeneExpressionReaderToken& field)
+{
+  const char* end = static_cast<const char*>(memchr(p, ',', lineEnd - p));
+  const char* next = end ? end + 1 : lineEnd;
+  end = end ? end : lineEnd;
+  if (end > p && end[-1] == '\r')
+    {
+    --end;
+    }
+  if (end - p >= 2 && *p == '"' && end[-1] == '"')
+    {
+    ++p;
+    --end;
+    }
+  field.Begin = p;
+  field.Length = static_cast<size_t>(end - p);
+  return next;
+}
+
+// The value of a matrix entry or level field, non-zero meaning the gene
+// is expressed. Empty fields are 0.
+static double vtkGeneExpressionReaderValue(const vtkGeneExpressionReaderToken& field)
+{
+  if (field.Length == 0)
+    {
+    return 0.0;
+    }
+  if (field.Length == 1)
+    {
+    return field.Begin[0] >= '0' && field.Begin[0] <= '9' ? field.Begin[0] - '0' : 0.0;
+    }
+  char buffer[64];
+  size_t length = field.Length < sizeof(buffer) - 1 ? field.Length : sizeof(buffer) - 1;
+  memcpy(buffer, field.Begin, length);
+  buffer[length] = 0;
+  return strtod(buffer, 0);
+}
+
+// Or the row newRow with levels newLevels into row with levels levels,
+// the new levels replacing those of bits set in both.
+static void vtkGeneExpressionReaderMergeRow(vtkTypeUInt64* row,
+  vtksys_stl::vector<float>& levels, const vtkTypeUInt64* newRow,
+  const vtksys_stl::vector<float>& newLevels, vtkIdType numWords)
+{
+  vtksys_stl::vector<float> merged;
+  size_t oldLevel = 0;
+  size_t newLevel = 0;
+  for (vtkIdType w = 0; w < numWords; ++w)
+    {
+    for (vtkTypeUInt64 bits = row[w] | newRow[w]; bits; bits &= bits - 1)
+      {
+      vtkTypeUInt64 bit = bits & (~bits + 1);
+      bool inOld = (row[w] & bit) != 0;
+      if (newRow[w] & bit)
+        {
+        merged.push_back(newLevels[newLevel++]);
+        oldLevel += inOld;
+        }
+      else
+        {
+        merged.push_back(levels[oldLevel++]);
+        }
+      }
+    row[w] |= newRow[w];
+    }
+  levels.swap(merged);
+}
+
+// Shared state of the threads. The parse pass interns the names of each
+// chunk and collects its pairs with chunk local ids, or its matrix rows.
+// The write pass translates them to global ids into the output.
+class vtkGeneExpressionReaderParser
+{
+public:
+  enum
+    {
+    PARSE_PASS,
+    WRITE_PASS
+    };
+
+  int Pass;
+  int Format;
+  int CellColumn;
+  int GeneColumn;
+  int LevelColumn;
+  int ReadLevels;
+  vtkIdType NumberOfGenes;
+  vtkIdType WordsPerRow;
+  vtksys_stl::vector<vtkGeneExpressionReaderChunk> Chunks;
+  vtkIdType* OutputCells;
+  vtkIdType* OutputGenes;
+  float* OutputLevels;
+  vtkBitMatrix* OutputMatrix;
+
+  void Parse(vtkGeneExpressionReaderChunk& chunk);
+  void Write(vtkGeneExpressionReaderChunk& chunk);
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg);
+};
+
+VTK_THREAD_RETURN_TYPE vtkGeneExpressionReaderParser::Execute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkGeneExpressionReaderParser* self =
+    static_cast<vtkGeneExpressionReaderParser*>(info->UserData);
+  vtkGeneExpressionReaderChunk& chunk = self->Chunks[info->ThreadID];
+  if (self->Pass == PARSE_PASS)
+    {
+    self->Parse(chunk);
+    }
+  else
+    {
+    self->Write(chunk);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+void vtkGeneExpressionReaderParser::Parse(vtkGeneExpressionReaderChunk& chunk)
+{
+  vtkGeneExpressionReaderToken field;
+  const char* p = chunk.Begin;
+  while (p < chunk.End)
+    {
+    const char* lineEnd = static_cast<const char*>(memchr(p, '\n', chunk.End - p));
+    lineEnd = lineEnd ? lineEnd : chunk.End;
+    if (this->Format == vtkGeneExpressionReader::EDGE_LIST)
+      {
+      vtkGeneExpressionReaderToken cell = { 0, 0 };
+      vtkGeneExpressionReaderToken gene = { 0, 0 };
+      vtkGeneExpressionReaderToken level = { 0, 0 };
+      int column = 0;
+      for (const char* f = p; f < lineEnd; ++column)
+        {
+        f = vtkGeneExpressionReaderNextField(f, lineEnd, field);
+        if (column == this->CellColumn)
+          {
+          cell = field;
+          }
+        else if (column == this->GeneColumn)
+          {
+          gene = field;
+          }
+        else if (column == this->LevelColumn)
+          {
+          level = field;
+          }
+        }
+      if (cell.Length > 0 && gene.Length > 0)
+        {
+        chunk.PairCells.push_back(chunk.Cells.Intern(cell));
+        chunk.PairGenes.push_back(chunk.Genes.Intern(gene));
+        if (this->LevelColumn >= 0)
+          {
+          chunk.PairLevels.push_back(
+            static_cast<float>(vtkGeneExpressionReaderValue(level)));
+          }
+        }
+      }
+    else
+      {
+      const char* f = vtkGeneExpressionReaderNextField(p, lineEnd, field);
+      if (field.Length > 0)
+        {
+        vtkIdType cell = chunk.Cells.Intern(field);
+        vtksys_stl::vector<vtkTypeUInt64>::size_type rowEnd =
+          (cell + 1) * this->WordsPerRow;
+        if (chunk.Rows.size() < rowEnd)
+          {
+          chunk.Rows.resize(rowEnd, 0);
+          }
+        vtkTypeUInt64* row = this->WordsPerRow > 0 ?
+          &chunk.Rows[cell * this->WordsPerRow] : 0;
+        if (!this->ReadLevels)
+          {
+          for (vtkIdType gene = 0; f < lineEnd && gene < this->NumberOfGenes; ++gene)
+            {
+            f = vtkGeneExpressionReaderNextField(f, lineEnd, field);
+            if (vtkGeneExpressionReaderValue(field) != 0.0)
+              {
+              row[gene / 64] |= static_cast<vtkTypeUInt64>(1) << (gene % 64);
+              }
+            }
+          }
+        else
+          {
+          // Parse into the scratch row, then merge it in case the cell
+          // was already met in this chunk.
+          chunk.Row.assign(this->WordsPerRow, 0);
+          chunk.Levels.clear();
+          for (vtkIdType gene = 0; f < lineEnd && gene < this->NumberOfGenes; ++gene)
+            {
+            f = vtkGeneExpressionReaderNextField(f, lineEnd, field);
+            double value = vtkGeneExpressionReaderValue(field);
+            if (value != 0.0)
+              {
+              chunk.Row[gene / 64] |= static_cast<vtkTypeUInt64>(1) << (gene % 64);
+              chunk.Levels.push_back(static_cast<float>(value));
+              }
+            }
+          if (chunk.RowLevels.size() <= static_cast<size_t>(cell))
+            {
+            chunk.RowLevels.resize(cell + 1);
+            }
+          if (chunk.RowLevels[cell].empty())
+            {
+            vtksys_stl::copy(chunk.Row.begin(), chunk.Row.end(), row);
+            chunk.RowLevels[cell].swap(chunk.Levels);
+            }
+          else
+            {
+            vtkGeneExpressionReaderMergeRow(row, chunk.RowLevels[cell],
+              &chunk.Row[0], chunk.Levels, this->WordsPerRow);
+            }
+          }
+        }
+      }
+    p = lineEnd + 1;
+    }
+}
+
+void vtkGeneExpressionReaderParser::Write(vtkGeneExpressionReaderChunk& chunk)
+{
+  if (this->Format == vtkGeneExpressionReader::MATRIX)
+    {
+    // Cells new to this chunk have rows no other thread writes.
+    vtkIdType numCells = static_cast<vtkIdType>(chunk.Cells.Tokens.size());
+    for (vtkIdType c = 0; c < numCells; ++c)
+      {
+      vtkIdType cell = chunk.Cells.GlobalIds[c];
+      if (cell >= chunk.Cells.FirstNewId)
+        {
+        vtksys_stl::copy(chunk.Rows.begin() + c * this->WordsPerRow,
+          chunk.Rows.begin() + (c + 1) * this->WordsPerRow,
+          this->OutputMatrix->GetRow(cell));
+        }
+      }
+    return;
+    }
+
+  vtkIdType numPairs = static_cast<vtkIdType>(chunk.PairCells.size());
+  vtkIdType* cells = this->OutputCells + chunk.Offset;
+  vtkIdType* genes = this->OutputGenes + chunk.Offset;
+  for (vtkIdType i = 0; i < numPairs; ++i)
+    {
+    cells[i] = chunk.Cells.GlobalIds[chunk.PairCells[i]];
+    }
+  for (vtkIdType i = 0; i < numPairs; ++i)
+    {
+    genes[i] = chunk.Genes.GlobalIds[chunk.PairGenes[i]];
+    }
+  if (this->OutputLevels)
+    {
+    vtksys_stl::copy(chunk.PairLevels.begin(), chunk.PairLevels.end(),
+      this->OutputLevels + chunk.Offset);
+    }
+
+  // Release the chunk as soon as it is written.
+  vtksys_stl::vector<vtkIdType>().swap(chunk.PairCells);
+  vtksys_stl::vector<vtkIdType>().swap(chunk.PairGenes);
+  vtksys_stl::vector<float>().swap(chunk.PairLevels);
+}
+
+// Merges the names of all chunks in chunk order, giving them global ids.
+static void vtkGeneExpressionReaderMergeNames(
+  vtksys_stl::vector<vtkGeneExpressionReaderChunk>& chunks,
+  vtkGeneExpressionReaderNames vtkGeneExpressionReaderChunk::* member,
+  vtkStringArray* names)
+{
+  vtkGeneExpressionReaderNames global;
+  for (vtksys_stl::vector<vtkGeneExpressionReaderChunk>::size_type c = 0;
+       c < chunks.size(); ++c)
+    {
+    vtkGeneExpressionReaderNames& local = chunks[c].*member;
+    local.FirstNewId = names->GetNumberOfTuples();
+    local.GlobalIds.resize(local.Tokens.size());
+    for (vtksys_stl::vector<vtkGeneExpressionReaderToken>::size_type i = 0;
+         i < local.Tokens.size(); ++i)
+      {
+      vtkIdType id = global.Intern(local.Tokens[i]);
+      if (id == names->GetNumberOfTuples())
+        {
+        names->InsertNextValue(local.Tokens[i].ToString());
+        }
+      local.GlobalIds[i] = id;
+      }
+    }
+}
+
+// Whether bytes bytes at offset lie in a binary file of the given size,
+// after the header and aligned for 64 bit reads.
+static bool vtkGeneExpressionReaderHasSection(vtkTypeInt64 offset,
+  vtkTypeInt64 bytes, size_t size)
+{
+  return offset >= static_cast<vtkTypeInt64>(sizeof(vtkGeneAdjacencyHeader)) &&
+    offset % 8 == 0 && bytes >= 0 && offset <= static_cast<vtkTypeInt64>(size) &&
+    bytes <= static_cast<vtkTypeInt64>(size) - offset;
+}
+
+// Copies count offsets of a binary file, which must go from 0 up to total.
+static bool vtkGeneExpressionReaderCopyOffsets(const vtkTypeInt64* values,
+  vtkTypeInt64 count, vtkTypeInt64 total, vtkIdTypeArray* output)
+{
+  if (count < 1 || values[0] != 0 || values[count - 1] != total)
+    {
+    return false;
+    }
+  output->SetNumberOfValues(static_cast<vtkIdType>(count));
+  vtkIdType* ids = output->GetPointer(0);
+  for (vtkTypeInt64 i = 0; i < count; ++i)
+    {
+    if (i > 0 && values[i] < values[i - 1])
+      {
+      return false;
+      }
+    ids[i] = static_cast<vtkIdType>(values[i]);
+    }
+  return true;
+}
+
+// Copies count ids of a binary file, which must be below limit.
+static bool vtkGeneExpressionReaderCopyIds(const vtkTypeUInt32* values,
+  vtkTypeInt64 count, vtkTypeInt64 limit, vtkIdTypeArray* output)
+{
+  output->SetNumberOfValues(static_cast<vtkIdType>(count));
+  vtkIdType* ids = count > 0 ? output->GetPointer(0) : 0;
+  for (vtkTypeInt64 i = 0; i < count; ++i)
+    {
+    if (values[i] >= limit)
+      {
+      return false;
+      }
+    ids[i] = static_cast<vtkIdType>(values[i]);
+    }
+  return true;
+}
+
+// Copies count names of a binary file, given the offsets and bytes
+// sections.
+static bool vtkGeneExpressionReaderCopyNames(const char* data, size_t size,
+  vtkTypeInt64 offsets, vtkTypeInt64 bytes, vtkTypeInt64 count,
+  vtkStringArray* output)
+{
+  if (count < 0 || !vtkGeneExpressionReaderHasSection(offsets, (count + 1) * 8, size))
+    {
+    return false;
+    }
+  const vtkTypeInt64* ends = reinterpret_cast<const vtkTypeInt64*>(data + offsets);
+  if (!vtkGeneExpressionReaderHasSection(bytes, ends[count], size) || ends[0] != 0)
+    {
+    return false;
+    }
+  const char* names = data + bytes;
+  output->SetNumberOfValues(static_cast<vtkIdType>(count));
+  for (vtkTypeInt64 i = 0; i < count; ++i)
+    {
+    if (ends[i + 1] < ends[i] || ends[i + 1] > ends[count])
+      {
+      return false;
+      }
+    output->SetValue(static_cast<vtkIdType>(i),
+      vtkStdString(names + ends[i], static_cast<size_t>(ends[i + 1] - ends[i])));
+    }
+  return true;
+}
+
+vtkGeneExpressionReader::vtkGeneExpressionReader()
+{
+  this->FileName = 0;
+  this->Format = AUTOMATIC;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->ReadLevels = 1;
+  this->CellNames = vtkStringArray::New();
+  this->GeneNames = vtkStringArray::New();
+  this->Cells = vtkIdTypeArray::New();
+  this->Genes = vtkIdTypeArray::New();
+  this->Levels = vtkFloatArray::New();
+  this->Matrix = vtkBitMatrix::New();
+  this->CellGeneOffsets = vtkIdTypeArray::New();
+  this->CellGenes = vtkIdTypeArray::New();
+  this->GeneCellOffsets = vtkIdTypeArray::New();
+  this->GeneCells = vtkIdTypeArray::New();
+}
+
+vtkGeneExpressionReader::~vtkGeneExpressionReader()
+{
+  this->SetFileName(0);
+  this->CellNames->Delete();
+  this->GeneNames->Delete();
+  this->Cells->Delete();
+  this->Genes->Delete();
+  this->Levels->Delete();
+  this->Matrix->Delete();
+  this->CellGeneOffsets->Delete();
+  this->CellGenes->Delete();
+  this->GeneCellOffsets->Delete();
+  this->GeneCells->Delete();
+}
+
+int vtkGeneExpressionReader::Read()
+{
+  this->CellNames->Initialize();
+  this->GeneNames->Initialize();
+  this->Cells->Initialize();
+  this->Genes->Initialize();
+  this->Levels->Initialize();
+  this->Matrix->Initialize();
+  this->CellGeneOffsets->Initialize();
+  this->CellGenes->Initialize();
+  this->GeneCellOffsets->Initialize();
+  this->GeneCells->Initialize();
+
+  vtkSmartPointer<vtkMemoryMappedFile> file = vtkSmartPointer<vtkMemoryMappedFile>::New();
+  if (!file->Open(this->FileName))
+    {
+    vtkErrorMacro("Could not open " << (this->FileName ? this->FileName : "(null)"));
+    return 0;
+    }
+  if (file->GetSize() == 0)
+    {
+    vtkErrorMacro("Empty file " << this->FileName);
+    return 0;
+    }
+  const char* data = file->GetData();
+  const char* dataEnd = data + file->GetSize();
+  bool binary = file->GetSize() >= sizeof(vtkGeneAdjacencyHeader) &&
+    !memcmp(data, VTK_GENE_ADJACENCY_MAGIC, 8);
+  if (binary && (this->Format == AUTOMATIC || this->Format == BINARY))
+    {
+    this->Format = BINARY;
+    return this->ReadBinary(data, file->GetSize());
+    }
+  if (this->Format == BINARY)
+    {
+    vtkErrorMacro("Not a binary adjacency file: " << this->FileName);
+    return 0;
+    }
+  if (file->GetSize() >= 3 && !strncmp(data, "\xEF\xBB\xBF", 3))
+    {
+    data += 3;
+    }
+
+  // The header decides the layout.
+  const char* headerEnd = static_cast<const char*>(memchr(data, '\n', dataEnd - data));
+  headerEnd = headerEnd ? headerEnd : dataEnd;
+  vtksys_stl::vector<vtkGeneExpressionReaderToken> header;
+  vtkGeneExpressionReaderToken field;
+  for (const char* f = data; f < headerEnd; )
+    {
+    f = vtkGeneExpressionReaderNextField(f, headerEnd, field);
+    header.push_back(field);
+    }
+  vtkGeneExpressionReaderParser parser;
+  parser.CellColumn = -1;
+  parser.GeneColumn = -1;
+  parser.LevelColumn = -1;
+  for (vtksys_stl::vector<vtkGeneExpressionReaderToken>::size_type c = 0;
+       c < header.size(); ++c)
+    {
+    if (header[c] == "cell" && parser.CellColumn < 0)
+      {
+      parser.CellColumn = static_cast<int>(c);
+      }
+    else if (header[c] == "gene" && parser.GeneColumn < 0)
+      {
+      parser.GeneColumn = static_cast<int>(c);
+      }
+    else if ((header[c] == "level" || header[c] == "value" ||
+              header[c] == "expression") && parser.LevelColumn < 0)
+      {
+      parser.LevelColumn = static_cast<int>(c);
+      }
+    }
+  bool hasColumns = parser.CellColumn >= 0 && parser.GeneColumn >= 0;
+  if (this->Format == AUTOMATIC)
+    {
+    this->Format = hasColumns ? EDGE_LIST : MATRIX;
+    }
+  if (this->Format == EDGE_LIST && !hasColumns)
+    {
+    vtkErrorMacro("No cell and gene columns in " << this->FileName);
+    return 0;
+    }
+  parser.Format = this->Format;
+  parser.ReadLevels = this->ReadLevels;
+  if (!this->ReadLevels || this->Format != EDGE_LIST)
+    {
+    parser.LevelColumn = -1;
+    }
+  parser.OutputLevels = 0;
+  parser.NumberOfGenes = 0;
+  parser.WordsPerRow = 0;
+  if (this->Format == MATRIX)
+    {
+    for (vtksys_stl::vector<vtkGeneExpressionReaderToken>::size_type c = 1;
+         c < header.size(); ++c)
+      {
+      this->GeneNames->InsertNextValue(header[c].ToString());
+      }
+    parser.NumberOfGenes = this->GeneNames->GetNumberOfTuples();
+    parser.WordsPerRow = (parser.NumberOfGenes + 63) / 64;
+    }
+
+  // One chunk per thread, starting at line boundaries.
+  const char* body = headerEnd < dataEnd ? headerEnd + 1 : dataEnd;
+  size_t bodySize = static_cast<size_t>(dataEnd - body);
+  int numThreads = bodySize < (1 << 20) ? 1 : this->NumberOfThreads;
+  parser.Chunks.resize(numThreads);
+  for (int t = 0; t < numThreads; ++t)
+    {
+    const char* begin = body + static_cast<size_t>(
+      static_cast<double>(bodySize) * t / numThreads);
+    while (t > 0 && begin < dataEnd && begin[-1] != '\n')
+      {
+      ++begin;
+      }
+    parser.Chunks[t].Begin = begin;
+    if (t > 0)
+      {
+      parser.Chunks[t - 1].End = begin;
+      }
+    }
+  parser.Chunks[numThreads - 1].End = dataEnd;
+
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkGeneExpressionReaderParser::Execute, &parser);
+  parser.Pass = vtkGeneExpressionReaderParser::PARSE_PASS;
+  threader->SingleMethodExecute();
+
+  // Merge the names, then write the pairs of every chunk at its offset.
+  vtkGeneExpressionReaderMergeNames(parser.Chunks,
+    &vtkGeneExpressionReaderChunk::Cells, this->CellNames);
+  if (this->Format == EDGE_LIST)
+    {
+    vtkGeneExpressionReaderMergeNames(parser.Chunks,
+      &vtkGeneExpressionReaderChunk::Genes, this->GeneNames);
+    }
+  parser.Pass = vtkGeneExpressionReaderParser::WRITE_PASS;
+  if (this->Format == MATRIX)
+    {
+    this->Matrix->SetSize(this->CellNames->GetNumberOfTuples(), parser.NumberOfGenes);
+    parser.OutputMatrix = this->Matrix;
+    threader->SingleMethodExecute();
+
+    // Or in the rows of cells repeated across chunks, the levels of later
+    // rows replacing earlier ones. The levels of every cell are kept by
+    // the chunk it was first met in.
+    vtkIdType numCells = this->CellNames->GetNumberOfTuples();
+    vtksys_stl::vector<vtksys_stl::vector<float>*> cellLevels(
+      this->ReadLevels ? numCells : 0);
+    for (int t = 0; t < numThreads; ++t)
+      {
+      vtkGeneExpressionReaderChunk& chunk = parser.Chunks[t];
+      vtkIdType numChunkCells = static_cast<vtkIdType>(chunk.Cells.Tokens.size());
+      if (this->ReadLevels)
+        {
+        chunk.RowLevels.resize(numChunkCells);
+        }
+      for (vtkIdType c = 0; c < numChunkCells; ++c)
+        {
+        vtkIdType cell = chunk.Cells.GlobalIds[c];
+        if (cell >= chunk.Cells.FirstNewId)
+          {
+          if (this->ReadLevels)
+            {
+            cellLevels[cell] = &chunk.RowLevels[c];
+            }
+          continue;
+          }
+        vtkTypeUInt64* row = this->Matrix->GetRow(cell);
+        const vtkTypeUInt64* chunkRow = &chunk.Rows[c * parser.WordsPerRow];
+        if (this->ReadLevels)
+          {
+          vtkGeneExpressionReaderMergeRow(row, *cellLevels[cell], chunkRow,
+            chunk.RowLevels[c], parser.WordsPerRow);
+          continue;
+          }
+        for (vtkIdType w = 0; w < parser.WordsPerRow; ++w)
+          {
+          row[w] |= chunkRow[w];
+          }
+        }
+      }
+    this->Matrix->UpdateColumns();
+
+    // Levels are only kept if some entry is not 0 or 1.
+    bool binary = true;
+    vtkIdType numLevels = 0;
+    for (vtkIdType c = 0; c < static_cast<vtkIdType>(cellLevels.size()); ++c)
+      {
+      const vtksys_stl::vector<float>& levels = *cellLevels[c];
+      for (size_t i = 0; binary && i < levels.size(); ++i)
+        {
+        binary = levels[i] == 1.0f;
+        }
+      numLevels += static_cast<vtkIdType>(levels.size());
+      }
+    if (!binary)
+      {
+      this->Levels->SetNumberOfValues(numLevels);
+      float* levels = numLevels > 0 ? this->Levels->GetPointer(0) : 0;
+      for (vtkIdType c = 0; c < numCells; ++c)
+        {
+        levels = vtksys_stl::copy(cellLevels[c]->begin(), cellLevels[c]->end(), levels);
+        }
+      }
+    }
+  else
+    {
+    vtkIdType numPairs = 0;
+    for (int t = 0; t < numThreads; ++t)
+      {
+      parser.Chunks[t].Offset = numPairs;
+      numPairs += static_cast<vtkIdType>(parser.Chunks[t].PairCells.size());
+      }
+    this->Cells->SetNumberOfValues(numPairs);
+    this->Genes->SetNumberOfValues(numPairs);
+    parser.OutputCells = this->Cells->GetPointer(0);
+    parser.OutputGenes = this->Genes->GetPointer(0);
+    if (parser.LevelColumn >= 0)
+      {
+      this->Levels->SetNumberOfValues(numPairs);
+      parser.OutputLevels = numPairs > 0 ? this->Levels->GetPointer(0) : 0;
+      }
+    threader->SingleMethodExecute();
+    }
+
+  this->Modified();
+  return 1;
+}
+
+int vtkGeneExpressionReader::ReadBinary(const char* data, size_t size)
+{
+  vtkGeneAdjacencyHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (header.ByteOrder != VTK_GENE_ADJACENCY_BYTE_ORDER)
+    {
+    vtkErrorMacro("Binary file written with another byte order: " << this->FileName);
+    return 0;
+    }
+  vtkTypeInt64 numCells = header.NumberOfCells;
+  vtkTypeInt64 numGenes = header.NumberOfGenes;
+  vtkTypeInt64 numPairs = header.NumberOfPairs;
+  vtkTypeInt64 maxCount = static_cast<vtkTypeInt64>(size / 8);
+  bool valid = header.FileSize <= static_cast<vtkTypeInt64>(size) &&
+    numCells >= 0 && numCells < maxCount && numGenes >= 0 && numGenes < maxCount &&
+    numPairs >= 0 && numPairs < maxCount &&
+    vtkGeneExpressionReaderHasSection(header.CellGeneOffsets, (numCells + 1) * 8, size) &&
+    vtkGeneExpressionReaderHasSection(header.CellGenes, numPairs * 4, size) &&
+    vtkGeneExpressionReaderHasSection(header.GeneCellOffsets, (numGenes + 1) * 8, size) &&
+    vtkGeneExpressionReaderHasSection(header.GeneCells, numPairs * 4, size);
+  valid = valid &&
+    vtkGeneExpressionReaderCopyNames(data, size, header.CellNameOffsets,
+      header.CellNames, numCells, this->CellNames) &&
+    vtkGeneExpressionReaderCopyNames(data, size, header.GeneNameOffsets,
+      header.GeneNames, numGenes, this->GeneNames) &&
+    vtkGeneExpressionReaderCopyOffsets(reinterpret_cast<const vtkTypeInt64*>(
+      data + header.CellGeneOffsets), numCells + 1, numPairs, this->CellGeneOffsets) &&
+    vtkGeneExpressionReaderCopyIds(reinterpret_cast<const vtkTypeUInt32*>(
+      data + header.CellGenes), numPairs, numGenes, this->CellGenes) &&
+    vtkGeneExpressionReaderCopyOffsets(reinterpret_cast<const vtkTypeInt64*>(
+      data + header.GeneCellOffsets), numGenes + 1, numPairs, this->GeneCellOffsets) &&
+    vtkGeneExpressionReaderCopyIds(reinterpret_cast<const vtkTypeUInt32*>(
+      data + header.GeneCells), numPairs, numCells, this->GeneCells);
+  if (!valid)
+    {
+    vtkErrorMacro("Corrupt binary file " << this->FileName);
+    this->CellNames->Initialize();
+    this->GeneNames->Initialize();
+    this->CellGeneOffsets->Initialize();
+    this->CellGenes->Initialize();
+    this->GeneCellOffsets->Initialize();
+    this->GeneCells->Initialize();
+    return 0;
+    }
+  this->Modified();
+  return 1;
+}
+
+void vtkGeneExpressionReader::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "FileName: " << (this->FileName ? this->FileName : "(none)") << endl;
+  os << indent << "Format: " << this->Format << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
+  os << indent << "ReadLevels: " << this->ReadLevels << endl;
+  os << indent << "NumberOfCells: " << this->CellNames->GetNumberOfTuples() << endl;
+  os << indent << "NumberOfGenes: " << this->GeneNames->GetNumberOfTuples() << endl;
+  os << indent << "NumberOfPairs: " << this->Cells->GetNumberOfTuples() << endl;
+  os << indent << "NumberOfLevels: " << this->Levels->GetNumberOfTuples() << endl;
+  os << indent << "NumberOfAdjacencies: " << this->CellGenes->GetNumberOfTuples() << endl;
+  os << indent << "Matrix: " << endl;
+  this->Matrix->PrintSelf(os, indent.GetNextIndent());
+}
@@ -0,0 +1,154 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkGeneExpressionReader - parallel reader of gene expression CSV files
+//
+// .SECTION Description
+// vtkGeneExpressionReader reads the two gene expression layouts used by
+// CellLineage:
+//
+// - an edge list, with a header naming a "cell" and a "gene" column and
+//   one row per gene expressed in a cell, optionally with its expression
+//   level in a "level", "value" or "expression" column;
+// - a dense matrix, with a header "Cell Name,gene1,...,geneN" and one row
+//   per cell holding a level per gene, where non-zero means expressed;
+// - a binary adjacency file written by TableToAdjacencyList -b, holding
+//   the genes of every cell and the cells of every gene as compressed
+//   sparse rows (see vtkGeneAdjacencyHeader.h). It is not parsed, its
+//   arrays are copied out of the mapped file.
+//
+// An edge list is read into pairs of cell and gene ids. A matrix is read
+// straight into a vtkBitMatrix of cells by genes, one bit per entry, so
+// that no pair list is ever built for it. Levels, when there are any, are
+// kept as floats for the expressed entries only.
+//
+// The file is memory mapped and cut into one chunk per thread at line
+// boundaries. Every thread parses its chunk in place and interns the cell
+// and gene names it meets, then the names are merged and the expressed
+// (cell, gene) pairs are written out. Names are only copied once per
+// distinct name, so memory stays close to the size of the output. Fields
+// are separated by commas, surrounding double quotes are removed and
+// quoted fields may not contain commas.
+//
+// .SECTION See Also
+// vtkBitMatrix vtkCellGeneIndex vtkMemoryMappedFile
+
+#ifndef __vtkGeneExpressionReader_h
+#define __vtkGeneExpressionReader_h
+
+#include "vtkObject.h"
+
+class vtkBitMatrix;
+class vtkFloatArray;
+class vtkIdTypeArray;
+class vtkStringArray;
+
+class vtkGeneExpressionReader : public vtkObject
+{
+public:
+  static vtkGeneExpressionReader *New();
+  vtkTypeRevisionMacro(vtkGeneExpressionReader,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+//BTX
+  enum
+    {
+    AUTOMATIC,
+    EDGE_LIST,
+    MATRIX,
+    BINARY
+    };
+//ETX
+
+  // Description:
+  // The file to read.
+  vtkSetStringMacro(FileName);
+  vtkGetStringMacro(FileName);
+
+  // Description:
+  // The layout of the file. AUTOMATIC (the default) picks BINARY for a
+  // binary adjacency file, then EDGE_LIST when the header has a "cell"
+  // and a "gene" column, MATRIX otherwise. After reading, Format holds the
+  // layout that was read.
+  vtkSetClampMacro(Format, int, AUTOMATIC, BINARY);
+  vtkGetMacro(Format, int);
+
+  // Description:
+  // The number of threads parsing the file, defaults to the number of
+  // processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, 256);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Whether to read expression levels, on by default.
+  vtkSetMacro(ReadLevels, int);
+  vtkGetMacro(ReadLevels, int);
+  vtkBooleanMacro(ReadLevels, int);
+
+  // Description:
+  // Read the file. Returns 0 on failure.
+  int Read();
+
+  // Description:
+  // The distinct cell and gene names, in order of first appearance (the
+  // column order for the genes of a matrix).
+  vtkGetObjectMacro(CellNames, vtkStringArray);
+  vtkGetObjectMacro(GeneNames, vtkStringArray);
+
+  // Description:
+  // The expressed pairs of an edge list, as indices into CellNames and
+  // GeneNames. Empty for a matrix.
+  vtkGetObjectMacro(Cells, vtkIdTypeArray);
+  vtkGetObjectMacro(Genes, vtkIdTypeArray);
+
+  // Description:
+  // The expressed entries of a matrix, row c and column g for cell
+  // CellNames[c] and gene GeneNames[g]. Empty for an edge list.
+  vtkGetObjectMacro(Matrix, vtkBitMatrix);
+
+  // Description:
+  // The adjacency of a binary file: the genes of cell c (an index into
+  // CellNames) are CellGenes[CellGeneOffsets[c], CellGeneOffsets[c + 1])
+  // and the cells of gene g GeneCells[GeneCellOffsets[g],
+  // GeneCellOffsets[g + 1]), both sorted. GeneNames is sorted too. Empty
+  // for text files.
+  vtkGetObjectMacro(CellGeneOffsets, vtkIdTypeArray);
+  vtkGetObjectMacro(CellGenes, vtkIdTypeArray);
+  vtkGetObjectMacro(GeneCellOffsets, vtkIdTypeArray);
+  vtkGetObjectMacro(GeneCells, vtkIdTypeArray);
+
+  // Description:
+  // The expression levels: one per pair of an edge list with a level
+  // column, or one per set bit of the Matrix, row by row. Empty when the
+  // file has no levels, or a matrix holds only 0 and 1.
+  vtkGetObjectMacro(Levels, vtkFloatArray);
+
+protected:
+  vtkGeneExpressionReader();
+  ~vtkGeneExpressionReader();
+
+  // Description:
+  // Copy the names and adjacency out of a mapped binary file.
+  int ReadBinary(const char* data, size_t size);
+
+  char* FileName;
+  int Format;
+  int NumberOfThreads;
+  int ReadLevels;
+  vtkStringArray* CellNames;
+  vtkStringArray* GeneNames;
+  vtkIdTypeArray* Cells;
+  vtkIdTypeArray* Genes;
+  vtkFloatArray* Levels;
+  vtkBitMatrix* Matrix;
+  vtkIdTypeArray* CellGeneOffsets;
+  vtkIdTypeArray* CellGenes;
+  vtkIdTypeArray* GeneCellOffsets;
+  vtkIdTypeArray* GeneCells;
+
+private:
+  vtkGeneExpressionReader(const vtkGeneExpressionReader&);  // Not implemented.
+  void operator=(const vtkGeneExpressionReader&);  // Not implemented.
+};
+
+#endif
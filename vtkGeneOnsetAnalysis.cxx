@@ -0,0 +1,326 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkGeneOnsetAnalysis.h"
+
+#include "vtkBitMatrix.h"
+#include "vtkCellGeneIndex.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkIdTypeArray.h"
+#include "vtkLineageTreeIndex.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+#include "vtkTree.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/map>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkGeneOnsetAnalysis, "$Revision$");
+vtkStandardNewMacro(vtkGeneOnsetAnalysis);
+
+static inline int vtkGeneOnsetAnalysisPopCount(vtkTypeUInt64 w)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll(w);
+#else
+  int count = 0;
+  for (; w; w &= w - 1)
+    {
+    ++count;
+    }
+  return count;
+#endif
+}
+
+class vtkGeneOnsetAnalysisInternals
+{
+public:
+  // Gene states computed so far, dropped when the analysis is redone.
+  vtksys_stl::map<vtkIdType, vtkSmartPointer<vtkUnsignedCharArray> > States;
+};
+
+// Shared state of the threads. Every thread takes a contiguous range of
+// 64 gene blocks and sums its counts in its own arrays.
+class vtkGeneOnsetAnalysisWorker
+{
+public:
+  vtkCellGeneIndex* Index;
+  vtkIdType NumberOfVertices;
+  vtkIdType NumberOfCells;
+  vtkIdType NumberOfBlocks;
+  const vtkIdType* Parent;
+  const vtkIdType* PreorderVertex;
+  vtksys_stl::vector<vtksys_stl::vector<vtkIdType> > GeneCounts;
+  vtksys_stl::vector<vtksys_stl::vector<vtkIdType> > OnsetCounts;
+  vtksys_stl::vector<vtksys_stl::vector<vtkIdType> > SubtreeOnsetCounts;
+
+  void Run(int thread, int numThreads);
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg);
+};
+
+VTK_THREAD_RETURN_TYPE vtkGeneOnsetAnalysisWorker::Execute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkGeneOnsetAnalysisWorker* self =
+    static_cast<vtkGeneOnsetAnalysisWorker*>(info->UserData);
+  self->Run(info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+void vtkGeneOnsetAnalysisWorker::Run(int thread, int numThreads)
+{
+  vtkIdType firstBlock = this->NumberOfBlocks * thread / numThreads;
+  vtkIdType lastBlock = this->NumberOfBlocks * (thread + 1) / numThreads;
+  vtkIdType numVertices = this->NumberOfVertices;
+  vtkIdType numCells = this->NumberOfCells;
+  vtkIdType* geneCount = &this->GeneCounts[thread][0];
+  vtkIdType* onsetCount = &this->OnsetCounts[thread][0];
+  vtkIdType* subtreeOnsetCount = &this->SubtreeOnsetCounts[thread][0];
+  const vtkIdType* parent = this->Parent;
+  const vtkIdType* preorder = this->PreorderVertex;
+
+  // Genes of the sparse index are sorted per cell, so every cell keeps a
+  // cursor to its first gene of the current block.
+  vtkBitMatrix* matrix = this->Index->GetMatrix();
+  const vtkIdType* offsets = 0;
+  const vtkIdType* genes = 0;
+  vtksys_stl::vector<vtkIdType> cursor;
+  if (!matrix && numCells > 0)
+    {
+    offsets = this->Index->GetCellGeneOffsets()->GetPointer(0);
+    genes = this->Index->GetCellGenes()->GetPointer(0);
+    cursor.resize(numCells);
+    for (vtkIdType c = 0; c < numCells; ++c)
+      {
+      cursor[c] = vtksys_stl::lower_bound(genes + offsets[c],
+        genes + offsets[c + 1], firstBlock * 64) - genes;
+      }
+    }
+
+  // Expressed genes, genes expressed by an ancestor and genes expressed in
+  // the whole subtree, one bit per gene of the block.
+  vtksys_stl::vector<vtkTypeUInt64> expressed(numVertices);
+  vtksys_stl::vector<vtkTypeUInt64> above(numVertices);
+  vtksys_stl::vector<vtkTypeUInt64> whole(numVertices);
+  for (vtkIdType b = firstBlock; b < lastBlock; ++b)
+    {
+    vtkIdType blockEnd = (b + 1) * 64;
+    for (vtkIdType v = 0; v < numVertices; ++v)
+      {
+      vtkTypeUInt64 word = 0;
+      if (v < numCells && matrix)
+        {
+        word = matrix->GetRow(v)[b];
+        }
+      else if (v < numCells)
+        {
+        vtkIdType i = cursor[v];
+        for (; i < offsets[v + 1] && genes[i] < blockEnd; ++i)
+          {
+          word |= static_cast<vtkTypeUInt64>(1) << (genes[i] % 64);
+          }
+        cursor[v] = i;
+        }
+      expressed[v] = word;
+      whole[v] = word;
+      geneCount[v] += vtkGeneOnsetAnalysisPopCount(word);
+      }
+
+    // Parents come before their children in preorder.
+    for (vtkIdType i = 0; i < numVertices; ++i)
+      {
+      vtkIdType v = preorder[i];
+      vtkIdType p = parent[v];
+      above[v] = p < 0 ? 0 : (above[p] | expressed[p]);
+      onsetCount[v] += vtkGeneOnsetAnalysisPopCount(expressed[v] & ~above[v]);
+      }
+
+    // Children come after their parents in preorder, so going backwards
+    // every subtree is complete before it is folded into its parent.
+    for (vtkIdType i = numVertices - 1; i > 0; --i)
+      {
+      vtkIdType v = preorder[i];
+      whole[parent[v]] &= whole[v];
+      }
+    for (vtkIdType v = 0; v < numVertices; ++v)
+      {
+      vtkIdType p = parent[v];
+      subtreeOnsetCount[v] += vtkGeneOnsetAnalysisPopCount(
+        whole[v] & ~(p < 0 ? 0 : whole[p]));
+      }
+    }
+}
+
+vtkGeneOnsetAnalysis::vtkGeneOnsetAnalysis()
+{
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Index = 0;
+  this->IndexMTime = 0;
+  this->TreeIndex = vtkLineageTreeIndex::New();
+  this->TreeIndexMTime = 0;
+  this->GeneCount = vtkIdTypeArray::New();
+  this->GeneCount->SetName("GeneCount");
+  this->OnsetCount = vtkIdTypeArray::New();
+  this->OnsetCount->SetName("OnsetCount");
+  this->SubtreeOnsetCount = vtkIdTypeArray::New();
+  this->SubtreeOnsetCount->SetName("SubtreeOnsetCount");
+  this->Internals = new vtkGeneOnsetAnalysisInternals;
+}
+
+vtkGeneOnsetAnalysis::~vtkGeneOnsetAnalysis()
+{
+  this->TreeIndex->Delete();
+  this->GeneCount->Delete();
+  this->OnsetCount->Delete();
+  this->SubtreeOnsetCount->Delete();
+  delete this->Internals;
+}
+
+void vtkGeneOnsetAnalysis::Update(vtkCellGeneIndex* index, vtkTree* tree)
+{
+  if (!index || !tree)
+    {
+    vtkErrorMacro("Need a gene index and a tree.");
+    return;
+    }
+  this->TreeIndex->Build(tree);
+  if (index == this->Index && index->GetMTime() == this->IndexMTime &&
+      this->TreeIndex->GetMTime() == this->TreeIndexMTime)
+    {
+    return;
+    }
+  this->Index = index;
+  this->IndexMTime = index->GetMTime();
+  this->TreeIndexMTime = this->TreeIndex->GetMTime();
+  this->Internals->States.clear();
+
+  vtkGeneOnsetAnalysisWorker worker;
+  worker.Index = index;
+  worker.NumberOfVertices = this->TreeIndex->GetNumberOfVertices();
+  worker.NumberOfCells = vtksys_stl::min(worker.NumberOfVertices, index->GetNumberOfCells());
+  worker.NumberOfBlocks = (index->GetNumberOfGenes() + 63) / 64;
+  worker.Parent = this->TreeIndex->GetParent()->GetPointer(0);
+  worker.PreorderVertex = this->TreeIndex->GetPreorderVertex()->GetPointer(0);
+  int numThreads = static_cast<int>(vtksys_stl::min(
+    static_cast<vtkIdType>(this->NumberOfThreads), worker.NumberOfBlocks));
+  numThreads = numThreads > 0 ? numThreads : 1;
+  vtksys_stl::vector<vtkIdType> zeros(worker.NumberOfVertices + 1, 0);
+  worker.GeneCounts.assign(numThreads, zeros);
+  worker.OnsetCounts.assign(numThreads, zeros);
+  worker.SubtreeOnsetCounts.assign(numThreads, zeros);
+
+  if (worker.NumberOfVertices > 0)
+    {
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(vtkGeneOnsetAnalysisWorker::Execute, &worker);
+    threader->SingleMethodExecute();
+    }
+
+  // Sum the counts of the threads.
+  vtkIdTypeArray* arrays[3] = { this->GeneCount, this->OnsetCount, this->SubtreeOnsetCount };
+  vtksys_stl::vector<vtksys_stl::vector<vtkIdType> >* counts[3] =
+    { &worker.GeneCounts, &worker.OnsetCounts, &worker.SubtreeOnsetCounts };
+  for (int a = 0; a < 3; ++a)
+    {
+    arrays[a]->SetNumberOfValues(worker.NumberOfVertices);
+    for (vtkIdType v = 0; v < worker.NumberOfVertices; ++v)
+      {
+      vtkIdType total = 0;
+      for (int t = 0; t < numThreads; ++t)
+        {
+        total += (*counts[a])[t][v];
+        }
+      arrays[a]->SetValue(v, total);
+      }
+    }
+  this->Modified();
+}
+
+void vtkGeneOnsetAnalysis::AddArrays(vtkDataSetAttributes* vertexData)
+{
+  vertexData->AddArray(this->GeneCount);
+  vertexData->AddArray(this->OnsetCount);
+  vertexData->AddArray(this->SubtreeOnsetCount);
+}
+
+vtkUnsignedCharArray* vtkGeneOnsetAnalysis::GetGeneState(vtkIdType gene)
+{
+  if (!this->Index || gene < 0 || gene >= this->Index->GetNumberOfGenes())
+    {
+    return 0;
+    }
+  vtksys_stl::map<vtkIdType, vtkSmartPointer<vtkUnsignedCharArray> >::iterator it =
+    this->Internals->States.find(gene);
+  if (it != this->Internals->States.end())
+    {
+    return it->second;
+    }
+
+  vtkIdType numVertices = this->TreeIndex->GetNumberOfVertices();
+  const vtkIdType* parent = this->TreeIndex->GetParent()->GetPointer(0);
+  const vtkIdType* preorder = this->TreeIndex->GetPreorderVertex()->GetPointer(0);
+  vtkSmartPointer<vtkIdTypeArray> genes = vtkSmartPointer<vtkIdTypeArray>::New();
+  genes->InsertNextValue(gene);
+  vtkSmartPointer<vtkIdTypeArray> cells = vtkSmartPointer<vtkIdTypeArray>::New();
+  this->Index->GetCellsOfGenes(genes, cells);
+
+  // Same passes as Update, for a single gene.
+  vtksys_stl::vector<unsigned char> expressed(numVertices, 0);
+  for (vtkIdType i = 0; i < cells->GetNumberOfTuples(); ++i)
+    {
+    if (cells->GetValue(i) < numVertices)
+      {
+      expressed[cells->GetValue(i)] = 1;
+      }
+    }
+  vtksys_stl::vector<unsigned char> above(numVertices, 0);
+  vtksys_stl::vector<unsigned char> whole(expressed);
+  for (vtkIdType i = 0; i < numVertices; ++i)
+    {
+    vtkIdType v = preorder[i];
+    vtkIdType p = parent[v];
+    above[v] = p < 0 ? 0 : (above[p] | expressed[p]);
+    }
+  for (vtkIdType i = numVertices - 1; i > 0; --i)
+    {
+    vtkIdType v = preorder[i];
+    whole[parent[v]] &= whole[v];
+    }
+
+  vtkSmartPointer<vtkUnsignedCharArray> state = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  state->SetName("GeneExpressionState");
+  state->SetNumberOfValues(numVertices);
+  for (vtkIdType v = 0; v < numVertices; ++v)
+    {
+    unsigned char value = NOT_EXPRESSED;
+    if (expressed[v] && !above[v])
+      {
+      value = ONSET;
+      }
+    else if (whole[v])
+      {
+      value = WHOLE_SUBTREE;
+      }
+    else if (expressed[v])
+      {
+      value = EXPRESSED;
+      }
+    state->SetValue(v, value);
+    }
+  this->Internals->States[gene] = state;
+  return state;
+}
+
+void vtkGeneOnsetAnalysis::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
+  os << indent << "NumberOfVertices: " << this->GeneCount->GetNumberOfTuples() << endl;
+  os << indent << "NumberOfCachedGeneStates: " << this->Internals->States.size() << endl;
+}
@@ -0,0 +1,110 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkGeneOnsetAnalysis - where genes switch on along a lineage
+//
+// .SECTION Description
+// vtkGeneOnsetAnalysis combines a vtkCellGeneIndex with the lineage tree
+// it was built for and finds, for every gene:
+//
+// - its onset vertices, the cells expressing it whose ancestors do not,
+//   i.e. where expression first appears along each root to leaf path;
+// - the subtrees expressing it as a whole, rooted at cells expressing it
+//   along with all their descendants.
+//
+// The per vertex totals over all genes are kept as vertex arrays:
+// GeneCount (genes expressed in the cell), OnsetCount (genes with an
+// onset at the cell) and SubtreeOnsetCount (genes expressed in the whole
+// subtree of the cell but not in that of its parent). They are computed
+// 64 genes at a time, each bit of a word standing for one gene, with one
+// top down and one bottom up pass over the tree per block of genes, and
+// the blocks shared among threads.
+//
+// The state of every vertex for one gene is available as a
+// GeneExpressionState array, computed on demand and cached.
+//
+// Update() only recomputes when the index or the tree were modified.
+//
+// .SECTION See Also
+// vtkCellGeneIndex vtkLineageTreeIndex
+
+#ifndef __vtkGeneOnsetAnalysis_h
+#define __vtkGeneOnsetAnalysis_h
+
+#include "vtkObject.h"
+
+class vtkCellGeneIndex;
+class vtkDataSetAttributes;
+class vtkIdTypeArray;
+class vtkLineageTreeIndex;
+class vtkTree;
+class vtkUnsignedCharArray;
+class vtkGeneOnsetAnalysisInternals;
+
+class vtkGeneOnsetAnalysis : public vtkObject
+{
+public:
+  static vtkGeneOnsetAnalysis *New();
+  vtkTypeRevisionMacro(vtkGeneOnsetAnalysis,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+//BTX
+  // Values of the GeneExpressionState array.
+  enum
+    {
+    NOT_EXPRESSED,
+    EXPRESSED,
+    WHOLE_SUBTREE,
+    ONSET
+    };
+//ETX
+
+  // Description:
+  // The number of threads sharing the blocks of genes, defaults to the
+  // number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, 256);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Analyze the genes of index over the tree. Cells of the index are the
+  // vertices of the tree. Does nothing if neither changed since the last
+  // call.
+  void Update(vtkCellGeneIndex* index, vtkTree* tree);
+
+  // Description:
+  // Per vertex totals over all genes.
+  vtkGetObjectMacro(GeneCount, vtkIdTypeArray);
+  vtkGetObjectMacro(OnsetCount, vtkIdTypeArray);
+  vtkGetObjectMacro(SubtreeOnsetCount, vtkIdTypeArray);
+
+  // Description:
+  // Add the per vertex totals to the vertex data of the tree.
+  void AddArrays(vtkDataSetAttributes* vertexData);
+
+  // Description:
+  // The state of every vertex for one gene: ONSET for its onset vertices,
+  // otherwise WHOLE_SUBTREE for vertices expressing it along with all
+  // their descendants, otherwise EXPRESSED or NOT_EXPRESSED. Returns null
+  // for an invalid gene. The array belongs to the analysis.
+  vtkUnsignedCharArray* GetGeneState(vtkIdType gene);
+
+protected:
+  vtkGeneOnsetAnalysis();
+  ~vtkGeneOnsetAnalysis();
+
+  int NumberOfThreads;
+  vtkCellGeneIndex* Index;
+  unsigned long IndexMTime;
+  vtkLineageTreeIndex* TreeIndex;
+  unsigned long TreeIndexMTime;
+  vtkIdTypeArray* GeneCount;
+  vtkIdTypeArray* OnsetCount;
+  vtkIdTypeArray* SubtreeOnsetCount;
+  vtkGeneOnsetAnalysisInternals* Internals;
+
+private:
+  vtkGeneOnsetAnalysis(const vtkGeneOnsetAnalysis&);  // Not implemented.
+  void operator=(const vtkGeneOnsetAnalysis&);  // Not implemented.
+};
+
+#endif
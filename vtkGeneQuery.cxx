@@ -0,0 +1,411 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkGeneQuery.h"
+
+#include "vtkBitMatrix.h"
+#include "vtkCellGeneIndex.h"
+#include "vtkDataArray.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkIdTypeArray.h"
+#include "vtkObjectFactory.h"
+#include "vtkTree.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkGeneQuery, "$Revision$");
+vtkStandardNewMacro(vtkGeneQuery);
+
+static inline int vtkGeneQueryTrailingZeros(vtkTypeUInt64 w)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(w);
+#else
+  int count = 0;
+  for (; !(w & 1); w >>= 1)
+    {
+    ++count;
+    }
+  return count;
+#endif
+}
+
+// Recursive descent parser evaluating the query as it goes, every rule
+// leaving the cells it matches in a bitset.
+class vtkGeneQueryParser
+{
+public:
+  typedef vtksys_stl::vector<vtkTypeUInt64> Bits;
+
+  enum
+    {
+    END,
+    NAME,
+    AND,
+    OR,
+    NOT,
+    LEFT,
+    RIGHT,
+    COMMA
+    };
+
+  const char* Position;
+  int Token;
+  vtkStdString Text;
+  vtkStdString Error;
+
+  vtkCellGeneIndex* Index;
+  vtkDataArray* StartTimes;
+  vtkDataArray* EndTimes;
+  vtkIdType NumberOfCells;
+  vtkIdType NumberOfWords;
+
+  void Next();
+  bool ParseOr(Bits& bits);
+  bool ParseAnd(Bits& bits);
+  bool ParseNot(Bits& bits);
+  bool ParsePrimary(Bits& bits);
+  bool ParseNumber(double& value);
+  bool Expect(int token, const char* what);
+
+  void GeneCells(vtkIdType gene, Bits& bits);
+  void AliveCells(double t0, double t1, Bits& bits);
+};
+
+static bool vtkGeneQueryIsKeyword(const vtkStdString& text, const char* keyword)
+{
+  size_t length = strlen(keyword);
+  if (text.size() != length)
+    {
+    return false;
+    }
+  for (size_t i = 0; i < length; ++i)
+    {
+    if (tolower(text[i]) != keyword[i])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+void vtkGeneQueryParser::Next()
+{
+  while (isspace(static_cast<unsigned char>(*this->Position)))
+    {
+    ++this->Position;
+    }
+  this->Text.clear();
+  char c = *this->Position;
+  switch (c)
+    {
+    case 0:
+      this->Token = END;
+      return;
+    case '(':
+      this->Token = LEFT;
+      ++this->Position;
+      return;
+    case ')':
+      this->Token = RIGHT;
+      ++this->Position;
+      return;
+    case ',':
+      this->Token = COMMA;
+      ++this->Position;
+      return;
+    case '!':
+      this->Token = NOT;
+      ++this->Position;
+      return;
+    case '&':
+    case '|':
+      this->Token = c == '&' ? AND : OR;
+      this->Position += this->Position[1] == c ? 2 : 1;
+      return;
+    case '"':
+      {
+      const char* end = strchr(this->Position + 1, '"');
+      end = end ? end : this->Position + strlen(this->Position);
+      this->Text.assign(this->Position + 1, end);
+      this->Token = NAME;
+      this->Position = *end ? end + 1 : end;
+      return;
+      }
+    }
+  const char* begin = this->Position;
+  while (*this->Position && !isspace(static_cast<unsigned char>(*this->Position)) &&
+         !strchr("()&|!,\"", *this->Position))
+    {
+    ++this->Position;
+    }
+  this->Text.assign(begin, this->Position);
+  if (vtkGeneQueryIsKeyword(this->Text, "and"))
+    {
+    this->Token = AND;
+    }
+  else if (vtkGeneQueryIsKeyword(this->Text, "or"))
+    {
+    this->Token = OR;
+    }
+  else if (vtkGeneQueryIsKeyword(this->Text, "not"))
+    {
+    this->Token = NOT;
+    }
+  else
+    {
+    this->Token = NAME;
+    }
+}
+
+bool vtkGeneQueryParser::Expect(int token, const char* what)
+{
+  if (this->Token != token)
+    {
+    this->Error = vtkStdString("Expected ") + what;
+    return false;
+    }
+  this->Next();
+  return true;
+}
+
+bool vtkGeneQueryParser::ParseOr(Bits& bits)
+{
+  if (!this->ParseAnd(bits))
+    {
+    return false;
+    }
+  Bits operand;
+  while (this->Token == OR)
+    {
+    this->Next();
+    if (!this->ParseAnd(operand))
+      {
+      return false;
+      }
+    for (vtkIdType w = 0; w < this->NumberOfWords; ++w)
+      {
+      bits[w] |= operand[w];
+      }
+    }
+  return true;
+}
+
+bool vtkGeneQueryParser::ParseAnd(Bits& bits)
+{
+  if (!this->ParseNot(bits))
+    {
+    return false;
+    }
+  Bits operand;
+  while (this->Token == AND)
+    {
+    this->Next();
+    if (!this->ParseNot(operand))
+      {
+      return false;
+      }
+    for (vtkIdType w = 0; w < this->NumberOfWords; ++w)
+      {
+      bits[w] &= operand[w];
+      }
+    }
+  return true;
+}
+
+bool vtkGeneQueryParser::ParseNot(Bits& bits)
+{
+  if (this->Token != NOT)
+    {
+    return this->ParsePrimary(bits);
+    }
+  this->Next();
+  if (!this->ParseNot(bits))
+    {
+    return false;
+    }
+  for (vtkIdType w = 0; w < this->NumberOfWords; ++w)
+    {
+    bits[w] = ~bits[w];
+    }
+  // Clear the padding past the last cell.
+  if (this->NumberOfCells % 64)
+    {
+    bits[this->NumberOfWords - 1] &=
+      (static_cast<vtkTypeUInt64>(1) << (this->NumberOfCells % 64)) - 1;
+    }
+  return true;
+}
+
+bool vtkGeneQueryParser::ParseNumber(double& value)
+{
+  if (this->Token != NAME || this->Text.empty())
+    {
+    this->Error = "Expected a time";
+    return false;
+    }
+  char* end;
+  value = strtod(this->Text.c_str(), &end);
+  if (*end)
+    {
+    this->Error = "Expected a time instead of " + this->Text;
+    return false;
+    }
+  this->Next();
+  return true;
+}
+
+bool vtkGeneQueryParser::ParsePrimary(Bits& bits)
+{
+  if (this->Token == LEFT)
+    {
+    this->Next();
+    return this->ParseOr(bits) && this->Expect(RIGHT, ")");
+    }
+  if (this->Token != NAME)
+    {
+    this->Error = this->Token == END ?
+      "Unexpected end of query" : "Expected a gene name";
+    return false;
+    }
+
+  vtkStdString name = this->Text;
+  this->Next();
+  if (this->Token == LEFT && vtkGeneQueryIsKeyword(name, "alive"))
+    {
+    double t0, t1;
+    this->Next();
+    if (!this->ParseNumber(t0) || !this->Expect(COMMA, ",") ||
+        !this->ParseNumber(t1) || !this->Expect(RIGHT, ")"))
+      {
+      return false;
+      }
+    if (!this->StartTimes || !this->EndTimes)
+      {
+      this->Error = "alive() needs the start and end times of the cells";
+      return false;
+      }
+    this->AliveCells(t0, t1, bits);
+    return true;
+    }
+
+  vtkIdType gene = this->Index->GetGeneId(name.c_str());
+  if (gene < 0)
+    {
+    this->Error = "Unknown gene " + name;
+    return false;
+    }
+  this->GeneCells(gene, bits);
+  return true;
+}
+
+void vtkGeneQueryParser::GeneCells(vtkIdType gene, Bits& bits)
+{
+  vtkBitMatrix* matrix = this->Index->GetMatrix();
+  if (matrix)
+    {
+    const vtkTypeUInt64* column = matrix->GetColumn(gene);
+    bits.assign(column, column + this->NumberOfWords);
+    return;
+    }
+  bits.assign(this->NumberOfWords, 0);
+  const vtkIdType* offsets = this->Index->GetGeneCellOffsets()->GetPointer(0);
+  const vtkIdType* cells = this->Index->GetGeneCells()->GetPointer(0);
+  for (vtkIdType i = offsets[gene]; i < offsets[gene + 1]; ++i)
+    {
+    bits[cells[i] / 64] |= static_cast<vtkTypeUInt64>(1) << (cells[i] % 64);
+    }
+}
+
+void vtkGeneQueryParser::AliveCells(double t0, double t1, Bits& bits)
+{
+  bits.assign(this->NumberOfWords, 0);
+  vtkIdType numCells = vtksys_stl::min(this->NumberOfCells,
+    vtksys_stl::min(this->StartTimes->GetNumberOfTuples(),
+                    this->EndTimes->GetNumberOfTuples()));
+  for (vtkIdType c = 0; c < numCells; ++c)
+    {
+    if (this->StartTimes->GetTuple1(c) <= t1 && this->EndTimes->GetTuple1(c) >= t0)
+      {
+      bits[c / 64] |= static_cast<vtkTypeUInt64>(1) << (c % 64);
+      }
+    }
+}
+
+vtkGeneQuery::vtkGeneQuery()
+{
+  this->Query = 0;
+  this->StartTimeArrayName = 0;
+  this->EndTimeArrayName = 0;
+  this->SetStartTimeArrayName("StartTime");
+  this->SetEndTimeArrayName("EndTime");
+}
+
+vtkGeneQuery::~vtkGeneQuery()
+{
+  this->SetQuery(0);
+  this->SetStartTimeArrayName(0);
+  this->SetEndTimeArrayName(0);
+}
+
+const char* vtkGeneQuery::GetErrorMessage()
+{
+  return this->ErrorMessage.c_str();
+}
+
+int vtkGeneQuery::Evaluate(vtkCellGeneIndex* index, vtkTree* tree,
+  vtkIdTypeArray* result)
+{
+  this->ErrorMessage.clear();
+  if (!index || !result)
+    {
+    this->ErrorMessage = "No gene data";
+    return 0;
+    }
+
+  vtkGeneQueryParser parser;
+  parser.Position = this->Query ? this->Query : "";
+  parser.Index = index;
+  parser.StartTimes = 0;
+  parser.EndTimes = 0;
+  if (tree && this->StartTimeArrayName && this->EndTimeArrayName)
+    {
+    parser.StartTimes = tree->GetVertexData()->GetArray(this->StartTimeArrayName);
+    parser.EndTimes = tree->GetVertexData()->GetArray(this->EndTimeArrayName);
+    }
+  parser.NumberOfCells = index->GetNumberOfCells();
+  parser.NumberOfWords = (parser.NumberOfCells + 63) / 64;
+
+  vtkGeneQueryParser::Bits bits;
+  parser.Next();
+  if (!parser.ParseOr(bits) || !parser.Expect(vtkGeneQueryParser::END, "end of query"))
+    {
+    this->ErrorMessage = parser.Error;
+    return 0;
+    }
+
+  for (vtkIdType w = 0; w < parser.NumberOfWords; ++w)
+    {
+    for (vtkTypeUInt64 word = bits[w]; word; word &= word - 1)
+      {
+      result->InsertNextValue(w * 64 + vtkGeneQueryTrailingZeros(word));
+      }
+    }
+  return 1;
+}
+
+void vtkGeneQuery::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "Query: " << (this->Query ? this->Query : "(none)") << endl;
+  os << indent << "StartTimeArrayName: "
+     << (this->StartTimeArrayName ? this->StartTimeArrayName : "(none)") << endl;
+  os << indent << "EndTimeArrayName: "
+     << (this->EndTimeArrayName ? this->EndTimeArrayName : "(none)") << endl;
+  os << indent << "ErrorMessage: " << this->ErrorMessage << endl;
+}
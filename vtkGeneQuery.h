@@ -0,0 +1,82 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkGeneQuery - boolean gene expression queries over lineage cells
+//
+// .SECTION Description
+// vtkGeneQuery finds the cells of a lineage tree matching a boolean
+// expression over the genes they express, such as
+//
+//   (geneA AND geneB) AND NOT geneC AND alive(10, 20)
+//
+// A gene name stands for the cells expressing it, AND, OR and NOT (or &, |
+// and !) combine them and alive(t0, t1) stands for the cells whose
+// [StartTime, EndTime] span meets [t0, t1]. NOT binds tighter than AND,
+// which binds tighter than OR. Gene names are looked up in a
+// vtkCellGeneIndex, those containing spaces, parentheses or operators can
+// be double quoted.
+//
+// Every operand is evaluated as a bitset over the cells, one bit per tree
+// vertex, and operators combine whole 64 bit words, so a query costs a few
+// passes over cells / 64 words plus the expressed cells of its genes.
+//
+// .SECTION See Also
+// vtkCellGeneIndex
+
+#ifndef __vtkGeneQuery_h
+#define __vtkGeneQuery_h
+
+#include "vtkObject.h"
+#include "vtkStdString.h" // For ErrorMessage
+
+class vtkCellGeneIndex;
+class vtkIdTypeArray;
+class vtkTree;
+
+class vtkGeneQuery : public vtkObject
+{
+public:
+  static vtkGeneQuery *New();
+  vtkTypeRevisionMacro(vtkGeneQuery,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The query expression.
+  vtkSetStringMacro(Query);
+  vtkGetStringMacro(Query);
+
+  // Description:
+  // The vertex arrays of the tree giving when every cell appears and
+  // divides, used by alive(). Default to "StartTime" and "EndTime".
+  vtkSetStringMacro(StartTimeArrayName);
+  vtkGetStringMacro(StartTimeArrayName);
+  vtkSetStringMacro(EndTimeArrayName);
+  vtkGetStringMacro(EndTimeArrayName);
+
+  // Description:
+  // Evaluate the query against the index and append the matching cells
+  // (tree vertex ids, in increasing order) to result. The tree is only
+  // needed for alive(). Returns 0 if the query is not valid, the reason is
+  // then given by GetErrorMessage().
+  int Evaluate(vtkCellGeneIndex* index, vtkTree* tree, vtkIdTypeArray* result);
+
+  // Description:
+  // Why the last Evaluate failed, empty if it did not.
+  const char* GetErrorMessage();
+
+protected:
+  vtkGeneQuery();
+  ~vtkGeneQuery();
+
+  char* Query;
+  char* StartTimeArrayName;
+  char* EndTimeArrayName;
+
+  vtkStdString ErrorMessage;
+
+private:
+  vtkGeneQuery(const vtkGeneQuery&);  // Not implemented.
+  void operator=(const vtkGeneQuery&);  // Not implemented.
+};
+
+#endif
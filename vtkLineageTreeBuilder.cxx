@@ -0,0 +1,349 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkLineageTreeBuilder.h"
+
+#include "vtkDataArray.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMultiThreader.h"
+#include "vtkMutableDirectedGraph.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
+#include "vtkTree.h"
+
+#include <vtksys/ios/sstream>
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkLineageTreeBuilder, "$Revision$");
+vtkStandardNewMacro(vtkLineageTreeBuilder);
+
+// Rows are sorted per thread by this many at least.
+#define VTK_LINEAGE_TREE_BUILDER_GRAIN 65536
+
+// A cell id and its row, sorted by id.
+class vtkLineageTreeBuilderKey
+{
+public:
+  vtkIdType Id;
+  vtkIdType Row;
+
+  bool operator<(const vtkLineageTreeBuilderKey& other) const
+    {
+    return this->Id < other.Id || (this->Id == other.Id && this->Row < other.Row);
+    }
+};
+
+// Sorts the keys in parallel, every thread sorting one range, ranges being
+// merged pairwise afterwards.
+class vtkLineageTreeBuilderSort
+{
+public:
+  vtksys_stl::vector<vtkLineageTreeBuilderKey>* Keys;
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg)
+    {
+    vtkMultiThreader::ThreadInfo* info =
+      static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    vtkLineageTreeBuilderSort* self =
+      static_cast<vtkLineageTreeBuilderSort*>(info->UserData);
+    vtksys_stl::vector<vtkLineageTreeBuilderKey>& keys = *self->Keys;
+    size_t begin = keys.size() * info->ThreadID / info->NumberOfThreads;
+    size_t end = keys.size() * (info->ThreadID + 1) / info->NumberOfThreads;
+    vtksys_stl::sort(keys.begin() + begin, keys.begin() + end);
+    return VTK_THREAD_RETURN_VALUE;
+    }
+
+  void Sort(int numThreads)
+    {
+    vtksys_stl::vector<vtkLineageTreeBuilderKey>& keys = *this->Keys;
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(Execute, this);
+    threader->SingleMethodExecute();
+    for (int width = 1; width < numThreads; width *= 2)
+      {
+      for (int t = 0; t + width < numThreads; t += 2 * width)
+        {
+        int last = vtksys_stl::min(t + 2 * width, numThreads);
+        vtksys_stl::inplace_merge(
+          keys.begin() + keys.size() * t / numThreads,
+          keys.begin() + keys.size() * (t + width) / numThreads,
+          keys.begin() + keys.size() * last / numThreads);
+        }
+      }
+    }
+};
+
+// Orders the children of a cell by start time, then cell id.
+class vtkLineageTreeBuilderChildLess
+{
+public:
+  const double* StartTimes;
+  const vtkIdType* Cells;
+
+  bool operator()(vtkIdType a, vtkIdType b) const
+    {
+    if (this->StartTimes && this->StartTimes[a] != this->StartTimes[b])
+      {
+      return this->StartTimes[a] < this->StartTimes[b];
+      }
+    return this->Cells[a] < this->Cells[b];
+    }
+};
+
+vtkLineageTreeBuilder::vtkLineageTreeBuilder()
+{
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->NumberOfRoots = 0;
+}
+
+vtkLineageTreeBuilder::~vtkLineageTreeBuilder()
+{
+}
+
+const char* vtkLineageTreeBuilder::GetErrorMessage()
+{
+  return this->ErrorMessage.c_str();
+}
+
+int vtkLineageTreeBuilder::Build(vtkIdTypeArray* cells, vtkIdTypeArray* parents,
+  vtkDataArray* startTimes, vtkDataArray* endTimes, vtkStringArray* names,
+  vtkTree* output)
+{
+  this->ErrorMessage.clear();
+  this->NumberOfRoots = 0;
+  vtkIdType numRows = cells ? cells->GetNumberOfTuples() : 0;
+  if (!cells || !parents || !output || parents->GetNumberOfTuples() != numRows ||
+      (startTimes && startTimes->GetNumberOfTuples() != numRows) ||
+      (endTimes && endTimes->GetNumberOfTuples() != numRows) ||
+      (names && names->GetNumberOfValues() != numRows))
+    {
+    this->ErrorMessage = "Columns of different lengths";
+    return 0;
+    }
+  if (numRows == 0)
+    {
+    this->ErrorMessage = "No cells";
+    return 0;
+    }
+  const vtkIdType* cellIds = cells->GetPointer(0);
+  const vtkIdType* parentIds = parents->GetPointer(0);
+  vtksys_ios::ostringstream error;
+
+  // Sort the cell ids to find parents by binary search.
+  vtksys_stl::vector<vtkLineageTreeBuilderKey> keys(numRows);
+  for (vtkIdType r = 0; r < numRows; ++r)
+    {
+    keys[r].Id = cellIds[r];
+    keys[r].Row = r;
+    }
+  vtkLineageTreeBuilderSort sort;
+  sort.Keys = &keys;
+  sort.Sort(static_cast<int>(vtksys_stl::min(static_cast<vtkIdType>(this->NumberOfThreads),
+    numRows / VTK_LINEAGE_TREE_BUILDER_GRAIN + 1)));
+  for (vtkIdType k = 1; k < numRows; ++k)
+    {
+    if (keys[k].Id == keys[k - 1].Id)
+      {
+      error << "Duplicate cell id " << keys[k].Id;
+      this->ErrorMessage = error.str();
+      return 0;
+      }
+    }
+
+  // The parent row of every row, numRows for roots, and the number of
+  // children of every row.
+  vtksys_stl::vector<vtkIdType> parentRows(numRows);
+  vtksys_stl::vector<vtkIdType> offsets(numRows + 2, 0);
+  for (vtkIdType r = 0; r < numRows; ++r)
+    {
+    vtkIdType parentRow = numRows;
+    if (parentIds[r] >= 0)
+      {
+      vtkLineageTreeBuilderKey key;
+      key.Id = parentIds[r];
+      key.Row = -1;
+      vtksys_stl::vector<vtkLineageTreeBuilderKey>::iterator it =
+        vtksys_stl::lower_bound(keys.begin(), keys.end(), key);
+      if (it == keys.end() || it->Id != parentIds[r])
+        {
+        error << "Cell " << cellIds[r] << " has parent " << parentIds[r]
+              << " which is not in the table";
+        this->ErrorMessage = error.str();
+        return 0;
+        }
+      parentRow = it->Row;
+      }
+    parentRows[r] = parentRow;
+    ++offsets[parentRow + 1];
+    }
+  this->NumberOfRoots = offsets[numRows + 1];
+  if (this->NumberOfRoots == 0)
+    {
+    this->ErrorMessage = "No root cell, every cell has a parent";
+    return 0;
+    }
+
+  // Children of row r are children[offsets[r], offsets[r + 1]), roots
+  // those of row numRows.
+  for (vtkIdType r = 0; r <= numRows; ++r)
+    {
+    offsets[r + 1] += offsets[r];
+    }
+  vtksys_stl::vector<vtkIdType> children(numRows);
+  vtksys_stl::vector<vtkIdType> next(offsets.begin(), offsets.end() - 1);
+  for (vtkIdType r = 0; r < numRows; ++r)
+    {
+    children[next[parentRows[r]]++] = r;
+    }
+  vtksys_stl::vector<double> starts;
+  if (startTimes)
+    {
+    starts.resize(numRows);
+    for (vtkIdType r = 0; r < numRows; ++r)
+      {
+      starts[r] = startTimes->GetTuple1(r);
+      }
+    }
+  vtkLineageTreeBuilderChildLess less;
+  less.StartTimes = startTimes ? &starts[0] : 0;
+  less.Cells = cellIds;
+  for (vtkIdType r = 0; r <= numRows; ++r)
+    {
+    if (offsets[r + 1] - offsets[r] > 1)
+      {
+      vtksys_stl::sort(children.begin() + offsets[r], children.begin() + offsets[r + 1], less);
+      }
+    }
+
+  // Number the vertices in preorder from the roots, behind the common root
+  // if there are several. Every row has a single parent, so rows the walk
+  // does not reach are on a cycle.
+  vtkIdType firstVertex = this->NumberOfRoots > 1 ? 1 : 0;
+  vtksys_stl::vector<vtkIdType> vertexRows(numRows);
+  vtksys_stl::vector<vtkIdType> rowVertices(numRows, -1);
+  vtksys_stl::vector<vtkIdType> stack(children.begin() + offsets[numRows], children.end());
+  vtksys_stl::reverse(stack.begin(), stack.end());
+  vtkIdType numVisited = 0;
+  while (!stack.empty())
+    {
+    vtkIdType r = stack.back();
+    stack.pop_back();
+    rowVertices[r] = firstVertex + numVisited;
+    vertexRows[numVisited++] = r;
+    for (vtkIdType c = offsets[r + 1]; c > offsets[r]; --c)
+      {
+      stack.push_back(children[c - 1]);
+      }
+    }
+  if (numVisited < numRows)
+    {
+    vtkIdType r = 0;
+    while (rowVertices[r] >= 0)
+      {
+      ++r;
+      }
+    // That row may only descend from a cycle, the ancestors of an
+    // unreached row are unreached too: follow them until one repeats.
+    while (rowVertices[r] == -1)
+      {
+      rowVertices[r] = -2;
+      r = parentRows[r];
+      }
+    error << "Cell " << cellIds[r] << " is its own ancestor";
+    this->ErrorMessage = error.str();
+    return 0;
+    }
+
+  // Edges are added in preorder, which keeps the children in order.
+  vtkIdType numVertices = firstVertex + numRows;
+  vtkSmartPointer<vtkMutableDirectedGraph> builder =
+    vtkSmartPointer<vtkMutableDirectedGraph>::New();
+  for (vtkIdType v = 0; v < numVertices; ++v)
+    {
+    builder->AddVertex();
+    }
+  for (vtkIdType i = 0; i < numRows; ++i)
+    {
+    vtkIdType parentRow = parentRows[vertexRows[i]];
+    if (parentRow < numRows)
+      {
+      builder->AddEdge(rowVertices[parentRow], firstVertex + i);
+      }
+    else if (firstVertex > 0)
+      {
+      builder->AddEdge(0, firstVertex + i);
+      }
+    }
+
+  vtkSmartPointer<vtkStringArray> nameArray = vtkSmartPointer<vtkStringArray>::New();
+  nameArray->SetName("name");
+  nameArray->SetNumberOfValues(numVertices);
+  vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+  cellArray->SetName("CellId");
+  cellArray->SetNumberOfValues(numVertices);
+  vtkSmartPointer<vtkIdTypeArray> pedigreeArray = vtkSmartPointer<vtkIdTypeArray>::New();
+  pedigreeArray->SetName("PedigreeVertexId");
+  pedigreeArray->SetNumberOfValues(numVertices);
+  vtkSmartPointer<vtkDoubleArray> startArray = vtkSmartPointer<vtkDoubleArray>::New();
+  startArray->SetName("StartTime");
+  startArray->SetNumberOfValues(numVertices);
+  vtkSmartPointer<vtkDoubleArray> endArray = vtkSmartPointer<vtkDoubleArray>::New();
+  endArray->SetName("EndTime");
+  endArray->SetNumberOfValues(numVertices);
+  double firstStart = 0.0;
+  for (vtkIdType i = 0; i < numRows; ++i)
+    {
+    vtkIdType r = vertexRows[i];
+    vtkIdType v = firstVertex + i;
+    if (names)
+      {
+      nameArray->SetValue(v, names->GetValue(r));
+      }
+    else
+      {
+      vtksys_ios::ostringstream name;
+      name << cellIds[r];
+      nameArray->SetValue(v, name.str());
+      }
+    cellArray->SetValue(v, cellIds[r]);
+    pedigreeArray->SetValue(v, v);
+    double start = startTimes ? starts[r] : 0.0;
+    startArray->SetValue(v, start);
+    endArray->SetValue(v, endTimes ? endTimes->GetTuple1(r) : 0.0);
+    firstStart = (i == 0 || start < firstStart) ? start : firstStart;
+    }
+  if (firstVertex > 0)
+    {
+    nameArray->SetValue(0, "root");
+    cellArray->SetValue(0, -1);
+    pedigreeArray->SetValue(0, 0);
+    startArray->SetValue(0, firstStart);
+    endArray->SetValue(0, firstStart);
+    }
+  vtkDataSetAttributes* vertexData = builder->GetVertexData();
+  vertexData->AddArray(nameArray);
+  vertexData->AddArray(cellArray);
+  vertexData->AddArray(pedigreeArray);
+  vertexData->AddArray(startArray);
+  vertexData->AddArray(endArray);
+
+  if (!output->CheckedShallowCopy(builder))
+    {
+    this->ErrorMessage = "The cells do not form a tree";
+    return 0;
+    }
+  return 1;
+}
+
+void vtkLineageTreeBuilder::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
+  os << indent << "NumberOfRoots: " << this->NumberOfRoots << endl;
+  os << indent << "ErrorMessage: " << this->ErrorMessage << endl;
+}
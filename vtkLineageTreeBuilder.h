@@ -0,0 +1,83 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkLineageTreeBuilder - builds a lineage tree from a tracking table
+//
+// .SECTION Description
+// vtkLineageTreeBuilder turns the rows of a cell tracking table, a cell id
+// and the id of its parent per row, into a vtkTree whose vertices carry
+// the "name", "CellId", "PedigreeVertexId", "StartTime" and "EndTime"
+// arrays the viewer uses.
+//
+// Cell ids are sorted in parallel once, so that every parent is found by
+// binary search. Rows are then bucketed by parent, the child offsets of
+// every row being a prefix sum of the child counts, and the children of a
+// cell ordered by start time. A single preorder walk from the roots numbers
+// the vertices, parents before their children, and the tree is built with
+// its edges in that order. The whole costs O(n log n).
+//
+// A parent id that is not a cell of the table (an orphan) or a duplicate
+// cell id fails the build. Since every cell has at most one parent, cells
+// the walk does not reach lie on a parent cycle, which fails it too. When
+// the table has several roots, a vertex named "root" is added as their
+// common parent.
+//
+// .SECTION See Also
+// vtkLineageTreeReader
+
+#ifndef __vtkLineageTreeBuilder_h
+#define __vtkLineageTreeBuilder_h
+
+#include "vtkObject.h"
+#include "vtkStdString.h" // For ErrorMessage
+
+class vtkDataArray;
+class vtkIdTypeArray;
+class vtkStringArray;
+class vtkTree;
+
+class vtkLineageTreeBuilder : public vtkObject
+{
+public:
+  static vtkLineageTreeBuilder *New();
+  vtkTypeRevisionMacro(vtkLineageTreeBuilder,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The number of threads sorting cell ids, defaults to the number of
+  // processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, 256);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Build the tree of a tracking table into output. Row i is the cell
+  // cells[i], child of parents[i] or a root if that is negative.
+  // startTimes, endTimes and names may be null, times then default to 0
+  // and names to the cell ids. Returns 0 if the rows do not form a
+  // lineage, the reason is then given by GetErrorMessage().
+  int Build(vtkIdTypeArray* cells, vtkIdTypeArray* parents,
+    vtkDataArray* startTimes, vtkDataArray* endTimes, vtkStringArray* names,
+    vtkTree* output);
+
+  // Description:
+  // Why the last Build failed, empty if it did not.
+  const char* GetErrorMessage();
+
+  // Description:
+  // The number of roots of the table of the last Build.
+  vtkGetMacro(NumberOfRoots, vtkIdType);
+
+protected:
+  vtkLineageTreeBuilder();
+  ~vtkLineageTreeBuilder();
+
+  int NumberOfThreads;
+  vtkIdType NumberOfRoots;
+  vtkStdString ErrorMessage;
+
+private:
+  vtkLineageTreeBuilder(const vtkLineageTreeBuilder&);  // Not implemented.
+  void operator=(const vtkLineageTreeBuilder&);  // Not implemented.
+};
+
+#endif
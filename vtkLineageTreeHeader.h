@@ -0,0 +1,86 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkLineageTreeHeader - header of binary lineage tree files
+//
+// .SECTION Description
+// A binary lineage file, written by vtkLineageTreeWriter (LineageToBinary)
+// and read by vtkLineageTreeReader, holds a lineage tree as arrays that are
+// copied into the tree rather than parsed. It starts with this header,
+// followed by sections that are all 8 byte aligned, located by their byte
+// offset from the start of the file:
+//
+// - Parents, NumberOfVertices int64: the parent of every vertex, -1 for
+//   the root;
+// - EdgeTargets, NumberOfVertices - 1 int64: the child vertex of every
+//   edge in edge order, which keeps the order of the children;
+// - Columns, NumberOfColumns vtkLineageTreeColumn describing the vertex
+//   arrays, each with its own sections.
+//
+// A column of numbers holds NumberOfVertices tuples of its VTK type,
+// vtkIdType values being stored as int64. A column of strings (VTK_STRING)
+// is interned: Values holds a uint32 per vertex indexing a table of
+// NumberOfStrings strings, string i being the bytes
+// [StringOffsets[i], StringOffsets[i + 1]) of StringBytes.
+//
+// Values are in the byte order of the machine that wrote the file,
+// ByteOrder tells it apart from a file written with the other order.
+
+#ifndef __vtkLineageTreeHeader_h
+#define __vtkLineageTreeHeader_h
+
+#include "vtkType.h"
+
+#define VTK_LINEAGE_TREE_MAGIC "CLTREE01"
+#define VTK_LINEAGE_TREE_BYTE_ORDER 0x0102030405060708LL
+#define VTK_LINEAGE_TREE_NAME_SIZE 48
+
+struct vtkLineageTreeHeader
+{
+  char Magic[8];
+  vtkTypeInt64 ByteOrder;
+  vtkTypeInt64 FileSize;
+  vtkTypeInt64 NumberOfVertices;
+  vtkTypeInt64 NumberOfColumns;
+  vtkTypeInt64 Parents;
+  vtkTypeInt64 EdgeTargets;
+  vtkTypeInt64 Columns;
+};
+
+struct vtkLineageTreeColumn
+{
+  char Name[VTK_LINEAGE_TREE_NAME_SIZE];
+  vtkTypeInt64 DataType;
+  vtkTypeInt64 NumberOfComponents;
+  vtkTypeInt64 Values;
+  vtkTypeInt64 NumberOfStrings;
+  vtkTypeInt64 StringOffsets;
+  vtkTypeInt64 StringBytes;
+};
+
+// The size in the file of a value of a column type, 0 for types that
+// binary lineage files do not hold.
+static inline int vtkLineageTreeValueSize(vtkTypeInt64 type)
+{
+  switch (type)
+    {
+    case VTK_CHAR:
+    case VTK_SIGNED_CHAR:
+    case VTK_UNSIGNED_CHAR:
+      return 1;
+    case VTK_SHORT:
+    case VTK_UNSIGNED_SHORT:
+      return 2;
+    case VTK_INT:
+    case VTK_UNSIGNED_INT:
+    case VTK_FLOAT:
+    case VTK_STRING:
+      return 4;
+    case VTK_DOUBLE:
+    case VTK_ID_TYPE:
+      return 8;
+    }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,411 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkLineageTreeIndex.h"
+
+#include "vtkDataSetAttributes.h"
+#include "vtkIdTypeArray.h"
+#include "vtkObjectFactory.h"
+#include "vtkOutEdgeIterator.h"
+#include "vtkSmartPointer.h"
+#include "vtkTree.h"
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkLineageTreeIndex, "$Revision$");
+vtkStandardNewMacro(vtkLineageTreeIndex);
+
+class vtkLineageTreeIndexInternals
+{
+public:
+  // Dense pedigree id to vertex map, -1 where there is no vertex.
+  vtksys_stl::vector<vtkIdType> PedigreeToVertex;
+
+  // Scratch flags of the vertices visited by a query, cleared after it.
+  enum
+    {
+    FOUND = 1,
+    GIVEN = 2,
+    VISITED = 4
+    };
+  vtksys_stl::vector<unsigned char> Flags;
+  vtksys_stl::vector<vtkIdType> Touched;
+
+  void Flag(vtkIdType v, unsigned char flag)
+    {
+    if (!this->Flags[v])
+      {
+      this->Touched.push_back(v);
+      }
+    this->Flags[v] |= flag;
+    }
+  void ClearFlags()
+    {
+    for (vtksys_stl::vector<vtkIdType>::size_type i = 0; i < this->Touched.size(); ++i)
+      {
+      this->Flags[this->Touched[i]] = 0;
+      }
+    this->Touched.clear();
+    }
+};
+
+// Orders vertices by preorder position.
+class vtkLineageTreeIndexPreorderLess
+{
+public:
+  vtkLineageTreeIndexPreorderLess(const vtkIdType* preIndex) : PreIndex(preIndex) {}
+  bool operator()(vtkIdType a, vtkIdType b) const
+    {
+    return this->PreIndex[a] < this->PreIndex[b];
+    }
+  const vtkIdType* PreIndex;
+};
+
+vtkLineageTreeIndex::vtkLineageTreeIndex()
+{
+  this->Tree = 0;
+  this->TreeMTime = 0;
+  this->Pedigree = 0;
+  this->Parent = vtkIdTypeArray::New();
+  this->PreorderIndex = vtkIdTypeArray::New();
+  this->PreorderVertex = vtkIdTypeArray::New();
+  this->SubtreeEnd = vtkIdTypeArray::New();
+  this->Depth = vtkIdTypeArray::New();
+  this->GenerationOffsets = vtkIdTypeArray::New();
+  this->GenerationVertices = vtkIdTypeArray::New();
+  this->Internals = new vtkLineageTreeIndexInternals;
+}
+
+vtkLineageTreeIndex::~vtkLineageTreeIndex()
+{
+  this->Parent->Delete();
+  this->PreorderIndex->Delete();
+  this->PreorderVertex->Delete();
+  this->SubtreeEnd->Delete();
+  this->Depth->Delete();
+  this->GenerationOffsets->Delete();
+  this->GenerationVertices->Delete();
+  delete this->Internals;
+}
+
+void vtkLineageTreeIndex::Initialize()
+{
+  this->Tree = 0;
+  this->TreeMTime = 0;
+  this->Pedigree = 0;
+  this->Parent->Initialize();
+  this->PreorderIndex->Initialize();
+  this->PreorderVertex->Initialize();
+  this->SubtreeEnd->Initialize();
+  this->Depth->Initialize();
+  this->GenerationOffsets->Initialize();
+  this->GenerationVertices->Initialize();
+  this->Internals->PedigreeToVertex.clear();
+  this->Internals->Flags.clear();
+  this->Modified();
+}
+
+vtkIdType vtkLineageTreeIndex::GetNumberOfVertices()
+{
+  return this->Parent->GetNumberOfTuples();
+}
+
+vtkIdType vtkLineageTreeIndex::GetNumberOfGenerations()
+{
+  vtkIdType numOffsets = this->GenerationOffsets->GetNumberOfTuples();
+  return numOffsets > 0 ? numOffsets - 1 : 0;
+}
+
+vtkIdType vtkLineageTreeIndex::GetPedigree(vtkIdType vertex)
+{
+  return this->Pedigree ? this->Pedigree->GetValue(vertex) : vertex;
+}
+
+vtkIdType vtkLineageTreeIndex::GetVertexFromPedigree(vtkIdType pedigree)
+{
+  if (pedigree < 0 ||
+      pedigree >= static_cast<vtkIdType>(this->Internals->PedigreeToVertex.size()))
+    {
+    return -1;
+    }
+  return this->Internals->PedigreeToVertex[pedigree];
+}
+
+void vtkLineageTreeIndex::Build(vtkTree* tree)
+{
+  if (!tree)
+    {
+    this->Initialize();
+    return;
+    }
+  if (tree == this->Tree && tree->GetMTime() == this->TreeMTime)
+    {
+    return;
+    }
+  this->Tree = tree;
+  this->TreeMTime = tree->GetMTime();
+  this->Pedigree = vtkIdTypeArray::SafeDownCast(
+    tree->GetVertexData()->GetAbstractArray("PedigreeVertexId"));
+
+  vtkIdType numVertices = tree->GetNumberOfVertices();
+  this->Parent->SetNumberOfValues(numVertices);
+  this->PreorderIndex->SetNumberOfValues(numVertices);
+  this->PreorderVertex->SetNumberOfValues(numVertices);
+  this->SubtreeEnd->SetNumberOfValues(numVertices);
+  this->Depth->SetNumberOfValues(numVertices);
+  vtkIdType* parent = this->Parent->GetPointer(0);
+  vtkIdType* preIndex = this->PreorderIndex->GetPointer(0);
+  vtkIdType* preVertex = this->PreorderVertex->GetPointer(0);
+  vtkIdType* subtreeEnd = this->SubtreeEnd->GetPointer(0);
+  vtkIdType* depth = this->Depth->GetPointer(0);
+
+  // Preorder numbering with an explicit stack, children in edge order.
+  vtkIdType next = 0;
+  if (numVertices > 0)
+    {
+    vtksys_stl::vector<vtkIdType> stack;
+    vtksys_stl::vector<vtkIdType> children;
+    vtkSmartPointer<vtkOutEdgeIterator> it =
+      vtkSmartPointer<vtkOutEdgeIterator>::New();
+    stack.push_back(tree->GetRoot());
+    parent[tree->GetRoot()] = -1;
+    while (!stack.empty())
+      {
+      vtkIdType v = stack.back();
+      stack.pop_back();
+      preIndex[v] = next;
+      preVertex[next] = v;
+      ++next;
+      children.clear();
+      tree->GetOutEdges(v, it);
+      while (it->HasNext())
+        {
+        vtkIdType child = it->Next().Target;
+        parent[child] = v;
+        children.push_back(child);
+        }
+      stack.insert(stack.end(), children.rbegin(), children.rend());
+      }
+    }
+
+  // Depths follow parents down in preorder, subtree sizes accumulate from
+  // the leaves up in reverse preorder.
+  for (vtkIdType i = 0; i < next; ++i)
+    {
+    vtkIdType v = preVertex[i];
+    depth[v] = parent[v] < 0 ? 0 : depth[parent[v]] + 1;
+    subtreeEnd[v] = 1;
+    }
+  for (vtkIdType i = next - 1; i > 0; --i)
+    {
+    vtkIdType v = preVertex[i];
+    subtreeEnd[parent[v]] += subtreeEnd[v];
+    }
+  for (vtkIdType i = 0; i < next; ++i)
+    {
+    vtkIdType v = preVertex[i];
+    subtreeEnd[v] += i;
+    }
+
+  // Bucket the vertices by generation, keeping them in preorder.
+  vtkIdType numGenerations = 0;
+  for (vtkIdType v = 0; v < next; ++v)
+    {
+    numGenerations = depth[v] + 1 > numGenerations ? depth[v] + 1 : numGenerations;
+    }
+  this->GenerationOffsets->SetNumberOfValues(numGenerations + 1);
+  this->GenerationVertices->SetNumberOfValues(next);
+  vtkIdType* genOffsets = this->GenerationOffsets->GetPointer(0);
+  vtkIdType* genVertices = this->GenerationVertices->GetPointer(0);
+  vtksys_stl::fill(genOffsets, genOffsets + numGenerations + 1, 0);
+  for (vtkIdType v = 0; v < next; ++v)
+    {
+    ++genOffsets[depth[v] + 1];
+    }
+  for (vtkIdType g = 0; g < numGenerations; ++g)
+    {
+    genOffsets[g + 1] += genOffsets[g];
+    }
+  vtksys_stl::vector<vtkIdType> fill(genOffsets, genOffsets + numGenerations);
+  for (vtkIdType i = 0; i < next; ++i)
+    {
+    vtkIdType v = preVertex[i];
+    genVertices[fill[depth[v]]++] = v;
+    }
+  this->Internals->Flags.assign(numVertices, 0);
+  this->Internals->Touched.clear();
+
+  vtksys_stl::vector<vtkIdType>& pedigreeToVertex = this->Internals->PedigreeToVertex;
+  pedigreeToVertex.assign(numVertices, -1);
+  for (vtkIdType v = 0; v < numVertices; ++v)
+    {
+    vtkIdType pedigree = this->GetPedigree(v);
+    if (pedigree < 0)
+      {
+      continue;
+      }
+    if (pedigree >= static_cast<vtkIdType>(pedigreeToVertex.size()))
+      {
+      pedigreeToVertex.resize(pedigree + 1, -1);
+      }
+    pedigreeToVertex[pedigree] = v;
+    }
+  this->Modified();
+}
+
+void vtkLineageTreeIndex::GetDescendants(vtkIdTypeArray* vertices,
+  vtkIdTypeArray* result, int includeSelf)
+{
+  // Visit the given vertices in preorder, those inside the subtree of a
+  // previous one are already covered by its interval.
+  const vtkIdType* preIndex = this->PreorderIndex->GetPointer(0);
+  const vtkIdType* preVertex = this->PreorderVertex->GetPointer(0);
+  const vtkIdType* subtreeEnd = this->SubtreeEnd->GetPointer(0);
+  vtksys_stl::vector<vtkIdType> sorted(vertices->GetPointer(0),
+    vertices->GetPointer(0) + vertices->GetNumberOfTuples());
+  vtksys_stl::sort(sorted.begin(), sorted.end(),
+    vtkLineageTreeIndexPreorderLess(preIndex));
+  vtkIdType coveredEnd = 0;
+  for (vtksys_stl::vector<vtkIdType>::size_type k = 0; k < sorted.size(); ++k)
+    {
+    vtkIdType v = sorted[k];
+    if (preIndex[v] < coveredEnd)
+      {
+      continue;
+      }
+    vtkIdType first = includeSelf ? preIndex[v] : preIndex[v] + 1;
+    coveredEnd = subtreeEnd[v];
+    vtksys_stl::copy(preVertex + first, preVertex + subtreeEnd[v],
+      result->WritePointer(result->GetNumberOfTuples(), subtreeEnd[v] - first));
+    }
+}
+
+void vtkLineageTreeIndex::GetAncestors(vtkIdTypeArray* vertices,
+  vtkIdTypeArray* result, int includeSelf)
+{
+  // Walk up from every vertex until reaching one already found.
+  vtkLineageTreeIndexInternals* internals = this->Internals;
+  const vtkIdType* parent = this->Parent->GetPointer(0);
+  vtkIdType numGiven = vertices->GetNumberOfTuples();
+  for (vtkIdType k = 0; k < numGiven; ++k)
+    {
+    vtkIdType v = vertices->GetValue(k);
+    vtkIdType u = includeSelf ? v : parent[v];
+    while (u >= 0 && !(internals->Flags[u] & vtkLineageTreeIndexInternals::FOUND))
+      {
+      internals->Flag(u, vtkLineageTreeIndexInternals::FOUND);
+      result->InsertNextValue(u);
+      u = parent[u];
+      }
+    }
+  internals->ClearFlags();
+}
+
+void vtkLineageTreeIndex::GetSiblings(vtkIdTypeArray* vertices,
+  vtkIdTypeArray* result, int includeSelf)
+{
+  // Children of a vertex are found by jumping from one subtree interval
+  // to the next, every parent is visited once.
+  vtkLineageTreeIndexInternals* internals = this->Internals;
+  const vtkIdType* parent = this->Parent->GetPointer(0);
+  const vtkIdType* preIndex = this->PreorderIndex->GetPointer(0);
+  const vtkIdType* preVertex = this->PreorderVertex->GetPointer(0);
+  const vtkIdType* subtreeEnd = this->SubtreeEnd->GetPointer(0);
+  vtkIdType numGiven = vertices->GetNumberOfTuples();
+  for (vtkIdType k = 0; k < numGiven; ++k)
+    {
+    internals->Flag(vertices->GetValue(k), vtkLineageTreeIndexInternals::GIVEN);
+    }
+  for (vtkIdType k = 0; k < numGiven; ++k)
+    {
+    vtkIdType v = vertices->GetValue(k);
+    vtkIdType p = parent[v];
+    if (p < 0)
+      {
+      if (includeSelf && !(internals->Flags[v] & vtkLineageTreeIndexInternals::FOUND))
+        {
+        internals->Flag(v, vtkLineageTreeIndexInternals::FOUND);
+        result->InsertNextValue(v);
+        }
+      continue;
+      }
+    if (internals->Flags[p] & vtkLineageTreeIndexInternals::VISITED)
+      {
+      continue;
+      }
+    internals->Flag(p, vtkLineageTreeIndexInternals::VISITED);
+    for (vtkIdType i = preIndex[p] + 1; i < subtreeEnd[p]; i = subtreeEnd[preVertex[i]])
+      {
+      vtkIdType c = preVertex[i];
+      if (includeSelf || !(internals->Flags[c] & vtkLineageTreeIndexInternals::GIVEN))
+        {
+        internals->Flag(c, vtkLineageTreeIndexInternals::FOUND);
+        result->InsertNextValue(c);
+        }
+      }
+    }
+  internals->ClearFlags();
+}
+
+void vtkLineageTreeIndex::GetGenerations(vtkIdTypeArray* vertices,
+  vtkIdTypeArray* result, int includeSelf)
+{
+  const vtkIdType* depth = this->Depth->GetPointer(0);
+  vtksys_stl::vector<unsigned char> generations(this->GetNumberOfGenerations(), 0);
+  vtkLineageTreeIndexInternals* internals = this->Internals;
+  vtkIdType numGiven = vertices->GetNumberOfTuples();
+  for (vtkIdType k = 0; k < numGiven; ++k)
+    {
+    internals->Flag(vertices->GetValue(k), vtkLineageTreeIndexInternals::GIVEN);
+    }
+  for (vtkIdType k = 0; k < numGiven; ++k)
+    {
+    vtkIdType v = vertices->GetValue(k);
+    if (!generations[depth[v]])
+      {
+      generations[depth[v]] = 1;
+      vtkIdType size = result->GetNumberOfTuples();
+      this->GetGeneration(depth[v], result);
+      if (!includeSelf)
+        {
+        // Drop the given vertices from the appended generation.
+        vtkIdType* values = result->GetPointer(0);
+        vtkIdType end = result->GetNumberOfTuples();
+        vtkIdType kept = size;
+        for (vtkIdType i = size; i < end; ++i)
+          {
+          if (!(internals->Flags[values[i]] & vtkLineageTreeIndexInternals::GIVEN))
+            {
+            values[kept++] = values[i];
+            }
+          }
+        result->SetNumberOfValues(kept);
+        }
+      }
+    }
+  internals->ClearFlags();
+}
+
+void vtkLineageTreeIndex::GetGeneration(vtkIdType generation,
+  vtkIdTypeArray* result)
+{
+  if (generation < 0 || generation >= this->GetNumberOfGenerations())
+    {
+    return;
+    }
+  const vtkIdType* genOffsets = this->GenerationOffsets->GetPointer(0);
+  const vtkIdType* genVertices = this->GenerationVertices->GetPointer(0);
+  vtkIdType count = genOffsets[generation + 1] - genOffsets[generation];
+  vtksys_stl::copy(genVertices + genOffsets[generation],
+    genVertices + genOffsets[generation + 1],
+    result->WritePointer(result->GetNumberOfTuples(), count));
+}
+
+void vtkLineageTreeIndex::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "Tree: " << this->Tree << endl;
+  os << indent << "NumberOfVertices: " << this->GetNumberOfVertices() << endl;
+  os << indent << "NumberOfGenerations: " << this->GetNumberOfGenerations() << endl;
+}
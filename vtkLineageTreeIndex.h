@@ -0,0 +1,119 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkLineageTreeIndex - flat traversal arrays of a lineage tree
+//
+// .SECTION Description
+// vtkLineageTreeIndex computes, in one depth first pass, flat arrays
+// describing a vtkTree: the parent of every vertex, a preorder numbering
+// and the preorder interval of every subtree, so that the descendants of v
+// are the vertices PreorderVertex[PreorderIndex[v] + 1, SubtreeEnd[v]),
+// and the depth (generation) of every vertex, with the vertices of every
+// generation grouped together.
+// It also maps pedigree ids ("PedigreeVertexId" vertex array) back to
+// vertices. Build() is a no-op while the tree is unmodified, so filters
+// can keep an index around and query it between executions.
+
+#ifndef __vtkLineageTreeIndex_h
+#define __vtkLineageTreeIndex_h
+
+#include "vtkObject.h"
+
+class vtkIdTypeArray;
+class vtkTree;
+class vtkLineageTreeIndexInternals;
+
+class vtkLineageTreeIndex : public vtkObject
+{
+public:
+  static vtkLineageTreeIndex *New();
+  vtkTypeRevisionMacro(vtkLineageTreeIndex,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Index the tree. Does nothing if this tree was already indexed and has
+  // not been modified since.
+  void Build(vtkTree* tree);
+
+  // Description:
+  // Forget the indexed tree.
+  void Initialize();
+
+  // Description:
+  // The indexed tree and its number of vertices.
+  vtkTree* GetTree() { return this->Tree; }
+  vtkIdType GetNumberOfVertices();
+
+  // Description:
+  // The parent of every vertex, -1 for the root.
+  vtkGetObjectMacro(Parent, vtkIdTypeArray);
+
+  // Description:
+  // The preorder position of every vertex, and the vertex at every
+  // preorder position.
+  vtkGetObjectMacro(PreorderIndex, vtkIdTypeArray);
+  vtkGetObjectMacro(PreorderVertex, vtkIdTypeArray);
+
+  // Description:
+  // One past the preorder position of the last descendant of every vertex.
+  vtkGetObjectMacro(SubtreeEnd, vtkIdTypeArray);
+
+  // Description:
+  // The generation of every vertex, 0 for the root.
+  vtkGetObjectMacro(Depth, vtkIdTypeArray);
+
+  // Description:
+  // The vertices of every generation in preorder. Those of generation g are
+  // GenerationVertices[GenerationOffsets[g], GenerationOffsets[g + 1]).
+  vtkGetObjectMacro(GenerationOffsets, vtkIdTypeArray);
+  vtkGetObjectMacro(GenerationVertices, vtkIdTypeArray);
+  vtkIdType GetNumberOfGenerations();
+
+  // Description:
+  // Append to result the descendants, the ancestors up to the root, the
+  // siblings or the whole generations of the given vertices, each vertex
+  // once. The given vertices are included only if includeSelf is set.
+  // Each runs in time proportional to the number of given and found
+  // vertices, descendants are appended as whole preorder intervals.
+  void GetDescendants(vtkIdTypeArray* vertices, vtkIdTypeArray* result,
+                      int includeSelf);
+  void GetAncestors(vtkIdTypeArray* vertices, vtkIdTypeArray* result,
+                    int includeSelf);
+  void GetSiblings(vtkIdTypeArray* vertices, vtkIdTypeArray* result,
+                   int includeSelf);
+  void GetGenerations(vtkIdTypeArray* vertices, vtkIdTypeArray* result,
+                      int includeSelf);
+
+  // Description:
+  // Append to result the vertices of one generation.
+  void GetGeneration(vtkIdType generation, vtkIdTypeArray* result);
+
+  // Description:
+  // The pedigree id of a vertex, and the vertex with a pedigree id (-1 if
+  // there is none). Without a "PedigreeVertexId" array, pedigree ids are
+  // the vertex ids.
+  vtkIdType GetPedigree(vtkIdType vertex);
+  vtkIdType GetVertexFromPedigree(vtkIdType pedigree);
+
+protected:
+  vtkLineageTreeIndex();
+  ~vtkLineageTreeIndex();
+
+  vtkTree* Tree;
+  unsigned long TreeMTime;
+  vtkIdTypeArray* Pedigree;
+  vtkIdTypeArray* Parent;
+  vtkIdTypeArray* PreorderIndex;
+  vtkIdTypeArray* PreorderVertex;
+  vtkIdTypeArray* SubtreeEnd;
+  vtkIdTypeArray* Depth;
+  vtkIdTypeArray* GenerationOffsets;
+  vtkIdTypeArray* GenerationVertices;
+  vtkLineageTreeIndexInternals* Internals;
+
+private:
+  vtkLineageTreeIndex(const vtkLineageTreeIndex&);  // Not implemented.
+  void operator=(const vtkLineageTreeIndex&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,729 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkLineageTreeReader.h"
+
+#include "vtkDataArray.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkLineageTreeBuilder.h"
+#include "vtkLineageTreeHeader.h"
+#include "vtkMemoryMappedFile.h"
+#include "vtkMutableDirectedGraph.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+#include "vtkStdString.h"
+#include "vtkStringArray.h"
+#include "vtkTree.h"
+#include "vtkTreeReader.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkLineageTreeReader, "$Revision$");
+vtkStandardNewMacro(vtkLineageTreeReader);
+
+// Whether bytes bytes at offset lie in a file of the given size, after
+// the header and aligned for 64 bit reads.
+static bool vtkLineageTreeReaderHasSection(vtkTypeInt64 offset,
+  vtkTypeInt64 bytes, size_t size)
+{
+  return offset >= static_cast<vtkTypeInt64>(sizeof(vtkLineageTreeHeader)) &&
+    offset % 8 == 0 && bytes >= 0 && offset <= static_cast<vtkTypeInt64>(size) &&
+    bytes <= static_cast<vtkTypeInt64>(size) - offset;
+}
+
+// The vertex array of a column, null if the column is corrupt. With
+// vertices, only the tuples of these vertices are copied, in their order.
+static vtkAbstractArray* vtkLineageTreeReaderColumn(const char* data,
+  size_t size, const vtkLineageTreeColumn& column, vtkTypeInt64 numVertices,
+  const vtksys_stl::vector<vtkIdType>* vertices)
+{
+  int valueSize = vtkLineageTreeValueSize(column.DataType);
+  vtkTypeInt64 numComponents = column.DataType == VTK_STRING ? 1 : column.NumberOfComponents;
+  if (valueSize == 0 || numComponents < 1 || numComponents > 64 ||
+      !vtkLineageTreeReaderHasSection(column.Values,
+        numVertices * numComponents * valueSize, size))
+    {
+    return 0;
+    }
+  const char* values = data + column.Values;
+  vtkIdType numTuples = vertices ?
+    static_cast<vtkIdType>(vertices->size()) : static_cast<vtkIdType>(numVertices);
+
+  if (column.DataType == VTK_STRING)
+    {
+    // Every distinct string is built once, when first used, vertices share
+    // them by index.
+    vtkTypeInt64 numStrings = column.NumberOfStrings;
+    if (numStrings < 0 || numStrings >= static_cast<vtkTypeInt64>(size / 8) ||
+        !vtkLineageTreeReaderHasSection(column.StringOffsets, (numStrings + 1) * 8, size))
+      {
+      return 0;
+      }
+    const vtkTypeInt64* offsets =
+      reinterpret_cast<const vtkTypeInt64*>(data + column.StringOffsets);
+    // Offsets starting at 0 and never decreasing all lie within
+    // [0, offsets[numStrings]], checked once here rather than per vertex.
+    if (offsets[0] != 0)
+      {
+      return 0;
+      }
+    for (vtkTypeInt64 i = 0; i < numStrings; ++i)
+      {
+      if (offsets[i + 1] < offsets[i])
+        {
+        return 0;
+        }
+      }
+    if (!vtkLineageTreeReaderHasSection(column.StringBytes, offsets[numStrings], size))
+      {
+      return 0;
+      }
+    const char* bytes = data + column.StringBytes;
+    vtksys_stl::vector<vtkStdString> strings(static_cast<size_t>(numStrings));
+    vtksys_stl::vector<unsigned char> built(static_cast<size_t>(numStrings), 0);
+    const vtkTypeUInt32* indices = reinterpret_cast<const vtkTypeUInt32*>(values);
+    vtkStringArray* array = vtkStringArray::New();
+    array->SetNumberOfValues(numTuples);
+    for (vtkIdType t = 0; t < numTuples; ++t)
+      {
+      vtkTypeInt64 i = indices[vertices ? (*vertices)[t] : t];
+      if (i >= numStrings)
+        {
+        array->Delete();
+        return 0;
+        }
+      if (!built[i])
+        {
+        strings[i].assign(bytes + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i]));
+        built[i] = 1;
+        }
+      array->SetValue(t, strings[i]);
+      }
+    return array;
+    }
+
+  vtkDataArray* array = vtkDataArray::CreateDataArray(static_cast<int>(column.DataType));
+  array->SetNumberOfComponents(static_cast<int>(numComponents));
+  array->SetNumberOfTuples(numTuples);
+  if (column.DataType == VTK_ID_TYPE)
+    {
+    // vtkIdType may be 32 bits, ids are kept as int64 in the file.
+    const vtkTypeInt64* ids = reinterpret_cast<const vtkTypeInt64*>(values);
+    vtkIdType* output = static_cast<vtkIdTypeArray*>(array)->GetPointer(0);
+    for (vtkIdType t = 0; t < numTuples; ++t)
+      {
+      vtkTypeInt64 v = vertices ? (*vertices)[t] : t;
+      for (vtkTypeInt64 c = 0; c < numComponents; ++c)
+        {
+        output[t * numComponents + c] = static_cast<vtkIdType>(ids[v * numComponents + c]);
+        }
+      }
+    }
+  else if (!vertices && numTuples > 0)
+    {
+    memcpy(array->GetVoidPointer(0), values,
+      static_cast<size_t>(numTuples * numComponents) * valueSize);
+    }
+  else if (numTuples > 0)
+    {
+    size_t tupleSize = static_cast<size_t>(numComponents) * valueSize;
+    char* output = static_cast<char*>(array->GetVoidPointer(0));
+    for (vtkIdType t = 0; t < numTuples; ++t)
+      {
+      memcpy(output + t * tupleSize, values + (*vertices)[t] * tupleSize, tupleSize);
+      }
+    }
+  return array;
+}
+
+// The vertices of generation maxGeneration or less, the root being
+// generation 0, in increasing order, given the parent of every vertex.
+// Returns false if a parent is out of range or on a cycle.
+static bool vtkLineageTreeReaderGenerations(const vtkTypeInt64* parents,
+  vtkTypeInt64 numVertices, int maxGeneration,
+  vtksys_stl::vector<vtkIdType>& vertices)
+{
+  // Generations are found walking up to a vertex whose generation is known,
+  // then numbering the path back down.
+  vtksys_stl::vector<int> generations(static_cast<size_t>(numVertices), -1);
+  vtksys_stl::vector<vtkTypeInt64> path;
+  for (vtkTypeInt64 v = 0; v < numVertices; ++v)
+    {
+    vtkTypeInt64 u = v;
+    while (u >= 0 && generations[u] < 0)
+      {
+      path.push_back(u);
+      u = parents[u];
+      if (u >= numVertices || static_cast<vtkTypeInt64>(path.size()) > numVertices)
+        {
+        return false;
+        }
+      }
+    int generation = u >= 0 ? generations[u] : -1;
+    while (!path.empty())
+      {
+      generations[path.back()] = ++generation;
+      path.pop_back();
+      }
+    }
+  vertices.clear();
+  for (vtkTypeInt64 v = 0; v < numVertices; ++v)
+    {
+    if (generations[v] <= maxGeneration)
+      {
+      vertices.push_back(static_cast<vtkIdType>(v));
+      }
+    }
+  return true;
+}
+
+// Sets the pedigree ids of the vertices read to their ids in the whole
+// tree.
+static void vtkLineageTreeReaderSetPedigrees(vtkDataSetAttributes* vertexData,
+  const vtksys_stl::vector<vtkIdType>& vertices)
+{
+  vtkIdTypeArray* pedigrees = vtkIdTypeArray::New();
+  pedigrees->SetName("PedigreeVertexId");
+  pedigrees->SetNumberOfValues(static_cast<vtkIdType>(vertices.size()));
+  for (size_t i = 0; i < vertices.size(); ++i)
+    {
+    pedigrees->SetValue(static_cast<vtkIdType>(i), vertices[i]);
+    }
+  vertexData->RemoveArray("PedigreeVertexId");
+  vertexData->AddArray(pedigrees);
+  pedigrees->Delete();
+}
+
+// The columns of a tracking table.
+enum
+{
+  VTK_LINEAGE_TRACKING_CELL,
+  VTK_LINEAGE_TRACKING_PARENT,
+  VTK_LINEAGE_TRACKING_START,
+  VTK_LINEAGE_TRACKING_END,
+  VTK_LINEAGE_TRACKING_NAME,
+  VTK_LINEAGE_TRACKING_OTHER
+};
+
+// Reads the next comma separated field of a line, without the trailing
+// carriage return and surrounding quotes. Returns the start of the next
+// field, or lineEnd.
+static const char* vtkLineageTreeReaderNextField(const char* p,
+  const char* lineEnd, const char*& begin, const char*& end)
+{
+  end = static_cast<const char*>(memchr(p, ',', lineEnd - p));
+  const char* next = end ? end + 1 : lineEnd;
+  end = end ? end : lineEnd;
+  if (end > p && end[-1] == '\r')
+    {
+    --end;
+    }
+  if (end - p >= 2 && *p == '"' && end[-1] == '"')
+    {
+    ++p;
+    --end;
+    }
+  begin = p;
+  return next;
+}
+
+// The tracking table column a header field names, case, spaces and
+// underscores aside.
+static int vtkLineageTreeReaderTrackingColumn(const char* begin, const char* end)
+{
+  vtkStdString name;
+  for (const char* p = begin; p < end && name.size() < 16; ++p)
+    {
+    if (*p != ' ' && *p != '_' && *p != '-')
+      {
+      name += static_cast<char>(tolower(static_cast<unsigned char>(*p)));
+      }
+    }
+  if (name == "id" || name == "cell" || name == "cellid")
+    {
+    return VTK_LINEAGE_TRACKING_CELL;
+    }
+  if (name == "parent" || name == "parentid")
+    {
+    return VTK_LINEAGE_TRACKING_PARENT;
+    }
+  if (name == "start" || name == "starttime")
+    {
+    return VTK_LINEAGE_TRACKING_START;
+    }
+  if (name == "end" || name == "endtime")
+    {
+    return VTK_LINEAGE_TRACKING_END;
+    }
+  if (name == "name" || name == "cellname")
+    {
+    return VTK_LINEAGE_TRACKING_NAME;
+    }
+  return VTK_LINEAGE_TRACKING_OTHER;
+}
+
+// The columns named by a header line, and whether it has the cell and
+// parent columns.
+static bool vtkLineageTreeReaderTrackingHeader(const char* line,
+  const char* lineEnd, vtksys_stl::vector<int>& columns)
+{
+  bool hasCell = false;
+  bool hasParent = false;
+  const char* begin;
+  const char* end;
+  columns.clear();
+  for (const char* p = line; p < lineEnd; )
+    {
+    p = vtkLineageTreeReaderNextField(p, lineEnd, begin, end);
+    int column = vtkLineageTreeReaderTrackingColumn(begin, end);
+    // Only the first column of a kind is read.
+    for (size_t c = 0; c < columns.size(); ++c)
+      {
+      column = columns[c] == column ? VTK_LINEAGE_TRACKING_OTHER : column;
+      }
+    hasCell = hasCell || column == VTK_LINEAGE_TRACKING_CELL;
+    hasParent = hasParent || column == VTK_LINEAGE_TRACKING_PARENT;
+    columns.push_back(column);
+    }
+  return hasCell && hasParent;
+}
+
+// Copies a field to a terminated buffer for strtoll and strtod, false if
+// it is empty or too long to be a number.
+static bool vtkLineageTreeReaderCopyField(const char* begin, const char* end,
+  char* buffer, size_t bufferSize)
+{
+  size_t length = static_cast<size_t>(end - begin);
+  if (length == 0 || length >= bufferSize)
+    {
+    return false;
+    }
+  memcpy(buffer, begin, length);
+  buffer[length] = 0;
+  return true;
+}
+
+// Parses a whole field as an integer id.
+static bool vtkLineageTreeReaderId(const char* begin, const char* end, vtkIdType& id)
+{
+  char buffer[32];
+  char* parsed;
+  if (!vtkLineageTreeReaderCopyField(begin, end, buffer, sizeof(buffer)))
+    {
+    return false;
+    }
+  id = static_cast<vtkIdType>(strtoll(buffer, &parsed, 10));
+  return parsed != buffer && *parsed == 0;
+}
+
+// Parses a whole field as a time.
+static bool vtkLineageTreeReaderTime(const char* begin, const char* end, double& time)
+{
+  char buffer[64];
+  char* parsed;
+  if (!vtkLineageTreeReaderCopyField(begin, end, buffer, sizeof(buffer)))
+    {
+    return false;
+    }
+  time = strtod(buffer, &parsed);
+  return parsed != buffer && *parsed == 0;
+}
+
+vtkLineageTreeReader::vtkLineageTreeReader()
+{
+  this->FileName = 0;
+  this->Binary = 0;
+  this->TrackingTable = 0;
+  this->MaximumGeneration = -1;
+  this->Truncated = 0;
+  this->LegacyReader = vtkTreeReader::New();
+  this->TableTree = vtkTree::New();
+  this->SetNumberOfInputPorts(0);
+}
+
+vtkLineageTreeReader::~vtkLineageTreeReader()
+{
+  this->SetFileName(0);
+  this->LegacyReader->Delete();
+  this->TableTree->Delete();
+}
+
+int vtkLineageTreeReader::IsBinaryFile(const char* fileName)
+{
+  FILE* file = fileName ? fopen(fileName, "rb") : 0;
+  if (!file)
+    {
+    return 0;
+    }
+  char magic[8];
+  size_t read = fread(magic, 1, sizeof(magic), file);
+  fclose(file);
+  return read == sizeof(magic) && !memcmp(magic, VTK_LINEAGE_TREE_MAGIC, sizeof(magic));
+}
+
+int vtkLineageTreeReader::IsTrackingTable(const char* fileName)
+{
+  FILE* file = fileName ? fopen(fileName, "rb") : 0;
+  if (!file)
+    {
+    return 0;
+    }
+  char line[4096];
+  bool read = fgets(line, sizeof(line), file) != 0;
+  fclose(file);
+  if (!read)
+    {
+    return 0;
+    }
+  const char* begin = strncmp(line, "\xEF\xBB\xBF", 3) ? line : line + 3;
+  const char* end = begin + strcspn(begin, "\n");
+  vtksys_stl::vector<int> columns;
+  return vtkLineageTreeReaderTrackingHeader(begin, end, columns) ? 1 : 0;
+}
+
+int vtkLineageTreeReader::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **vtkNotUsed(inputVector),
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkTree* output = vtkTree::SafeDownCast(outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  if (!this->FileName)
+    {
+    vtkErrorMacro("No file name.");
+    return 0;
+    }
+
+  this->Binary = IsBinaryFile(this->FileName);
+  this->TrackingTable = !this->Binary && IsTrackingTable(this->FileName);
+  this->Truncated = 0;
+  if (this->Binary)
+    {
+    vtkSmartPointer<vtkMemoryMappedFile> file = vtkSmartPointer<vtkMemoryMappedFile>::New();
+    if (!file->Open(this->FileName))
+      {
+      return 0;
+      }
+    if (!this->ReadBinary(file->GetData(), file->GetSize(), output))
+      {
+      vtkErrorMacro("Corrupt lineage file " << this->FileName);
+      output->Initialize();
+      return 0;
+      }
+    return 1;
+    }
+
+  // Text files are parsed whole. The tree of a tracking table is kept while
+  // reading it by generations, the legacy reader keeps its own.
+  vtkTree* tree = this->TableTree;
+  if (this->TrackingTable && this->TableFileName != this->FileName)
+    {
+    this->TableFileName.clear();
+    vtkSmartPointer<vtkMemoryMappedFile> file = vtkSmartPointer<vtkMemoryMappedFile>::New();
+    if (!file->Open(this->FileName) ||
+        !this->ReadTrackingTable(file->GetData(), file->GetSize(), tree))
+      {
+      tree->Initialize();
+      output->Initialize();
+      return 0;
+      }
+    this->TableFileName = this->FileName;
+    }
+  else if (!this->TrackingTable)
+    {
+    this->LegacyReader->SetFileName(this->FileName);
+    this->LegacyReader->Update();
+    tree = this->LegacyReader->GetOutput();
+    }
+  int ok = 1;
+  if (this->MaximumGeneration >= 0)
+    {
+    ok = this->ExtractGenerations(tree, output);
+    }
+  else
+    {
+    output->ShallowCopy(tree);
+    }
+  if (!this->Truncated)
+    {
+    this->TableTree->Initialize();
+    this->TableFileName.clear();
+    }
+  return ok;
+}
+
+int vtkLineageTreeReader::ExtractGenerations(vtkTree* tree, vtkTree* output)
+{
+  vtkIdType numVertices = tree->GetNumberOfVertices();
+  vtksys_stl::vector<vtkTypeInt64> parents(numVertices);
+  for (vtkIdType v = 0; v < numVertices; ++v)
+    {
+    parents[v] = tree->GetParent(v);
+    }
+  vtksys_stl::vector<vtkIdType> vertices;
+  if (!vtkLineageTreeReaderGenerations(numVertices > 0 ? &parents[0] : 0,
+        numVertices, this->MaximumGeneration, vertices))
+    {
+    return 0;
+    }
+  this->Truncated = static_cast<vtkIdType>(vertices.size()) < numVertices;
+  if (!this->Truncated)
+    {
+    output->ShallowCopy(tree);
+    return 1;
+    }
+
+  // Vertices and edges of the cells read are added in the order of the
+  // tree, with their vertex data.
+  vtkIdType numOutput = static_cast<vtkIdType>(vertices.size());
+  vtksys_stl::vector<vtkIdType> newIds(numVertices, -1);
+  vtkSmartPointer<vtkMutableDirectedGraph> builder =
+    vtkSmartPointer<vtkMutableDirectedGraph>::New();
+  for (vtkIdType i = 0; i < numOutput; ++i)
+    {
+    newIds[vertices[i]] = builder->AddVertex();
+    }
+  vtkIdType numEdges = tree->GetNumberOfEdges();
+  for (vtkIdType e = 0; e < numEdges; ++e)
+    {
+    vtkIdType child = newIds[tree->GetTargetVertex(e)];
+    if (child >= 0)
+      {
+      builder->AddEdge(newIds[tree->GetSourceVertex(e)], child);
+      }
+    }
+  vtkDataSetAttributes* vertexData = builder->GetVertexData();
+  vertexData->CopyAllocate(tree->GetVertexData(), numOutput);
+  for (vtkIdType i = 0; i < numOutput; ++i)
+    {
+    vertexData->CopyData(tree->GetVertexData(), vertices[i], i);
+    }
+  vtkLineageTreeReaderSetPedigrees(vertexData, vertices);
+  return output->CheckedShallowCopy(builder) ? 1 : 0;
+}
+
+int vtkLineageTreeReader::ReadBinary(const char* data, size_t size, vtkTree* output)
+{
+  vtkLineageTreeHeader header;
+  if (size < sizeof(header))
+    {
+    return 0;
+    }
+  memcpy(&header, data, sizeof(header));
+  if (header.ByteOrder != VTK_LINEAGE_TREE_BYTE_ORDER)
+    {
+    vtkErrorMacro("Lineage file written with another byte order: " << this->FileName);
+    return 0;
+    }
+  vtkTypeInt64 numVertices = header.NumberOfVertices;
+  vtkTypeInt64 numColumns = header.NumberOfColumns;
+  vtkTypeInt64 numEdges = numVertices > 0 ? numVertices - 1 : 0;
+  vtkTypeInt64 maxCount = static_cast<vtkTypeInt64>(size / 8);
+  if (header.FileSize > static_cast<vtkTypeInt64>(size) ||
+      numVertices < 0 || numVertices >= maxCount ||
+      numColumns < 0 || numColumns >= maxCount ||
+      !vtkLineageTreeReaderHasSection(header.Parents, numVertices * 8, size) ||
+      !vtkLineageTreeReaderHasSection(header.EdgeTargets, numEdges * 8, size) ||
+      !vtkLineageTreeReaderHasSection(header.Columns,
+        numColumns * static_cast<vtkTypeInt64>(sizeof(vtkLineageTreeColumn)), size))
+    {
+    return 0;
+    }
+
+  // Below MaximumGeneration, only the cells read are numbered, in file
+  // order.
+  const vtkTypeInt64* parents = reinterpret_cast<const vtkTypeInt64*>(data + header.Parents);
+  const vtkTypeInt64* targets = reinterpret_cast<const vtkTypeInt64*>(data + header.EdgeTargets);
+  vtksys_stl::vector<vtkIdType> vertices;
+  vtksys_stl::vector<vtkIdType> newIds;
+  if (this->MaximumGeneration >= 0)
+    {
+    if (!vtkLineageTreeReaderGenerations(parents, numVertices,
+          this->MaximumGeneration, vertices))
+      {
+      return 0;
+      }
+    this->Truncated = static_cast<vtkTypeInt64>(vertices.size()) < numVertices;
+    }
+  vtkTypeInt64 numOutput = numVertices;
+  if (this->Truncated)
+    {
+    numOutput = static_cast<vtkTypeInt64>(vertices.size());
+    newIds.resize(static_cast<size_t>(numVertices), -1);
+    for (size_t i = 0; i < vertices.size(); ++i)
+      {
+      newIds[vertices[i]] = static_cast<vtkIdType>(i);
+      }
+    }
+
+  // Edges are added in the order they were written, so that children stay
+  // in order and edge ids match those of the tree written.
+  vtkSmartPointer<vtkMutableDirectedGraph> builder =
+    vtkSmartPointer<vtkMutableDirectedGraph>::New();
+  for (vtkTypeInt64 v = 0; v < numOutput; ++v)
+    {
+    builder->AddVertex();
+    }
+  for (vtkTypeInt64 e = 0; e < numEdges; ++e)
+    {
+    vtkTypeInt64 child = targets[e];
+    if (child < 0 || child >= numVertices ||
+        parents[child] < 0 || parents[child] >= numVertices)
+      {
+      return 0;
+      }
+    if (!this->Truncated)
+      {
+      builder->AddEdge(static_cast<vtkIdType>(parents[child]), static_cast<vtkIdType>(child));
+      }
+    else if (newIds[child] >= 0)
+      {
+      builder->AddEdge(newIds[parents[child]], newIds[child]);
+      }
+    }
+
+  vtkDataSetAttributes* vertexData = builder->GetVertexData();
+  for (vtkTypeInt64 c = 0; c < numColumns; ++c)
+    {
+    vtkLineageTreeColumn column;
+    memcpy(&column, data + header.Columns + c * sizeof(column), sizeof(column));
+    column.Name[VTK_LINEAGE_TREE_NAME_SIZE - 1] = 0;
+    vtkAbstractArray* array = vtkLineageTreeReaderColumn(data, size, column,
+      numVertices, this->Truncated ? &vertices : 0);
+    if (!array)
+      {
+      return 0;
+      }
+    array->SetName(column.Name);
+    vertexData->AddArray(array);
+    array->Delete();
+    }
+  if (this->Truncated)
+    {
+    vtkLineageTreeReaderSetPedigrees(vertexData, vertices);
+    }
+
+  // Fails if the edges do not form a tree.
+  return output->CheckedShallowCopy(builder) ? 1 : 0;
+}
+
+int vtkLineageTreeReader::ReadTrackingTable(const char* data, size_t size,
+  vtkTree* output)
+{
+  const char* dataEnd = data + size;
+  if (size >= 3 && !strncmp(data, "\xEF\xBB\xBF", 3))
+    {
+    data += 3;
+    }
+  const char* lineEnd = static_cast<const char*>(memchr(data, '\n', dataEnd - data));
+  lineEnd = lineEnd ? lineEnd : dataEnd;
+  vtksys_stl::vector<int> columns;
+  vtkLineageTreeReaderTrackingHeader(data, lineEnd, columns);
+  bool hasStart = false;
+  bool hasEnd = false;
+  bool hasName = false;
+  for (size_t c = 0; c < columns.size(); ++c)
+    {
+    hasStart = hasStart || columns[c] == VTK_LINEAGE_TRACKING_START;
+    hasEnd = hasEnd || columns[c] == VTK_LINEAGE_TRACKING_END;
+    hasName = hasName || columns[c] == VTK_LINEAGE_TRACKING_NAME;
+    }
+
+  vtkSmartPointer<vtkIdTypeArray> cells = vtkSmartPointer<vtkIdTypeArray>::New();
+  vtkSmartPointer<vtkIdTypeArray> parents = vtkSmartPointer<vtkIdTypeArray>::New();
+  vtkSmartPointer<vtkDoubleArray> startTimes = vtkSmartPointer<vtkDoubleArray>::New();
+  vtkSmartPointer<vtkDoubleArray> endTimes = vtkSmartPointer<vtkDoubleArray>::New();
+  vtkSmartPointer<vtkStringArray> names = vtkSmartPointer<vtkStringArray>::New();
+  vtkIdType lineNumber = 1;
+  for (const char* line = lineEnd + 1; line < dataEnd; line = lineEnd + 1)
+    {
+    ++lineNumber;
+    lineEnd = static_cast<const char*>(memchr(line, '\n', dataEnd - line));
+    lineEnd = lineEnd ? lineEnd : dataEnd;
+    if (lineEnd == line || (lineEnd == line + 1 && *line == '\r'))
+      {
+      continue;
+      }
+
+    // An empty parent, or one that is not a number like NA, is a root.
+    vtkIdType cell = 0;
+    vtkIdType parent = -1;
+    double start = 0.0;
+    double end = 0.0;
+    const char* nameBegin = 0;
+    const char* nameEnd = 0;
+    bool hasCell = false;
+    const char* fieldBegin;
+    const char* fieldEnd;
+    const char* p = line;
+    for (size_t c = 0; c < columns.size() && p < lineEnd; ++c)
+      {
+      p = vtkLineageTreeReaderNextField(p, lineEnd, fieldBegin, fieldEnd);
+      switch (columns[c])
+        {
+        case VTK_LINEAGE_TRACKING_CELL:
+          hasCell = vtkLineageTreeReaderId(fieldBegin, fieldEnd, cell);
+          break;
+        case VTK_LINEAGE_TRACKING_PARENT:
+          if (!vtkLineageTreeReaderId(fieldBegin, fieldEnd, parent))
+            {
+            parent = -1;
+            }
+          break;
+        case VTK_LINEAGE_TRACKING_START:
+          vtkLineageTreeReaderTime(fieldBegin, fieldEnd, start);
+          break;
+        case VTK_LINEAGE_TRACKING_END:
+          vtkLineageTreeReaderTime(fieldBegin, fieldEnd, end);
+          break;
+        case VTK_LINEAGE_TRACKING_NAME:
+          nameBegin = fieldBegin;
+          nameEnd = fieldEnd;
+          break;
+        }
+      }
+    if (!hasCell)
+      {
+      vtkErrorMacro("No cell id on line " << lineNumber << " of " << this->FileName);
+      return 0;
+      }
+    cells->InsertNextValue(cell);
+    parents->InsertNextValue(parent);
+    startTimes->InsertNextValue(start);
+    endTimes->InsertNextValue(end);
+    if (hasName)
+      {
+      names->InsertNextValue(nameBegin ? vtkStdString(nameBegin, nameEnd - nameBegin) : vtkStdString());
+      }
+    }
+
+  vtkSmartPointer<vtkLineageTreeBuilder> builder = vtkSmartPointer<vtkLineageTreeBuilder>::New();
+  if (!builder->Build(cells, parents, hasStart ? startTimes.GetPointer() : 0,
+                      hasEnd ? endTimes.GetPointer() : 0,
+                      hasName ? names.GetPointer() : 0, output))
+    {
+    vtkErrorMacro("Tracking table " << this->FileName << " is not a lineage: "
+                  << builder->GetErrorMessage());
+    return 0;
+    }
+  return 1;
+}
+
+void vtkLineageTreeReader::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "FileName: " << (this->FileName ? this->FileName : "(none)") << endl;
+  os << indent << "Binary: " << this->Binary << endl;
+  os << indent << "TrackingTable: " << this->TrackingTable << endl;
+  os << indent << "MaximumGeneration: " << this->MaximumGeneration << endl;
+  os << indent << "Truncated: " << this->Truncated << endl;
+}
@@ -0,0 +1,119 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkLineageTreeReader - reader of binary and legacy lineage trees
+//
+// .SECTION Description
+// vtkLineageTreeReader reads a lineage tree from a binary lineage file
+// (see vtkLineageTreeHeader.h), from a cell tracking table, or from a
+// legacy VTK tree file through vtkTreeReader otherwise.
+//
+// A binary file is memory mapped. The tree is built from its parent and
+// edge arrays and its vertex columns are copied into arrays of their type,
+// without any text being parsed, so large lineages load in a fraction of
+// the time and memory of the legacy reader. Strings are stored once per
+// distinct value.
+//
+// A tracking table is a comma separated file with a header line naming
+// its columns: the cell id ("id" or "cell id") and parent id ("parent" or
+// "parent id") columns are needed, "start time", "end time" and "name"
+// ones are read if present. Ids are integers, an empty or negative parent
+// making a root. The tree is built by vtkLineageTreeBuilder, which gives
+// the reason a table is not a lineage.
+//
+// With MaximumGeneration set, only the cells of the first generations are
+// output, for a lineage to be shown before all of it is loaded. Vertices
+// keep the order of the file and their "PedigreeVertexId" is their vertex
+// id in the whole tree, so that selections and collapsed cells, which are
+// kept by pedigree id, carry over to deeper reads. Columns of binary files
+// are only copied for the cells read, text files are parsed once and the
+// tree kept for deeper reads of the same file.
+//
+// .SECTION See Also
+// vtkLineageTreeWriter vtkLineageTreeBuilder vtkTreeReader
+// vtkMemoryMappedFile
+
+#ifndef __vtkLineageTreeReader_h
+#define __vtkLineageTreeReader_h
+
+#include "vtkTreeAlgorithm.h"
+#include "vtkStdString.h" // For TableFileName
+
+class vtkTreeReader;
+
+class vtkLineageTreeReader : public vtkTreeAlgorithm
+{
+public:
+  static vtkLineageTreeReader *New();
+  vtkTypeRevisionMacro(vtkLineageTreeReader,vtkTreeAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The file to read.
+  vtkSetStringMacro(FileName);
+  vtkGetStringMacro(FileName);
+
+  // Description:
+  // Whether the last file read was a binary lineage file.
+  vtkGetMacro(Binary, int);
+
+  // Description:
+  // Whether a file starts like a binary lineage file.
+  static int IsBinaryFile(const char* fileName);
+
+  // Description:
+  // Whether the last file read was a tracking table.
+  vtkGetMacro(TrackingTable, int);
+
+  // Description:
+  // Whether the first line of a file names the cell and parent columns of
+  // a tracking table.
+  static int IsTrackingTable(const char* fileName);
+
+  // Description:
+  // The last generation read, the root being generation 0. Negative, the
+  // default, reads the whole tree.
+  vtkSetMacro(MaximumGeneration, int);
+  vtkGetMacro(MaximumGeneration, int);
+
+  // Description:
+  // Whether the last read left out cells below MaximumGeneration.
+  vtkGetMacro(Truncated, int);
+
+protected:
+  vtkLineageTreeReader();
+  ~vtkLineageTreeReader();
+
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  // Description:
+  // Build the tree of a mapped binary file, down to MaximumGeneration.
+  // Returns 0 if the file is corrupt.
+  int ReadBinary(const char* data, size_t size, vtkTree* output);
+
+  // Description:
+  // Build the tree of a mapped tracking table. Returns 0 if the table can
+  // not be parsed or is not a lineage.
+  int ReadTrackingTable(const char* data, size_t size, vtkTree* output);
+
+  // Description:
+  // Copy the cells of tree down to MaximumGeneration into output.
+  int ExtractGenerations(vtkTree* tree, vtkTree* output);
+
+  char* FileName;
+  int Binary;
+  int TrackingTable;
+  int MaximumGeneration;
+  int Truncated;
+  vtkTreeReader* LegacyReader;
+
+  // The tree of the last tracking table read, and its file.
+  vtkTree* TableTree;
+  vtkStdString TableFileName;
+
+private:
+  vtkLineageTreeReader(const vtkLineageTreeReader&);  // Not implemented.
+  void operator=(const vtkLineageTreeReader&);  // Not implemented.
+};
+
+#endif
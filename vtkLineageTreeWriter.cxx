@@ -0,0 +1,193 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkLineageTreeWriter.h"
+
+#include "vtkDataArray.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkIdTypeArray.h"
+#include "vtkLineageTreeHeader.h"
+#include "vtkObjectFactory.h"
+#include "vtkStdString.h"
+#include "vtkStringArray.h"
+#include "vtkTree.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vtksys/stl/map>
+#include <vtksys/stl/string>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkLineageTreeWriter, "$Revision$");
+vtkStandardNewMacro(vtkLineageTreeWriter);
+vtkCxxSetObjectMacro(vtkLineageTreeWriter, Input, vtkTree);
+
+// Writes a section at the end of the file, padded to 8 bytes, and returns
+// its offset, or -1 if it could not be written.
+static vtkTypeInt64 vtkLineageTreeWriterAppend(FILE* file, const void* data,
+  size_t size, vtkTypeInt64& end)
+{
+  static const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  size_t padded = (size + 7) & ~static_cast<size_t>(7);
+  vtkTypeInt64 offset = end;
+  if ((size > 0 && fwrite(data, 1, size, file) != size) ||
+      (padded > size && fwrite(padding, 1, padded - size, file) != padded - size))
+    {
+    return -1;
+    }
+  end += static_cast<vtkTypeInt64>(padded);
+  return offset;
+}
+
+vtkLineageTreeWriter::vtkLineageTreeWriter()
+{
+  this->Input = 0;
+  this->FileName = 0;
+}
+
+vtkLineageTreeWriter::~vtkLineageTreeWriter()
+{
+  this->SetInput(0);
+  this->SetFileName(0);
+}
+
+int vtkLineageTreeWriter::Write()
+{
+  if (!this->Input || !this->FileName)
+    {
+    vtkErrorMacro("Need a tree and a file name.");
+    return 0;
+    }
+  vtkTree* tree = this->Input;
+  vtkIdType numVertices = tree->GetNumberOfVertices();
+  vtkIdType numEdges = tree->GetNumberOfEdges();
+  if (tree->GetEdgeData()->GetNumberOfArrays() > 0)
+    {
+    vtkWarningMacro("Edge data is not written.");
+    }
+
+  FILE* file = fopen(this->FileName, "wb");
+  if (!file)
+    {
+    vtkErrorMacro("Could not open " << this->FileName);
+    return 0;
+    }
+
+  // The header is written again once the sections are in place.
+  vtkLineageTreeHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.Magic, VTK_LINEAGE_TREE_MAGIC, sizeof(header.Magic));
+  header.ByteOrder = VTK_LINEAGE_TREE_BYTE_ORDER;
+  header.NumberOfVertices = numVertices;
+  vtkTypeInt64 end = 0;
+  bool ok = vtkLineageTreeWriterAppend(file, &header, sizeof(header), end) >= 0;
+
+  vtksys_stl::vector<vtkTypeInt64> ids(numVertices);
+  for (vtkIdType v = 0; v < numVertices; ++v)
+    {
+    ids[v] = tree->GetParent(v);
+    }
+  header.Parents = vtkLineageTreeWriterAppend(file,
+    numVertices > 0 ? &ids[0] : 0, ids.size() * 8, end);
+  ids.resize(numEdges);
+  for (vtkIdType e = 0; e < numEdges; ++e)
+    {
+    ids[e] = tree->GetTargetVertex(e);
+    }
+  header.EdgeTargets = vtkLineageTreeWriterAppend(file,
+    numEdges > 0 ? &ids[0] : 0, ids.size() * 8, end);
+  ok = ok && header.Parents >= 0 && header.EdgeTargets >= 0;
+
+  vtkDataSetAttributes* vertexData = tree->GetVertexData();
+  vtksys_stl::vector<vtkLineageTreeColumn> columns;
+  for (int a = 0; ok && a < vertexData->GetNumberOfArrays(); ++a)
+    {
+    vtkAbstractArray* array = vertexData->GetAbstractArray(a);
+    const char* name = array->GetName();
+    vtkStringArray* strings = vtkStringArray::SafeDownCast(array);
+    vtkDataArray* numbers = vtkDataArray::SafeDownCast(array);
+    int type = strings ? VTK_STRING : (numbers ? numbers->GetDataType() : VTK_VOID);
+    if (!name || strlen(name) >= VTK_LINEAGE_TREE_NAME_SIZE ||
+        vtkLineageTreeValueSize(type) == 0 ||
+        array->GetNumberOfTuples() != numVertices)
+      {
+      vtkWarningMacro("Skipping vertex array " << (name ? name : "(unnamed)"));
+      continue;
+      }
+    vtkLineageTreeColumn column;
+    memset(&column, 0, sizeof(column));
+    strcpy(column.Name, name);
+    column.DataType = type;
+    column.NumberOfComponents = array->GetNumberOfComponents();
+
+    if (strings)
+      {
+      // Intern the strings, numbered in order of first appearance.
+      vtksys_stl::map<vtkStdString, vtkTypeUInt32> stringIds;
+      vtksys_stl::vector<vtkTypeUInt32> indices(numVertices);
+      vtksys_stl::vector<vtkTypeInt64> offsets(1, 0);
+      vtksys_stl::string bytes;
+      for (vtkIdType v = 0; v < numVertices; ++v)
+        {
+        const vtkStdString& value = strings->GetValue(v);
+        vtksys_stl::map<vtkStdString, vtkTypeUInt32>::iterator it = stringIds.find(value);
+        if (it == stringIds.end())
+          {
+          it = stringIds.insert(vtksys_stl::make_pair(value,
+            static_cast<vtkTypeUInt32>(offsets.size() - 1))).first;
+          bytes += value;
+          offsets.push_back(static_cast<vtkTypeInt64>(bytes.size()));
+          }
+        indices[v] = it->second;
+        }
+      column.NumberOfComponents = 1;
+      column.NumberOfStrings = static_cast<vtkTypeInt64>(offsets.size() - 1);
+      column.Values = vtkLineageTreeWriterAppend(file,
+        numVertices > 0 ? &indices[0] : 0, indices.size() * 4, end);
+      column.StringOffsets = vtkLineageTreeWriterAppend(file,
+        &offsets[0], offsets.size() * 8, end);
+      column.StringBytes = vtkLineageTreeWriterAppend(file,
+        bytes.data(), bytes.size(), end);
+      ok = column.Values >= 0 && column.StringOffsets >= 0 && column.StringBytes >= 0;
+      }
+    else if (type == VTK_ID_TYPE)
+      {
+      vtkIdType numValues = numVertices * numbers->GetNumberOfComponents();
+      const vtkIdType* values = static_cast<vtkIdTypeArray*>(numbers)->GetPointer(0);
+      vtksys_stl::vector<vtkTypeInt64> wide(values, values + numValues);
+      column.Values = vtkLineageTreeWriterAppend(file,
+        numValues > 0 ? &wide[0] : 0, wide.size() * 8, end);
+      ok = column.Values >= 0;
+      }
+    else
+      {
+      size_t bytes = static_cast<size_t>(numVertices) *
+        numbers->GetNumberOfComponents() * vtkLineageTreeValueSize(type);
+      column.Values = vtkLineageTreeWriterAppend(file,
+        bytes > 0 ? numbers->GetVoidPointer(0) : 0, bytes, end);
+      ok = column.Values >= 0;
+      }
+    columns.push_back(column);
+    }
+
+  header.NumberOfColumns = static_cast<vtkTypeInt64>(columns.size());
+  header.Columns = vtkLineageTreeWriterAppend(file, columns.empty() ? 0 : &columns[0],
+    columns.size() * sizeof(vtkLineageTreeColumn), end);
+  header.FileSize = end;
+  ok = ok && header.Columns >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+    fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+  ok = (fclose(file) == 0) && ok;
+  if (!ok)
+    {
+    vtkErrorMacro("Could not write " << this->FileName);
+    }
+  return ok ? 1 : 0;
+}
+
+void vtkLineageTreeWriter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "FileName: " << (this->FileName ? this->FileName : "(none)") << endl;
+  os << indent << "Input: " << this->Input << endl;
+}
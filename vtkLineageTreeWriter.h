@@ -0,0 +1,58 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkLineageTreeWriter - writer of binary lineage trees
+//
+// .SECTION Description
+// vtkLineageTreeWriter writes a tree as a binary lineage file (see
+// vtkLineageTreeHeader.h) for vtkLineageTreeReader to load. The parent of
+// every vertex, the edges in order and every named vertex array are
+// written: arrays of numbers with their type and components, string arrays
+// as a table of distinct strings and an index per vertex. Other arrays,
+// arrays with names of VTK_LINEAGE_TREE_NAME_SIZE characters or more, and
+// edge data are skipped with a warning.
+//
+// .SECTION See Also
+// vtkLineageTreeReader
+
+#ifndef __vtkLineageTreeWriter_h
+#define __vtkLineageTreeWriter_h
+
+#include "vtkObject.h"
+
+class vtkTree;
+
+class vtkLineageTreeWriter : public vtkObject
+{
+public:
+  static vtkLineageTreeWriter *New();
+  vtkTypeRevisionMacro(vtkLineageTreeWriter,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The tree to write.
+  virtual void SetInput(vtkTree* tree);
+  vtkGetObjectMacro(Input, vtkTree);
+
+  // Description:
+  // The file to write.
+  vtkSetStringMacro(FileName);
+  vtkGetStringMacro(FileName);
+
+  // Description:
+  // Write the file. Returns 0 on failure.
+  int Write();
+
+protected:
+  vtkLineageTreeWriter();
+  ~vtkLineageTreeWriter();
+
+  vtkTree* Input;
+  char* FileName;
+
+private:
+  vtkLineageTreeWriter(const vtkLineageTreeWriter&);  // Not implemented.
+  void operator=(const vtkLineageTreeWriter&);  // Not implemented.
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include "vtkActor2D.h"
 #include "vtkAlgorithmOutput.h"
 #include "vtkAnnotationLink.h"
+#include "vtkArrayRange.h"
 #include "vtkCamera.h"
 #include "vtkCellCenters.h"
 #include "vtkCellData.h"
@@ -38,7 +39,9 @@
 #include "vtkElbowGraphToPolyData.h"
 #include "vtkInformation.h"
 #include "vtkLabeledDataMapper.h"
+#include "vtkLineageTreeIndex.h"
 #include "vtkLookupTable.h"
+#include "vtkMath.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
@@ -48,6 +51,8 @@
 #include "vtkRenderer.h"
 #include "vtkRenderWindow.h"
 #include "vtkRenderWindowInteractor.h"
+#include "vtkResolveLabelIndices.h"
+#include "vtkSelectionBitmap.h"
 #include "vtkSelectionNode.h"
 #include "vtkSmartPointer.h"
 #include "vtkSphereSource.h"
@@ -58,7 +63,7 @@
 #include "vtkThresholdPoints.h"
 #include "vtkVertexGlyphFilter.h"
 
-#include <vtksys/stl/set>
+#include <math.h>
 
 class vtkCoordinate;
 
@@ -89,6 +94,7 @@ vtkLineageView::vtkLineageView()
   this->ConeSource            = vtkSmartPointer<vtkConeSource>::New();
   this->VertexGlyphs          = vtkSmartPointer<vtkVertexGlyphFilter>::New();
   this->ColorLUT              = vtkSmartPointer<vtkLookupTable>::New();
+  this->LabelResolver         = vtkSmartPointer<vtkResolveLabelIndices>::New();
   this->LabeledDataMapper     = vtkSmartPointer<vtkDynamic2DLabelMapper>::New();
   this->VisibleCellSelector   = vtkSmartPointer<vtkVisibleCellSelector>::New();
   this->ExtractSelection      = vtkSmartPointer<vtkExtractSelectedIds>::New();
@@ -103,10 +109,16 @@ vtkLineageView::vtkLineageView()
   this->CollapsedGlyphActor   = vtkSmartPointer<vtkActor>::New();
   this->TreeVertexToEdge      = vtkSmartPointer<vtkTreeVertexToEdgeSelection>::New();
   this->CollapsedThreshold    = vtkSmartPointer<vtkThresholdPoints>::New();
+  this->SelectionBitmap       = vtkSmartPointer<vtkSelectionBitmap>::New();
+  this->SelectionBitmapMTime  = 0;
   this->EdgeWeightField       = 0;
   this->MinTime               = 0.0;
   this->MaxTime               = 37+3*99;
   this->CurrentTime           = 0.0;
+  this->CurvePixelTolerance   = 4.0;
+  this->VertexColorPercentiles[0] = 0.0;
+  this->VertexColorPercentiles[1] = 1.0;
+  this->VertexColorPercentilesSkipZeros = 0;
 
   this->BlockUpdate = 0;
   this->SelectMode       = vtkLineageView::SELECT_MODE;
@@ -135,6 +147,7 @@ vtkLineageView::vtkLineageView()
   this->CollapsedNodes->ScalingOff();
   this->TreeLayoutStrategy->SetAngle(360);
   this->TreeLayoutStrategy->SetRadial(true);
+  this->CollapseToPolyData->ArcOn();
   this->TreeLayoutStrategy->SetLogSpacingValue(1);
   this->TreeLayout->SetLayoutStrategy(this->TreeLayoutStrategy);
   this->IsoContour->SetValue(0, this->CurrentTime);
@@ -178,6 +191,7 @@ void vtkLineageView::SetLabelFieldName(const char *field)
 {
   // Set the field name
   this->LabeledDataMapper->SetFieldDataName(field);
+  this->LabelResolver->SetLabelTableName(field);
 }
 
 char* vtkLineageView::GetLabelFieldName()
@@ -199,6 +213,7 @@ void vtkLineageView::SetRadialLayout(bool radial)
 {
   this->Radial = radial;
   this->TreeLayoutStrategy->SetRadial(this->Radial);
+  this->CollapseToPolyData->SetArc(this->Radial ? 1 : 0);
   this->Renderer->ResetCamera();
 }
 
@@ -266,7 +281,7 @@ void vtkLineageView::SetupPipeline()
   this->IsoActor->PickableOff();
   this->PlaneActor->PickableOff();
   this->GlyphActor->PickableOff();
-  this->CollapsedGlyphActor->PickableOn();
+  this->CollapsedGlyphActor->PickableOff();
   this->LabelActor->PickableOff();
   this->SelectionActor->PickableOff();
   this->CollapseActor->PickableOn();
@@ -278,10 +293,13 @@ void vtkLineageView::SetupPipeline()
   ids->Delete();
 
   // Lay out the tree
-  //this->TreeLayout->SetInputConnection(0, this->TreeCollapse->GetOutputPort(0));
+  this->TreeLayout->SetInputConnection(0, this->TreeCollapse->GetOutputPort(0));
 
-  // Convert the laid out tree to poly data
+  // Convert the laid out tree to poly data. Labels are carried as indices
+  // and only turned into strings for the points the label mapper draws.
   this->CollapseToPolyData->SetInputConnection(0, this->TreeLayout->GetOutputPort(0));
+  this->CollapseToPolyData->SparseLabelsOn();
+  this->LabelResolver->SetInputConnection(0, this->CollapseToPolyData->GetOutputPort(0));
 
   // Set up glyphs at the tree nodes
   this->VertexGlyphs->SetInputConnection(0, this->CollapseToPolyData->GetOutputPort(0));
@@ -320,7 +338,6 @@ void vtkLineageView::SetupPipeline()
   this->TreeVertexToEdge->SetInput(0, selection);
   
   // Set up selection
-  //this->TreeVertexToEdge->SetInputConnection(1, this->TreeCollapse->GetOutputPort(0));
   this->TreeVertexToEdge->SetInputConnection(1, this->TreeLayout->GetOutputPort(0));
   this->ExtractSelection->SetInputConnection(0, this->CollapseToPolyData->GetOutputPort(0));
   this->ExtractSelection->SetInputConnection(1, this->TreeVertexToEdge->GetOutputPort(0));
@@ -330,7 +347,7 @@ void vtkLineageView::SetupPipeline()
   this->IsoLineMapper->SetInputConnection(0, this->SmoothContour->GetOutputPort(0));
   this->PlaneMapper->SetInputConnection(0, this->MakePlane->GetOutputPort(0));
   this->GlyphMapper->SetInputConnection(0, this->VertexGlyphs->GetOutputPort(0));
-  this->LabeledDataMapper->SetInputConnection(this->CollapseToPolyData->GetOutputPort());
+  this->LabeledDataMapper->SetInputConnection(this->LabelResolver->GetOutputPort());
   this->SelectionMapper->SetInputConnection(this->SelectionGeometry->GetOutputPort());
   this->CollapseMapper->SetInputConnection(this->CollapseToPolyData->GetOutputPort());
   this->CollapsedGlyphMapper->SetInputConnection(this->CollapsedNodes->GetOutputPort());
@@ -346,6 +363,7 @@ void vtkLineageView::SetupPipeline()
   this->CollapseMapper->SetLookupTable(ColorLUT);
   this->CollapseMapper->SetScalarRange( this->MinTime, this->MaxTime);
   this->CollapsedGlyphMapper->SetScalarVisibility(false);
+  this->CollapsedGlyphMapper->SetLookupTable(ColorLUT);
   
   // Set mappers to actors
   this->IsoActor->SetMapper(this->IsoLineMapper);
@@ -376,14 +394,20 @@ void vtkLineageView::SetVertexColorFieldName(const char *field)
   this->GlyphMapper->SetScalarModeToUsePointFieldData();
   this->GlyphMapper->SelectColorArray(field);
   
-  // Okay now get the range of the data field
-  double range[2]; 
-  this->CollapseToPolyData->Update();
-  vtkDataArray *array =
-    this->CollapseToPolyData->GetOutput()->GetPointData()->GetArray(field);
-  if (array)
+  // Take the range from the input tree, which holds every vertex whether
+  // collapsed or not, rather than updating the pipeline for it. Fields
+  // made by the pipeline are looked up in its current output.
+  double range[2];
+  vtkTree* tree = this->GetInputTree();
+  vtkDataArray *array = tree ? tree->GetVertexData()->GetArray(field) : 0;
+  if (!array)
+    {
+    array = this->CollapseToPolyData->GetOutput()->GetPointData()->GetArray(field);
+    }
+  if (vtkArrayRange::ComputePercentileRange(array,
+        this->VertexColorPercentiles[0], this->VertexColorPercentiles[1], range,
+        this->VertexColorPercentilesSkipZeros))
     {
-    array->GetRange(range);
     this->GlyphMapper->SetScalarRange( range[0], range[1] );
     } 
 }
@@ -397,18 +421,29 @@ void vtkLineageView::SetEdgeColorFieldName(const char *field)
   this->CollapseMapper->SetScalarModeToUseCellFieldData();
   this->CollapseMapper->SelectColorArray(field);
   
-  // Okay now get the range of the data field
-  double range[2]; 
-  this->CollapseToPolyData->Update();
-  vtkDataArray *array =
-    this->CollapseToPolyData->GetOutput()->GetCellData()->GetArray(field);
-  if (array)
+  // Same as for vertices, with the edge data.
+  double range[2];
+  vtkTree* tree = this->GetInputTree();
+  vtkDataArray *array = tree ? tree->GetEdgeData()->GetArray(field) : 0;
+  if (!array)
+    {
+    array = this->CollapseToPolyData->GetOutput()->GetCellData()->GetArray(field);
+    }
+  if (vtkArrayRange::ComputeRange(array, range))
     {
-    array->GetRange(range);
     this->CollapseMapper->SetScalarRange( range[0], range[1] );
     } 
 }
 
+vtkTree* vtkLineageView::GetInputTree()
+{
+  if (this->TreeCollapse->GetNumberOfInputConnections(0) == 0)
+    {
+    return 0;
+    }
+  return vtkTree::SafeDownCast(this->TreeCollapse->GetInputDataObject(0, 0));
+}
+
 void vtkLineageView::SetEdgeScalarVisibility(bool value)
 {
   this->CollapseMapper->SetScalarVisibility(value);
@@ -435,6 +470,176 @@ void vtkLineageView::SetElbowAngle(double value)
   this->CollapseToPolyData->SetFactor(value);
 }
 
+void vtkLineageView::SetCurve(int onOff)
+{
+  this->CollapseToPolyData->SetCurve(onOff);
+  this->Renderer->ResetCamera();
+}
+
+void vtkLineageView::CollapseGeneration(int generation)
+{
+  this->TreeCollapse->CollapseGeneration(generation);
+}
+
+void vtkLineageView::CollapseAfterTime(double time)
+{
+  this->TreeCollapse->CollapseAfterTime(time, "StartTime");
+}
+
+void vtkLineageView::ExpandAll()
+{
+  this->TreeCollapse->ExpandAll();
+}
+
+void vtkLineageView::SetCollapsedColorFieldName(const char* field)
+{
+  if (this->TreeCollapse->GetNumberOfInputConnections(0) > 0)
+    {
+    this->TreeCollapse->Update();
+    }
+  vtkDataArray* array = this->TreeCollapse->GetSubtreeStatistic(field);
+  if (!field || !array)
+    {
+    this->CollapsedGlyphMapper->SetScalarVisibility(false);
+    return;
+    }
+
+  // The statistics cover the whole input tree, so their range does not
+  // change when nodes are collapsed or expanded.
+  double range[2];
+  array->GetRange(range);
+  this->CollapsedGlyphMapper->SetScalarVisibility(true);
+  this->CollapsedGlyphMapper->SetScalarModeToUsePointFieldData();
+  this->CollapsedGlyphMapper->SelectColorArray(field);
+  this->CollapsedGlyphMapper->SetScalarRange(range[0], range[1]);
+}
+
+void vtkLineageView::SetCollapsedSizeFieldName(const char* field)
+{
+  if (this->TreeCollapse->GetNumberOfInputConnections(0) > 0)
+    {
+    this->TreeCollapse->Update();
+    }
+  vtkDataArray* array = this->TreeCollapse->GetSubtreeStatistic(field);
+  if (!field || !array)
+    {
+    this->CollapsedNodes->ScalingOff();
+    return;
+    }
+
+  // Glyphs grow from one to three times their size over the field range
+  double range[2];
+  array->GetRange(range);
+  this->CollapsedNodes->SetInputArrayToProcess(0, 0, 0,
+    vtkDataObject::FIELD_ASSOCIATION_POINTS, field);
+  this->CollapsedNodes->ScalingOn();
+  this->CollapsedNodes->SetScaleModeToScaleByScalar();
+  this->CollapsedNodes->ClampingOn();
+  this->CollapsedNodes->SetRange(range[0] - (range[1] - range[0]) / 2.0,
+                                 range[1]);
+  this->CollapsedNodes->SetScaleFactor(3.0);
+}
+
+void vtkLineageView::SelectRelatives(int relation)
+{
+  vtkDataRepresentation* rep = this->GetRepresentation();
+  vtkLineageTreeIndex* index = this->TreeCollapse->GetInputIndex();
+  if (!rep || !index)
+    {
+    return;
+    }
+
+  // Selections hold pedigree ids, the index works on vertex ids.
+  vtkSmartPointer<vtkIdTypeArray> vertices = vtkSmartPointer<vtkIdTypeArray>::New();
+  vtkSelection* current = rep->GetAnnotationLink()->GetCurrentSelection();
+  vtkSelectionNode* currentNode = current ? current->GetNode(0) : 0;
+  vtkIdTypeArray* currentIds = currentNode ?
+    vtkIdTypeArray::SafeDownCast(currentNode->GetSelectionList()) : 0;
+  vtkIdType numSelected = currentIds ? currentIds->GetNumberOfTuples() : 0;
+  for (vtkIdType i = 0; i < numSelected; i++)
+    {
+    vtkIdType v = index->GetVertexFromPedigree(currentIds->GetValue(i));
+    if (v >= 0)
+      {
+      vertices->InsertNextValue(v);
+      }
+    }
+
+  vtkSmartPointer<vtkIdTypeArray> relatives = vtkSmartPointer<vtkIdTypeArray>::New();
+  switch (relation)
+    {
+    case SELECT_DESCENDANTS:
+      index->GetDescendants(vertices, relatives, 1);
+      break;
+    case SELECT_ANCESTORS:
+      index->GetAncestors(vertices, relatives, 1);
+      break;
+    case SELECT_SIBLINGS:
+      index->GetSiblings(vertices, relatives, 1);
+      break;
+    case SELECT_GENERATION:
+      index->GetGenerations(vertices, relatives, 1);
+      break;
+    default:
+      vtkErrorMacro("Unknown relation " << relation);
+      return;
+    }
+  this->SelectVertices(index, relatives);
+}
+
+void vtkLineageView::SelectGeneration(int generation)
+{
+  vtkLineageTreeIndex* index = this->TreeCollapse->GetInputIndex();
+  if (!this->GetRepresentation() || !index)
+    {
+    return;
+    }
+  vtkSmartPointer<vtkIdTypeArray> vertices = vtkSmartPointer<vtkIdTypeArray>::New();
+  index->GetGeneration(generation, vertices);
+  this->SelectVertices(index, vertices);
+}
+
+void vtkLineageView::SelectVertices(vtkLineageTreeIndex* index,
+  vtkIdTypeArray* vertices)
+{
+  vtkIdType numVertices = vertices->GetNumberOfTuples();
+  vtkSmartPointer<vtkIdTypeArray> selectedIds = vtkSmartPointer<vtkIdTypeArray>::New();
+  selectedIds->SetNumberOfValues(numVertices);
+  for (vtkIdType i = 0; i < numVertices; i++)
+    {
+    selectedIds->SetValue(i, index->GetPedigree(vertices->GetValue(i)));
+    }
+  this->SelectionBitmap->Initialize();
+  this->SelectionBitmap->AddIds(selectedIds);
+  this->SelectBitmap();
+}
+
+void vtkLineageView::UpdateSelectionBitmap()
+{
+  vtkSelection* current =
+    this->GetRepresentation()->GetAnnotationLink()->GetCurrentSelection();
+  if (current != this->SelectionBitmapSource.GetPointer() ||
+      (current && current->GetMTime() != this->SelectionBitmapMTime))
+    {
+    this->SelectionBitmap->SetSelection(current);
+    this->SelectionBitmapSource = current;
+    this->SelectionBitmapMTime = current ? current->GetMTime() : 0;
+    }
+}
+
+void vtkLineageView::SelectBitmap()
+{
+  vtkSmartPointer<vtkSelection> selection = vtkSmartPointer<vtkSelection>::New();
+  this->SelectionBitmap->GetSelection(selection, vtkSelectionNode::VERTEX);
+  this->GetRepresentation()->Select(this, selection);
+
+  // Remember which selection of the link the bitmap stands for
+  vtkSelection* current =
+    this->GetRepresentation()->GetAnnotationLink()->GetCurrentSelection();
+  this->SelectionBitmapSource = current;
+  this->SelectionBitmapMTime = current ? current->GetMTime() : 0;
+}
+
 void vtkLineageView::SetDistanceArrayName(const char* name)
 {
   this->TreeLayoutStrategy->SetDistanceArrayName(name);
@@ -455,8 +660,7 @@ void vtkLineageView::AddRepresentationInternal(vtkDataRepresentation* rep)
 {
   if (this->TreeCollapse->GetNumberOfInputConnections(0) == 0)
     {
-    //this->TreeCollapse->SetInputConnection(rep->GetInputConnection());
-    this->TreeLayout->SetInputConnection(rep->GetInputConnection());
+    this->TreeCollapse->SetInputConnection(rep->GetInputConnection());
     
     this->Renderer->AddActor(this->IsoActor);
     this->Renderer->AddActor(this->GlyphActor);
@@ -464,7 +668,7 @@ void vtkLineageView::AddRepresentationInternal(vtkDataRepresentation* rep)
     this->Renderer->AddActor(this->SelectionActor);
     this->Renderer->AddActor(this->PlaneActor);
     this->Renderer->AddActor(this->CollapseActor);
-    //this->Renderer->AddActor(this->CollapsedGlyphActor);
+    this->Renderer->AddActor(this->CollapsedGlyphActor);
     this->Renderer->ResetCamera();
     }
   else
@@ -490,7 +694,7 @@ void vtkLineageView::RemoveRepresentationInternal(vtkDataRepresentation* rep)
     this->Renderer->RemoveActor(this->SelectionActor);
     this->Renderer->RemoveActor(this->PlaneActor);
     this->Renderer->RemoveActor(this->CollapseActor);
-    //this->Renderer->RemoveActor(this->CollapsedGlyphActor);
+    this->Renderer->RemoveActor(this->CollapsedGlyphActor);
     }
 }
 
@@ -507,7 +711,7 @@ void vtkLineageView::ProcessEvents(vtkObject* caller, unsigned long eventId,
   void* callData)
 {
   if (caller == this->GetInteractorStyle() && eventId == vtkCommand::SelectionChangedEvent
-      /*&& this->TreeCollapse->GetNumberOfInputConnections(0) > 0*/)
+      && this->TreeCollapse->GetNumberOfInputConnections(0) > 0)
     {
     unsigned int* rect = static_cast<unsigned int*>(callData);
 
@@ -530,13 +734,6 @@ void vtkLineageView::ProcessEvents(vtkObject* caller, unsigned long eventId,
     this->VisibleCellSelector->SetRenderPasses(0, 0, 0, 0, 1);
     this->VisibleCellSelector->Select();
 
-    vtksys_stl::set<vtkIdType> collapsedSet;
-    vtkIdTypeArray* collapsedOld = this->TreeCollapse->GetCollapsedNodes();
-    for (vtkIdType n = 0; n < collapsedOld->GetNumberOfTuples(); n++)
-      {
-      collapsedSet.insert(collapsedOld->GetValue(n));
-      }
-
     // Convert to pedigree ids and add to selection
     vtkIdTypeArray* ids = vtkIdTypeArray::New();
     this->VisibleCellSelector->GetSelectedIds(ids);
@@ -550,46 +747,29 @@ void vtkLineageView::ProcessEvents(vtkObject* caller, unsigned long eventId,
       vtkIdType vertId = tree->GetTargetVertex(edgeId);
       vtkIdType pedId = ped->GetValue(vertId);
       selectedIds->InsertNextValue(pedId);
-      if (collapsedSet.count(pedId) > 0)
-        {
-        collapsedSet.erase(pedId);
-        }
-      else
-        {
-        collapsedSet.insert(pedId);
-        }
       }
 
     if (this->SelectMode == vtkLineageView::COLLAPSE_MODE)
       {
-      vtkIdTypeArray* collapsedNew = vtkIdTypeArray::New();
-      vtksys_stl::set<vtkIdType>::iterator it, itEnd;
-      for (it = collapsedSet.begin(), itEnd = collapsedSet.end();
-           it != itEnd; ++it)
-        {
-        collapsedNew->InsertNextValue(*it);
-        }
-      this->TreeCollapse->SetCollapsedNodes(collapsedNew);
-      collapsedNew->Delete();
+      this->TreeCollapse->ToggleCollapsedNodes(selectedIds);
       }
     else if (this->SelectMode == vtkLineageView::SELECT_MODE)
       {
-      vtkSmartPointer<vtkSelection> selection = vtkSmartPointer<vtkSelection>::New();
-      vtkSmartPointer<vtkSelectionNode> node = vtkSmartPointer<vtkSelectionNode>::New();
-      node->SetContentType(vtkSelectionNode::INDICES);
-      node->SetFieldType(vtkSelectionNode::VERTEX);
-      node->SetSelectionList(selectedIds);
-      selection->AddNode(node);
-      
-      // If this is a union selection, append the selection
+      // If this is a union selection, append the selection. The merge
+      // happens on the bitmap, which removes duplicates and is only
+      // reloaded from the link when another view changed the selection.
       if (rect[4] == vtkInteractorStyleRubberBand2D::SELECT_UNION)
         {
-        vtkSelection* oldSelection = this->GetRepresentation()->GetAnnotationLink()->GetCurrentSelection();
-        selection->Union(oldSelection);
+        this->UpdateSelectionBitmap();
+        }
+      else
+        {
+        this->SelectionBitmap->Initialize();
         }
+      this->SelectionBitmap->AddIds(selectedIds);
       
       // Call select on the representation(s)
-      this->GetRepresentation()->Select(this, selection);
+      this->SelectBitmap();
       }
 
     ids->Delete();
@@ -615,8 +795,7 @@ void vtkLineageView::PrepareForRendering()
   
   // Make sure the input connection is up to date.
   vtkAlgorithmOutput* conn = rep->GetInputConnection();
-  //this->TreeCollapse->SetInputConnection(conn);
-  this->TreeLayout->SetInputConnection(conn);
+  this->TreeCollapse->SetInputConnection(conn);
   
   // Make sure the selection link is up to date.
   vtkAnnotationLink* link = rep->GetAnnotationLink();
@@ -624,6 +803,25 @@ void vtkLineageView::PrepareForRendering()
     {
     this->SetAnnotationLink(link);
     }
+
+  // Tessellate the curved edges in screen space. The segment length is
+  // rounded down to a power of two so that zooming only re-tessellates
+  // once the pixel size has changed by a factor of two.
+  int* size = this->Renderer->GetSize();
+  vtkCamera* camera = this->Renderer->GetActiveCamera();
+  if (this->CollapseToPolyData->GetCurve() && size[1] > 0)
+    {
+    double height = camera->GetParallelProjection() ?
+      2.0*camera->GetParallelScale() :
+      2.0*camera->GetDistance()*
+        tan(camera->GetViewAngle()*vtkMath::DoublePi()/360.0);
+    double length = this->CurvePixelTolerance*height/size[1];
+    if (length > 0)
+      {
+      this->CollapseToPolyData->SetMaximumSegmentLength(
+        pow(2.0, floor(log(length)/log(2.0))));
+      }
+    }
   
   this->Superclass::PrepareForRendering();
 }
@@ -635,4 +833,8 @@ void vtkLineageView::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "EdgeWeightField: " 
      << (this->EdgeWeightField ? this->EdgeWeightField : "(none)") << endl;   
+  os << indent << "VertexColorPercentiles: " << this->VertexColorPercentiles[0]
+     << " " << this->VertexColorPercentiles[1] << endl;
+  os << indent << "VertexColorPercentilesSkipZeros: "
+     << this->VertexColorPercentilesSkipZeros << endl;
 }
@@ -63,6 +63,10 @@ class vtkTreeCollapseFilter;
 class vtkTreeVertexToEdgeSelection;
 class vtkThresholdPoints;
 class vtkVertexGlyphFilter;
+class vtkResolveLabelIndices;
+class vtkLineageTreeIndex;
+class vtkIdTypeArray;
+class vtkSelectionBitmap;
 
 class vtkLineageView : public vtkRenderView 
 {
@@ -72,9 +76,25 @@ public:
   void PrintSelf(ostream& os, vtkIndent indent);
   
   // Description:
-  // The name of the vertex field used for coloring the vertices
+  // The name of the vertex field used for coloring the vertices. The
+  // colors span the values of the field in the input tree between
+  // VertexColorPercentiles.
   virtual void SetVertexColorFieldName(const char *field);
   virtual char* GetVertexColorFieldName();
+
+  // Description:
+  // The fractions of the vertex values below the first and last colors,
+  // 0 and 1 (the whole range) by default. Used by the next
+  // SetVertexColorFieldName.
+  vtkSetVector2Macro(VertexColorPercentiles, double);
+  vtkGetVector2Macro(VertexColorPercentiles, double);
+
+  // Description:
+  // Take the percentiles over the non-zero vertex values only, off by
+  // default. Used by the next SetVertexColorFieldName.
+  vtkSetMacro(VertexColorPercentilesSkipZeros, int);
+  vtkGetMacro(VertexColorPercentilesSkipZeros, int);
+  vtkBooleanMacro(VertexColorPercentilesSkipZeros, int);
   
   // Description:
   // The name of the edge field used for coloring the edges
@@ -134,6 +154,29 @@ public:
   void SetElbow(int onOff);
   void SetElbowAngle(double value);
 
+  // Description:
+  // Draw the edges as smooth curves, following arcs in radial layout.
+  // Curves are tessellated so that a segment spans about
+  // CurvePixelTolerance pixels at the current zoom.
+  void SetCurve(int onOff);
+  vtkSetClampMacro(CurvePixelTolerance, double, 0.5, 100.0);
+  vtkGetMacro(CurvePixelTolerance, double);
+
+  // Description:
+  // Collapse every subtree below the given generation, or every subtree
+  // born after the given time, or expand all subtrees. Each replaces the
+  // collapsed nodes at once, so the view updates a single time.
+  void CollapseGeneration(int generation);
+  void CollapseAfterTime(double time);
+  void ExpandAll();
+
+  // Description:
+  // Color, or scale, the collapsed node glyphs by one of the subtree
+  // statistics of vtkTreeCollapseFilter, e.g. "DescendantCount". A null
+  // name turns coloring (scaling) of the glyphs off.
+  void SetCollapsedColorFieldName(const char* field);
+  void SetCollapsedSizeFieldName(const char* field);
+
   // Description:
   // Change the mode of coloring edges by a scalar.
   void SetEdgeScalarVisibility(bool value);
@@ -154,8 +197,27 @@ public:
     COLLAPSE_MODE,
     SELECT_MODE
     };
+
+  enum
+    {
+    SELECT_DESCENDANTS,
+    SELECT_ANCESTORS,
+    SELECT_SIBLINGS,
+    SELECT_GENERATION
+    };
 //ETX
 
+  // Description:
+  // Replace the current selection by the selected cells together with
+  // their descendants, their ancestors up to the root, their siblings or
+  // every cell of their generations. The selection goes through the
+  // annotation link like a rubber band selection.
+  void SelectRelatives(int relation);
+
+  // Description:
+  // Select every cell of a generation, the root being generation 0.
+  void SelectGeneration(int generation);
+
   // Description:
   // The interaction mode for the viewer.
   vtkSetMacro(SelectMode, int);
@@ -190,6 +252,22 @@ protected:
   // Prepares the view for rendering.
   virtual void PrepareForRendering();
 
+  // Description:
+  // Select the pedigree ids of the given vertices of the input tree.
+  void SelectVertices(vtkLineageTreeIndex* index, vtkIdTypeArray* vertices);
+
+  // Description:
+  // The selected pedigree ids are kept in SelectionBitmap between
+  // selections. UpdateSelectionBitmap reloads it when the current
+  // selection of the annotation link was set by someone else, and
+  // SelectBitmap sends it through the representation as a vtkSelection.
+  void UpdateSelectionBitmap();
+  void SelectBitmap();
+
+  // Description:
+  // The tree shown, as it is before collapsing, or null.
+  vtkTree* GetInputTree();
+
   //BTX
   vtkSmartPointer<vtkTreeLayoutStrategy>            TreeLayoutStrategy;
   vtkSmartPointer<vtkGraphLayout>                   TreeLayout;
@@ -212,6 +290,7 @@ protected:
   vtkSmartPointer<vtkActor>                         CollapseActor;
   vtkSmartPointer<vtkActor2D>                       LabelActor;
   vtkSmartPointer<vtkLookupTable>                   ColorLUT;
+  vtkSmartPointer<vtkResolveLabelIndices>           LabelResolver;
   vtkSmartPointer<vtkDynamic2DLabelMapper>          LabeledDataMapper;
   vtkSmartPointer<vtkVisibleCellSelector>           VisibleCellSelector;
   vtkSmartPointer<vtkExtractSelectedIds>            ExtractSelection;
@@ -226,6 +305,9 @@ protected:
   vtkSmartPointer<vtkPolyDataMapper>                CollapsedGlyphMapper;
   vtkSmartPointer<vtkActor>                         CollapsedGlyphActor;
   vtkSmartPointer<vtkThresholdPoints>               CollapsedThreshold;
+  vtkSmartPointer<vtkSelectionBitmap>               SelectionBitmap;
+  vtkSmartPointer<vtkSelection>                     SelectionBitmapSource;
+  unsigned long                                     SelectionBitmapMTime;
   //ETX
   
   // Description:
@@ -267,6 +349,13 @@ private:
   double MaxTime;
   int BlockUpdate;
 
+  // Description:
+  // The on-screen length of a curved edge segment, in pixels.
+  double CurvePixelTolerance;
+
+  double VertexColorPercentiles[2];
+  int VertexColorPercentilesSkipZeros;
+
   vtkLineageView(const vtkLineageView&);  // Not implemented.
   void operator=(const vtkLineageView&);  // Not implemented.
 };
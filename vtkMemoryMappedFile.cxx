@@ -0,0 +1,164 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkMemoryMappedFile.h"
+
+#include "vtkObjectFactory.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+vtkCxxRevisionMacro(vtkMemoryMappedFile, "$Revision$");
+vtkStandardNewMacro(vtkMemoryMappedFile);
+
+vtkMemoryMappedFile::vtkMemoryMappedFile()
+{
+  this->Data = 0;
+  this->Size = 0;
+  this->Mapped = 0;
+#ifdef _WIN32
+  this->FileHandle = 0;
+  this->MappingHandle = 0;
+#else
+  this->FileDescriptor = -1;
+#endif
+}
+
+vtkMemoryMappedFile::~vtkMemoryMappedFile()
+{
+  this->Close();
+}
+
+int vtkMemoryMappedFile::Open(const char* fileName)
+{
+  this->Close();
+  if (!fileName)
+    {
+    return 0;
+    }
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0,
+    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if (file != INVALID_HANDLE_VALUE)
+    {
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    this->FileHandle = file;
+    this->Size = static_cast<size_t>(size.QuadPart);
+    if (this->Size == 0)
+      {
+      return 1;
+      }
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    if (mapping)
+      {
+      this->MappingHandle = mapping;
+      this->Data = static_cast<const char*>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      this->Mapped = this->Data != 0;
+      }
+    }
+#else
+  int fd = open(fileName, O_RDONLY);
+  if (fd >= 0)
+    {
+    struct stat info;
+    fstat(fd, &info);
+    this->FileDescriptor = fd;
+    this->Size = static_cast<size_t>(info.st_size);
+    if (this->Size == 0)
+      {
+      return 1;
+      }
+    void* data = mmap(0, this->Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+      {
+#ifdef MADV_SEQUENTIAL
+      madvise(data, this->Size, MADV_SEQUENTIAL);
+#endif
+      this->Data = static_cast<const char*>(data);
+      this->Mapped = 1;
+      }
+    }
+#endif
+
+  // Fall back to reading the file.
+  if (!this->Mapped)
+    {
+    this->Close();
+    FILE* file = fopen(fileName, "rb");
+    if (!file)
+      {
+      vtkErrorMacro("Could not open " << fileName);
+      return 0;
+      }
+    fseek(file, 0, SEEK_END);
+    this->Size = static_cast<size_t>(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    char* data = new char[this->Size > 0 ? this->Size : 1];
+    size_t read = fread(data, 1, this->Size, file);
+    fclose(file);
+    this->Data = data;
+    if (read != this->Size)
+      {
+      vtkErrorMacro("Could not read " << fileName);
+      this->Close();
+      return 0;
+      }
+    }
+  this->Modified();
+  return 1;
+}
+
+void vtkMemoryMappedFile::Close()
+{
+  if (this->Data && this->Mapped)
+    {
+#ifdef _WIN32
+    UnmapViewOfFile(this->Data);
+#else
+    munmap(const_cast<char*>(this->Data), this->Size);
+#endif
+    }
+  else if (this->Data)
+    {
+    delete [] this->Data;
+    }
+#ifdef _WIN32
+  if (this->MappingHandle)
+    {
+    CloseHandle(this->MappingHandle);
+    }
+  if (this->FileHandle)
+    {
+    CloseHandle(this->FileHandle);
+    }
+  this->MappingHandle = 0;
+  this->FileHandle = 0;
+#else
+  if (this->FileDescriptor >= 0)
+    {
+    close(this->FileDescriptor);
+    }
+  this->FileDescriptor = -1;
+#endif
+  this->Data = 0;
+  this->Size = 0;
+  this->Mapped = 0;
+}
+
+void vtkMemoryMappedFile::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "Size: " << this->Size << endl;
+  os << indent << "Mapped: " << this->Mapped << endl;
+}
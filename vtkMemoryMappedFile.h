@@ -0,0 +1,58 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkMemoryMappedFile - read only view of a whole file in memory
+//
+// .SECTION Description
+// vtkMemoryMappedFile maps a file into memory so that readers can parse
+// it in place, from several threads, without copying it into buffers.
+// Pages are loaded by the system as they are touched and shared with the
+// file cache. Where mapping is not available the file is read into memory
+// instead.
+
+#ifndef __vtkMemoryMappedFile_h
+#define __vtkMemoryMappedFile_h
+
+#include "vtkObject.h"
+
+class vtkMemoryMappedFile : public vtkObject
+{
+public:
+  static vtkMemoryMappedFile *New();
+  vtkTypeRevisionMacro(vtkMemoryMappedFile,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Map the file, unmapping any previous one. Returns 0 on failure.
+  int Open(const char* fileName);
+
+  // Description:
+  // Unmap the file.
+  void Close();
+
+  // Description:
+  // The contents of the file and its size in bytes, null and 0 when no
+  // file is open.
+  const char* GetData() { return this->Data; }
+  size_t GetSize() { return this->Size; }
+
+protected:
+  vtkMemoryMappedFile();
+  ~vtkMemoryMappedFile();
+
+  const char* Data;
+  size_t Size;
+  int Mapped;
+#ifdef _WIN32
+  void* FileHandle;
+  void* MappingHandle;
+#else
+  int FileDescriptor;
+#endif
+
+private:
+  vtkMemoryMappedFile(const vtkMemoryMappedFile&);  // Not implemented.
+  void operator=(const vtkMemoryMappedFile&);  // Not implemented.
+};
+
+#endif
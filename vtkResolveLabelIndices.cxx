@@ -0,0 +1,96 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkResolveLabelIndices.h"
+
+#include "vtkAbstractArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+
+vtkCxxRevisionMacro(vtkResolveLabelIndices, "$Revision$");
+vtkStandardNewMacro(vtkResolveLabelIndices);
+
+vtkResolveLabelIndices::vtkResolveLabelIndices()
+{
+  this->LabelIndexArrayName = 0;
+  this->LabelTableName = 0;
+  this->SetLabelIndexArrayName("LabelIndex");
+  this->SetLabelTableName("name");
+}
+
+vtkResolveLabelIndices::~vtkResolveLabelIndices()
+{
+  this->SetLabelIndexArrayName(0);
+  this->SetLabelTableName(0);
+}
+
+void vtkResolveLabelIndices::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "LabelIndexArrayName " << (this->LabelIndexArrayName ?
+    this->LabelIndexArrayName : "(none)") << endl;
+  os << indent << "LabelTableName " << (this->LabelTableName ?
+    this->LabelTableName : "(none)") << endl;
+}
+
+int vtkResolveLabelIndices::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkPolyData* input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+
+  vtkIdTypeArray* labelIndex = vtkIdTypeArray::SafeDownCast(
+    input->GetPointData()->GetAbstractArray(this->LabelIndexArrayName));
+  vtkAbstractArray* table =
+    input->GetFieldData()->GetAbstractArray(this->LabelTableName);
+  if (!labelIndex || !table)
+    {
+    // Nothing to resolve, labels are already strings.
+    output->ShallowCopy(input);
+    return 1;
+    }
+
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType numLabels = table->GetNumberOfTuples();
+  vtkIdType* index = labelIndex->GetPointer(0);
+  vtkIdType count = 0;
+  for (vtkIdType i = 0; i < numPts; i++)
+    {
+    if (index[i] >= 0 && index[i] < numLabels)
+      {
+      ++count;
+      }
+    }
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetNumberOfPoints(count);
+  vtkSmartPointer<vtkAbstractArray> labels;
+  labels.TakeReference(table->NewInstance());
+  labels->SetName(this->LabelTableName);
+  labels->SetNumberOfComponents(table->GetNumberOfComponents());
+  labels->SetNumberOfTuples(count);
+
+  vtkPoints* inPoints = input->GetPoints();
+  vtkIdType j = 0;
+  for (vtkIdType i = 0; i < numPts; i++)
+    {
+    if (index[i] >= 0 && index[i] < numLabels)
+      {
+      points->SetPoint(j, inPoints->GetPoint(i));
+      labels->SetTuple(j, index[i], table);
+      ++j;
+      }
+    }
+
+  output->SetPoints(points);
+  output->GetPointData()->AddArray(labels);
+  return 1;
+}
@@ -0,0 +1,53 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkResolveLabelIndices - turn label indices into label strings
+//
+// .SECTION Description
+// Takes poly data whose points carry an integer label index array (such as
+// the output of vtkElbowGraphToPolyData with SparseLabels on) and a label
+// table in the field data, and produces the labeled points only, with the
+// resolved strings in a point array named after the table. Points with a
+// negative index are dropped. Meant to sit in front of a label mapper so
+// strings are only built when labels are actually rendered.
+//
+// .SECTION See Also
+// vtkElbowGraphToPolyData
+
+#ifndef __vtkResolveLabelIndices_h
+#define __vtkResolveLabelIndices_h
+
+#include "vtkPolyDataAlgorithm.h"
+
+class vtkResolveLabelIndices : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkResolveLabelIndices *New();
+  vtkTypeRevisionMacro(vtkResolveLabelIndices,vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The point array holding the label indices. Default is "LabelIndex".
+  vtkSetStringMacro(LabelIndexArrayName);
+  vtkGetStringMacro(LabelIndexArrayName);
+
+  // Description:
+  // The field data array holding the label table. Default is "name".
+  vtkSetStringMacro(LabelTableName);
+  vtkGetStringMacro(LabelTableName);
+
+protected:
+  vtkResolveLabelIndices();
+  ~vtkResolveLabelIndices();
+
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  char* LabelIndexArrayName;
+  char* LabelTableName;
+
+private:
+  vtkResolveLabelIndices(const vtkResolveLabelIndices&);  // Not implemented.
+  void operator=(const vtkResolveLabelIndices&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,558 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+#include "vtkSelectionBitmap.h"
+
+#include "vtkIdTypeArray.h"
+#include "vtkObjectFactory.h"
+#include "vtkSelection.h"
+#include "vtkSelectionNode.h"
+#include "vtkSmartPointer.h"
+
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/iterator>
+#include <vtksys/stl/vector>
+
+vtkCxxRevisionMacro(vtkSelectionBitmap, "$Revision$");
+vtkStandardNewMacro(vtkSelectionBitmap);
+
+// Ids per chunk, 64 bit words in a chunk bitmap and the largest number of
+// ids a chunk keeps as a sorted list (a list of 4096 offsets takes as much
+// memory as the bitmap).
+#define VTK_SELECTION_BITMAP_CHUNK_BITS 16
+#define VTK_SELECTION_BITMAP_WORDS 1024
+#define VTK_SELECTION_BITMAP_MAX_LIST 4096
+
+static inline int vtkSelectionBitmapPopCount(vtkTypeUInt64 w)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll(w);
+#else
+  int count = 0;
+  for (; w; w &= w - 1)
+    {
+    ++count;
+    }
+  return count;
+#endif
+}
+
+static inline int vtkSelectionBitmapTrailingZeros(vtkTypeUInt64 w)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(w);
+#else
+  int count = 0;
+  for (; !(w & 1); w >>= 1)
+    {
+    ++count;
+    }
+  return count;
+#endif
+}
+
+class vtkSelectionBitmapChunk
+{
+public:
+  vtkSelectionBitmapChunk() : Key(0), Count(0) {}
+
+  // Ids of the chunk are Key * 65536 + offset. Offsets are kept in List
+  // while there are few of them, otherwise in Bits.
+  vtkIdType Key;
+  vtkIdType Count;
+  vtksys_stl::vector<unsigned short> List;
+  vtksys_stl::vector<vtkTypeUInt64> Bits;
+
+  bool IsBitmap() const { return !this->Bits.empty(); }
+
+  // Expand the chunk into a bitmap of VTK_SELECTION_BITMAP_WORDS words.
+  void GetBits(vtkTypeUInt64* words) const
+    {
+    if (this->IsBitmap())
+      {
+      vtksys_stl::copy(this->Bits.begin(), this->Bits.end(), words);
+      return;
+      }
+    vtksys_stl::fill(words, words + VTK_SELECTION_BITMAP_WORDS, 0);
+    for (vtksys_stl::vector<unsigned short>::size_type i = 0; i < this->List.size(); ++i)
+      {
+      words[this->List[i] >> 6] |= static_cast<vtkTypeUInt64>(1) << (this->List[i] & 63);
+      }
+    }
+
+  // Set the chunk from a bitmap, choosing the smaller representation.
+  void SetBits(const vtkTypeUInt64* words)
+    {
+    this->Count = 0;
+    for (int w = 0; w < VTK_SELECTION_BITMAP_WORDS; ++w)
+      {
+      this->Count += vtkSelectionBitmapPopCount(words[w]);
+      }
+    if (this->Count > VTK_SELECTION_BITMAP_MAX_LIST)
+      {
+      this->Bits.assign(words, words + VTK_SELECTION_BITMAP_WORDS);
+      this->List.clear();
+      return;
+      }
+    this->Bits.clear();
+    this->List.clear();
+    this->List.reserve(this->Count);
+    for (int w = 0; w < VTK_SELECTION_BITMAP_WORDS; ++w)
+      {
+      for (vtkTypeUInt64 bits = words[w]; bits; bits &= bits - 1)
+        {
+        this->List.push_back(static_cast<unsigned short>(
+          64*w + vtkSelectionBitmapTrailingZeros(bits)));
+        }
+      }
+    }
+
+  // Set the chunk from a sorted list of offsets.
+  void SetList(const vtksys_stl::vector<unsigned short>& list)
+    {
+    this->Count = static_cast<vtkIdType>(list.size());
+    this->Bits.clear();
+    this->List = list;
+    if (this->Count > VTK_SELECTION_BITMAP_MAX_LIST)
+      {
+      vtkTypeUInt64 words[VTK_SELECTION_BITMAP_WORDS];
+      this->GetBits(words);
+      this->SetBits(words);
+      }
+    }
+};
+
+class vtkSelectionBitmapInternals
+{
+public:
+  enum
+    {
+    UNION,
+    INTERSECT,
+    SUBTRACT,
+    TOGGLE
+    };
+
+  // Non-empty chunks sorted by key.
+  vtksys_stl::vector<vtkSelectionBitmapChunk> Chunks;
+
+  vtkSelectionBitmapChunk* Find(vtkIdType key, bool create);
+  void Combine(const vtkSelectionBitmapInternals& other, int op);
+  static void CombineChunks(const vtkSelectionBitmapChunk& a,
+    const vtkSelectionBitmapChunk& b, int op, vtkSelectionBitmapChunk& result);
+};
+
+class vtkSelectionBitmapKeyLess
+{
+public:
+  bool operator()(const vtkSelectionBitmapChunk& chunk, vtkIdType key) const
+    {
+    return chunk.Key < key;
+    }
+};
+
+vtkSelectionBitmapChunk* vtkSelectionBitmapInternals::Find(vtkIdType key, bool create)
+{
+  vtksys_stl::vector<vtkSelectionBitmapChunk>::iterator it =
+    vtksys_stl::lower_bound(this->Chunks.begin(), this->Chunks.end(), key,
+      vtkSelectionBitmapKeyLess());
+  if (it != this->Chunks.end() && it->Key == key)
+    {
+    return &*it;
+    }
+  if (!create)
+    {
+    return 0;
+    }
+  it = this->Chunks.insert(it, vtkSelectionBitmapChunk());
+  it->Key = key;
+  return &*it;
+}
+
+void vtkSelectionBitmapInternals::CombineChunks(const vtkSelectionBitmapChunk& a,
+  const vtkSelectionBitmapChunk& b, int op, vtkSelectionBitmapChunk& result)
+{
+  result.Key = a.Key;
+
+  // Two lists are merged, anything else is combined a word at a time.
+  if (!a.IsBitmap() && !b.IsBitmap())
+    {
+    vtksys_stl::vector<unsigned short> list;
+    vtksys_stl::back_insert_iterator<vtksys_stl::vector<unsigned short> > out =
+      vtksys_stl::back_inserter(list);
+    switch (op)
+      {
+      case UNION:
+        vtksys_stl::set_union(a.List.begin(), a.List.end(),
+          b.List.begin(), b.List.end(), out);
+        break;
+      case INTERSECT:
+        vtksys_stl::set_intersection(a.List.begin(), a.List.end(),
+          b.List.begin(), b.List.end(), out);
+        break;
+      case SUBTRACT:
+        vtksys_stl::set_difference(a.List.begin(), a.List.end(),
+          b.List.begin(), b.List.end(), out);
+        break;
+      default:
+        vtksys_stl::set_symmetric_difference(a.List.begin(), a.List.end(),
+          b.List.begin(), b.List.end(), out);
+        break;
+      }
+    result.SetList(list);
+    return;
+    }
+
+  vtkTypeUInt64 wordsA[VTK_SELECTION_BITMAP_WORDS];
+  vtkTypeUInt64 wordsB[VTK_SELECTION_BITMAP_WORDS];
+  a.GetBits(wordsA);
+  b.GetBits(wordsB);
+  int w;
+  switch (op)
+    {
+    case UNION:
+      for (w = 0; w < VTK_SELECTION_BITMAP_WORDS; ++w)
+        {
+        wordsA[w] |= wordsB[w];
+        }
+      break;
+    case INTERSECT:
+      for (w = 0; w < VTK_SELECTION_BITMAP_WORDS; ++w)
+        {
+        wordsA[w] &= wordsB[w];
+        }
+      break;
+    case SUBTRACT:
+      for (w = 0; w < VTK_SELECTION_BITMAP_WORDS; ++w)
+        {
+        wordsA[w] &= ~wordsB[w];
+        }
+      break;
+    default:
+      for (w = 0; w < VTK_SELECTION_BITMAP_WORDS; ++w)
+        {
+        wordsA[w] ^= wordsB[w];
+        }
+      break;
+    }
+  result.SetBits(wordsA);
+}
+
+// Merges the chunk lists by key. Chunks only in this set are kept unless
+// intersecting, chunks only in the other set are added for union and
+// symmetric difference.
+void vtkSelectionBitmapInternals::Combine(const vtkSelectionBitmapInternals& other,
+  int op)
+{
+  vtksys_stl::vector<vtkSelectionBitmapChunk> result;
+  result.reserve(this->Chunks.size() + other.Chunks.size());
+  vtksys_stl::vector<vtkSelectionBitmapChunk>::size_type i = 0;
+  vtksys_stl::vector<vtkSelectionBitmapChunk>::size_type j = 0;
+  while (i < this->Chunks.size() || j < other.Chunks.size())
+    {
+    if (j == other.Chunks.size() ||
+        (i < this->Chunks.size() && this->Chunks[i].Key < other.Chunks[j].Key))
+      {
+      if (op != INTERSECT)
+        {
+        result.push_back(this->Chunks[i]);
+        }
+      ++i;
+      }
+    else if (i == this->Chunks.size() || other.Chunks[j].Key < this->Chunks[i].Key)
+      {
+      if (op == UNION || op == TOGGLE)
+        {
+        result.push_back(other.Chunks[j]);
+        }
+      ++j;
+      }
+    else
+      {
+      vtkSelectionBitmapChunk chunk;
+      CombineChunks(this->Chunks[i], other.Chunks[j], op, chunk);
+      if (chunk.Count > 0)
+        {
+        result.push_back(chunk);
+        }
+      ++i;
+      ++j;
+      }
+    }
+  this->Chunks.swap(result);
+}
+
+vtkSelectionBitmap::vtkSelectionBitmap()
+{
+  this->Internals = new vtkSelectionBitmapInternals;
+}
+
+vtkSelectionBitmap::~vtkSelectionBitmap()
+{
+  delete this->Internals;
+}
+
+void vtkSelectionBitmap::Initialize()
+{
+  this->Internals->Chunks.clear();
+  this->Modified();
+}
+
+void vtkSelectionBitmap::AddId(vtkIdType id)
+{
+  if (id < 0)
+    {
+    return;
+    }
+  vtkSelectionBitmapChunk* chunk =
+    this->Internals->Find(id >> VTK_SELECTION_BITMAP_CHUNK_BITS, true);
+  unsigned short offset = static_cast<unsigned short>(id & 0xffff);
+  if (chunk->IsBitmap())
+    {
+    vtkTypeUInt64 bit = static_cast<vtkTypeUInt64>(1) << (offset & 63);
+    if (!(chunk->Bits[offset >> 6] & bit))
+      {
+      chunk->Bits[offset >> 6] |= bit;
+      ++chunk->Count;
+      }
+    }
+  else
+    {
+    vtksys_stl::vector<unsigned short>::iterator it =
+      vtksys_stl::lower_bound(chunk->List.begin(), chunk->List.end(), offset);
+    if (it == chunk->List.end() || *it != offset)
+      {
+      chunk->List.insert(it, offset);
+      ++chunk->Count;
+      if (chunk->Count > VTK_SELECTION_BITMAP_MAX_LIST)
+        {
+        vtkTypeUInt64 words[VTK_SELECTION_BITMAP_WORDS];
+        chunk->GetBits(words);
+        chunk->SetBits(words);
+        }
+      }
+    }
+  this->Modified();
+}
+
+void vtkSelectionBitmap::AddRange(vtkIdType first, vtkIdType last)
+{
+  first = first < 0 ? 0 : first;
+  if (last <= first)
+    {
+    return;
+    }
+
+  // Fill the range chunk by chunk into a second set, then merge.
+  vtkSelectionBitmapInternals range;
+  vtkTypeUInt64 words[VTK_SELECTION_BITMAP_WORDS];
+  vtkIdType firstKey = first >> VTK_SELECTION_BITMAP_CHUNK_BITS;
+  vtkIdType lastKey = (last - 1) >> VTK_SELECTION_BITMAP_CHUNK_BITS;
+  for (vtkIdType key = firstKey; key <= lastKey; ++key)
+    {
+    vtkIdType begin = key == firstKey ? (first & 0xffff) : 0;
+    vtkIdType end = key == lastKey ? ((last - 1) & 0xffff) + 1 : 0x10000;
+    vtksys_stl::fill(words, words + VTK_SELECTION_BITMAP_WORDS, 0);
+    for (vtkIdType b = begin; b < end; )
+      {
+      if ((b & 63) == 0 && b + 64 <= end)
+        {
+        words[b >> 6] = ~static_cast<vtkTypeUInt64>(0);
+        b += 64;
+        }
+      else
+        {
+        words[b >> 6] |= static_cast<vtkTypeUInt64>(1) << (b & 63);
+        ++b;
+        }
+      }
+    range.Chunks.push_back(vtkSelectionBitmapChunk());
+    range.Chunks.back().Key = key;
+    range.Chunks.back().SetBits(words);
+    }
+  this->Internals->Combine(range, vtkSelectionBitmapInternals::UNION);
+  this->Modified();
+}
+
+void vtkSelectionBitmap::AddIds(vtkIdTypeArray* ids)
+{
+  if (!ids || ids->GetNumberOfTuples() == 0)
+    {
+    return;
+    }
+
+  // Sort the ids, cut them into chunks and merge those in one pass.
+  vtksys_stl::vector<vtkIdType> sorted(ids->GetPointer(0),
+    ids->GetPointer(0) + ids->GetNumberOfTuples());
+  vtksys_stl::sort(sorted.begin(), sorted.end());
+  sorted.erase(vtksys_stl::unique(sorted.begin(), sorted.end()), sorted.end());
+  vtksys_stl::vector<vtkIdType>::iterator it =
+    vtksys_stl::lower_bound(sorted.begin(), sorted.end(), 0);
+
+  vtkSelectionBitmapInternals added;
+  vtksys_stl::vector<unsigned short> list;
+  while (it != sorted.end())
+    {
+    vtkIdType key = *it >> VTK_SELECTION_BITMAP_CHUNK_BITS;
+    list.clear();
+    for (; it != sorted.end() && (*it >> VTK_SELECTION_BITMAP_CHUNK_BITS) == key; ++it)
+      {
+      list.push_back(static_cast<unsigned short>(*it & 0xffff));
+      }
+    added.Chunks.push_back(vtkSelectionBitmapChunk());
+    added.Chunks.back().Key = key;
+    added.Chunks.back().SetList(list);
+    }
+  this->Internals->Combine(added, vtkSelectionBitmapInternals::UNION);
+  this->Modified();
+}
+
+int vtkSelectionBitmap::ContainsId(vtkIdType id)
+{
+  if (id < 0)
+    {
+    return 0;
+    }
+  vtkSelectionBitmapChunk* chunk =
+    this->Internals->Find(id >> VTK_SELECTION_BITMAP_CHUNK_BITS, false);
+  if (!chunk)
+    {
+    return 0;
+    }
+  unsigned short offset = static_cast<unsigned short>(id & 0xffff);
+  if (chunk->IsBitmap())
+    {
+    return (chunk->Bits[offset >> 6] >> (offset & 63)) & 1 ? 1 : 0;
+    }
+  return vtksys_stl::binary_search(chunk->List.begin(), chunk->List.end(), offset) ? 1 : 0;
+}
+
+vtkIdType vtkSelectionBitmap::GetNumberOfIds()
+{
+  vtkIdType count = 0;
+  for (vtksys_stl::vector<vtkSelectionBitmapChunk>::size_type i = 0;
+       i < this->Internals->Chunks.size(); ++i)
+    {
+    count += this->Internals->Chunks[i].Count;
+    }
+  return count;
+}
+
+void vtkSelectionBitmap::Union(vtkSelectionBitmap* other)
+{
+  if (other && other != this)
+    {
+    this->Internals->Combine(*other->Internals, vtkSelectionBitmapInternals::UNION);
+    this->Modified();
+    }
+}
+
+void vtkSelectionBitmap::Intersect(vtkSelectionBitmap* other)
+{
+  if (!other)
+    {
+    this->Initialize();
+    }
+  else if (other != this)
+    {
+    this->Internals->Combine(*other->Internals, vtkSelectionBitmapInternals::INTERSECT);
+    this->Modified();
+    }
+}
+
+void vtkSelectionBitmap::Subtract(vtkSelectionBitmap* other)
+{
+  if (other == this)
+    {
+    this->Initialize();
+    }
+  else if (other)
+    {
+    this->Internals->Combine(*other->Internals, vtkSelectionBitmapInternals::SUBTRACT);
+    this->Modified();
+    }
+}
+
+void vtkSelectionBitmap::Toggle(vtkSelectionBitmap* other)
+{
+  if (other == this)
+    {
+    this->Initialize();
+    }
+  else if (other)
+    {
+    this->Internals->Combine(*other->Internals, vtkSelectionBitmapInternals::TOGGLE);
+    this->Modified();
+    }
+}
+
+void vtkSelectionBitmap::DeepCopy(vtkSelectionBitmap* other)
+{
+  if (other && other != this)
+    {
+    this->Internals->Chunks = other->Internals->Chunks;
+    this->Modified();
+    }
+}
+
+void vtkSelectionBitmap::GetIds(vtkIdTypeArray* ids)
+{
+  vtkIdType* out = ids->WritePointer(ids->GetNumberOfTuples(), this->GetNumberOfIds());
+  for (vtksys_stl::vector<vtkSelectionBitmapChunk>::size_type i = 0;
+       i < this->Internals->Chunks.size(); ++i)
+    {
+    const vtkSelectionBitmapChunk& chunk = this->Internals->Chunks[i];
+    vtkIdType base = chunk.Key << VTK_SELECTION_BITMAP_CHUNK_BITS;
+    if (chunk.IsBitmap())
+      {
+      for (int w = 0; w < VTK_SELECTION_BITMAP_WORDS; ++w)
+        {
+        for (vtkTypeUInt64 bits = chunk.Bits[w]; bits; bits &= bits - 1)
+          {
+          *out++ = base + 64*w + vtkSelectionBitmapTrailingZeros(bits);
+          }
+        }
+      }
+    else
+      {
+      for (vtksys_stl::vector<unsigned short>::size_type k = 0; k < chunk.List.size(); ++k)
+        {
+        *out++ = base + chunk.List[k];
+        }
+      }
+    }
+}
+
+void vtkSelectionBitmap::SetSelection(vtkSelection* selection)
+{
+  this->Internals->Chunks.clear();
+  unsigned int numNodes = selection ? selection->GetNumberOfNodes() : 0;
+  for (unsigned int n = 0; n < numNodes; ++n)
+    {
+    vtkSelectionNode* node = selection->GetNode(n);
+    if (node->GetContentType() == vtkSelectionNode::INDICES)
+      {
+      this->AddIds(vtkIdTypeArray::SafeDownCast(node->GetSelectionList()));
+      }
+    }
+  this->Modified();
+}
+
+void vtkSelectionBitmap::GetSelection(vtkSelection* selection, int fieldType)
+{
+  vtkSmartPointer<vtkIdTypeArray> ids = vtkSmartPointer<vtkIdTypeArray>::New();
+  this->GetIds(ids);
+  vtkSmartPointer<vtkSelectionNode> node = vtkSmartPointer<vtkSelectionNode>::New();
+  node->SetContentType(vtkSelectionNode::INDICES);
+  node->SetFieldType(fieldType);
+  node->SetSelectionList(ids);
+  selection->Initialize();
+  selection->AddNode(node);
+}
+
+void vtkSelectionBitmap::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "NumberOfIds: " << this->GetNumberOfIds() << endl;
+  os << indent << "NumberOfChunks: " << this->Internals->Chunks.size() << endl;
+}
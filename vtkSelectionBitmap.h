@@ -0,0 +1,84 @@
+// Copyright 2009 Sandia Corporation, Kitware Inc.
+// See LICENSE.txt for details.
+
+// .NAME vtkSelectionBitmap - compressed set of non-negative ids
+//
+// .SECTION Description
+// vtkSelectionBitmap holds a set of vertex or edge ids split in chunks of
+// 65536 consecutive ids. A chunk holding few ids keeps them as a sorted
+// list of 16 bit offsets, a fuller chunk as a bitmap of 1024 64 bit words,
+// so that set operations on dense selections work a word at a time.
+// Selections are kept in this form between interactions and only turned
+// into a vtkSelection id list when handed to the rest of the pipeline.
+
+#ifndef __vtkSelectionBitmap_h
+#define __vtkSelectionBitmap_h
+
+#include "vtkObject.h"
+
+class vtkIdTypeArray;
+class vtkSelection;
+class vtkSelectionBitmapInternals;
+
+class vtkSelectionBitmap : public vtkObject
+{
+public:
+  static vtkSelectionBitmap *New();
+  vtkTypeRevisionMacro(vtkSelectionBitmap,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Remove all ids.
+  void Initialize();
+
+  // Description:
+  // Add one id, the ids in [first, last), or all the ids of an array.
+  // Negative ids are ignored.
+  void AddId(vtkIdType id);
+  void AddRange(vtkIdType first, vtkIdType last);
+  void AddIds(vtkIdTypeArray* ids);
+
+  // Description:
+  // Whether the id is in the set.
+  int ContainsId(vtkIdType id);
+
+  // Description:
+  // The number of ids in the set.
+  vtkIdType GetNumberOfIds();
+
+  // Description:
+  // Replace this set by its union, intersection, difference or symmetric
+  // difference with another set.
+  void Union(vtkSelectionBitmap* other);
+  void Intersect(vtkSelectionBitmap* other);
+  void Subtract(vtkSelectionBitmap* other);
+  void Toggle(vtkSelectionBitmap* other);
+
+  // Description:
+  // Copy another set.
+  void DeepCopy(vtkSelectionBitmap* other);
+
+  // Description:
+  // Append the ids in increasing order to an array.
+  void GetIds(vtkIdTypeArray* ids);
+
+  // Description:
+  // Replace the set by the ids of the index selection nodes of a
+  // selection, or replace the contents of a selection by a single index
+  // node of the given field type (vtkSelectionNode::VERTEX, EDGE, ...)
+  // holding the ids of the set.
+  void SetSelection(vtkSelection* selection);
+  void GetSelection(vtkSelection* selection, int fieldType);
+
+protected:
+  vtkSelectionBitmap();
+  ~vtkSelectionBitmap();
+
+  vtkSelectionBitmapInternals* Internals;
+
+private:
+  vtkSelectionBitmap(const vtkSelectionBitmap&);  // Not implemented.
+  void operator=(const vtkSelectionBitmap&);  // Not implemented.
+};
+
+#endif
@@ -3,82 +3,294 @@
 
 #include "vtkTreeCollapseFilter.h"
 
+#include "vtkAlgorithmOutput.h"
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkCharArray.h"
 #include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkIntArray.h"
+#include "vtkLineageTreeIndex.h"
 #include "vtkMath.h"
 #include "vtkMutableDirectedGraph.h"
 #include "vtkObjectFactory.h"
-#include "vtkOutEdgeIterator.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
 #include "vtkSmartPointer.h"
 #include "vtkStringArray.h"
 #include "vtkTree.h"
-#include "vtkTreeDFSIterator.h"
 #include "vtkVariant.h"
 
 #include <assert.h>
-#include <vtksys/stl/set>
+#include <string.h>
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/functional>
+#include <vtksys/stl/iterator>
+#include <vtksys/stl/vector>
 
 vtkCxxRevisionMacro(vtkTreeCollapseFilter, "$Revision$");
 vtkStandardNewMacro(vtkTreeCollapseFilter);
 vtkCxxSetObjectMacro(vtkTreeCollapseFilter, CollapsedNodes, vtkIdTypeArray);
 
-vtkTreeCollapseFilter::vtkTreeCollapseFilter()
+// The collapsed tree kept between executions, with the maps between input
+// and output vertices. The subtree walks run over the preorder intervals of
+// the input tree, so they never recurse and visit only the affected range.
+class vtkTreeCollapseFilterInternals
 {
-  this->CollapsedNodes = 0;
+public:
+  vtkSmartPointer<vtkLineageTreeIndex> Index;
+  vtkSmartPointer<vtkMutableDirectedGraph> Builder;
+  vtkCharArray* CollapsedArray;
+  vtkTree* Input;
+  unsigned long InputMTime;
+
+  // Collapsed state by pedigree id, as a bitmap and as a sorted list.
+  vtksys_stl::vector<bool> Collapsed;
+  vtksys_stl::vector<vtkIdType> CollapsedList;
+
+  // Output vertex of each input vertex (-1 when hidden), and back.
+  vtksys_stl::vector<vtkIdType> InputToOutput;
+  vtksys_stl::vector<vtkIdType> OutputToInput;
+
+  // Subtree statistics of the input vertices, and their output copies.
+  vtksys_stl::vector<vtkSmartPointer<vtkDataArray> > Statistics;
+  vtksys_stl::vector<vtkDataArray*> OutputStatistics;
+
+  bool IsCollapsed(vtkIdType v);
+  void SetCollapsed(const vtksys_stl::vector<vtkIdType>& list);
+  void ComputeStatistics(vtkTree* input);
+  void Rebuild(vtkTree* input);
+  void AddSubtree(vtkTree* input, vtkIdType first, vtkIdType last);
+  void RemoveSubtree(vtkIdType v);
+};
+
+bool vtkTreeCollapseFilterInternals::IsCollapsed(vtkIdType v)
+{
+  vtkIdType pedId = this->Index->GetPedigree(v);
+  return pedId >= 0 && pedId < static_cast<vtkIdType>(this->Collapsed.size()) &&
+    this->Collapsed[pedId];
 }
 
-vtkTreeCollapseFilter::~vtkTreeCollapseFilter()
+void vtkTreeCollapseFilterInternals::SetCollapsed(
+  const vtksys_stl::vector<vtkIdType>& list)
 {
-  this->SetCollapsedNodes(0);
+  this->Collapsed.assign(list.empty() ? 0 : list.back() + 1, false);
+  vtksys_stl::vector<vtkIdType>::const_iterator it;
+  for ( it = list.begin(); it != list.end(); ++it )
+    {
+    this->Collapsed[*it] = true;
+    }
 }
 
-void vtkTreeCollapseFilterCollapsedDFS(vtkTree* input,
-  vtkIdType idx, vtkIdType parent, vtkMutableDirectedGraph* output, 
-  const vtksys_stl::set<vtkIdType>& collapsedNodes, vtkPoints* pts,
-  vtkIdTypeArray* ped, vtkCharArray* collapsedArray)
+// Accumulates the statistics of every subtree in a single sweep over the
+// vertices in reverse preorder, where children come before their parent.
+void vtkTreeCollapseFilterInternals::ComputeStatistics(vtkTree* input)
 {
-  vtkIdType newChild = -1;
-  if ( parent == -1 )
+  vtkIdType numVertices = input->GetNumberOfVertices();
+  const vtkIdType* parent = this->Index->GetParent()->GetPointer(0);
+  const vtkIdType* preIndex = this->Index->GetPreorderIndex()->GetPointer(0);
+  const vtkIdType* preVertex = this->Index->GetPreorderVertex()->GetPointer(0);
+  const vtkIdType* subtreeEnd = this->Index->GetSubtreeEnd()->GetPointer(0);
+  vtkDataArray* startTime = input->GetVertexData()->GetArray("StartTime");
+  vtkDataArray* endTime = input->GetVertexData()->GetArray("EndTime");
+  vtkDataArray* geneCount = input->GetVertexData()->GetArray("GeneCount");
+
+  this->Statistics.clear();
+  vtkIdTypeArray* descendantArr = vtkIdTypeArray::New();
+  descendantArr->SetName("DescendantCount");
+  vtkIdTypeArray* leafArr = vtkIdTypeArray::New();
+  leafArr->SetName("LeafCount");
+  vtkIdTypeArray* heightArr = vtkIdTypeArray::New();
+  heightArr->SetName("SubtreeHeight");
+  descendantArr->SetNumberOfValues(numVertices);
+  leafArr->SetNumberOfValues(numVertices);
+  heightArr->SetNumberOfValues(numVertices);
+  vtkIdType* descendants = descendantArr->GetPointer(0);
+  vtkIdType* leaves = leafArr->GetPointer(0);
+  vtkIdType* height = heightArr->GetPointer(0);
+  for ( vtkIdType v = 0; v < numVertices; ++v )
     {
-    newChild = output->AddVertex();
+    descendants[v] = subtreeEnd[v] - preIndex[v] - 1;
+    leaves[v] = descendants[v] == 0 ? 1 : 0;
+    height[v] = 0;
     }
-  else
+  this->Statistics.push_back(descendantArr);
+  this->Statistics.push_back(leafArr);
+  this->Statistics.push_back(heightArr);
+  descendantArr->Delete();
+  leafArr->Delete();
+  heightArr->Delete();
+
+  double* minStart = 0;
+  double* maxEnd = 0;
+  double* maxGenes = 0;
+  const char* names[3] = { "SubtreeMinStartTime", "SubtreeMaxEndTime",
+                           "SubtreeMaxGeneCount" };
+  vtkDataArray* sources[3] = { startTime, endTime, geneCount };
+  double** values[3] = { &minStart, &maxEnd, &maxGenes };
+  for ( int a = 0; a < 3; ++a )
     {
-    newChild = output->AddChild(parent);
-    vtkEdgeType newEdge = output->AddEdge(parent, newChild);
-    vtkEdgeType oldEdge = input->GetParentEdge(idx);
-    output->GetEdgeData()->CopyData(input->GetEdgeData(),oldEdge.Id,newEdge.Id);
+    if ( !sources[a] )
+      {
+      continue;
+      }
+    vtkDoubleArray* arr = vtkDoubleArray::New();
+    arr->SetName(names[a]);
+    arr->SetNumberOfValues(numVertices);
+    for ( vtkIdType v = 0; v < numVertices; ++v )
+      {
+      arr->SetValue(v, sources[a]->GetTuple1(v));
+      }
+    *values[a] = arr->GetPointer(0);
+    this->Statistics.push_back(arr);
+    arr->Delete();
     }
-  output->GetVertexData()->CopyData(input->GetVertexData(),idx,newChild);
-  double pt[3];
-  input->GetPoint(idx, pt);
-  pts->InsertPoint(newChild, pt);
 
-  // If it is a collapsed node, skip traversal
-  vtkIdType pedId = ped->GetValue(idx);
-  if ( collapsedNodes.find(pedId) == collapsedNodes.end() )
+  for ( vtkIdType i = numVertices - 1; i > 0; --i )
     {
-    vtkSmartPointer<vtkOutEdgeIterator> it = vtkSmartPointer<vtkOutEdgeIterator>::New();
-    input->GetOutEdges(idx, it);
-    while ( it->HasNext() )
+    vtkIdType v = preVertex[i];
+    vtkIdType p = parent[v];
+    leaves[p] += leaves[v];
+    if ( height[v] + 1 > height[p] )
+      {
+      height[p] = height[v] + 1;
+      }
+    if ( minStart && minStart[v] < minStart[p] )
+      {
+      minStart[p] = minStart[v];
+      }
+    if ( maxEnd && maxEnd[v] > maxEnd[p] )
+      {
+      maxEnd[p] = maxEnd[v];
+      }
+    if ( maxGenes && maxGenes[v] > maxGenes[p] )
       {
-      vtkOutEdgeType e = it->Next();
-      vtkTreeCollapseFilterCollapsedDFS(input, e.Target, newChild, output,
-        collapsedNodes, pts, ped, collapsedArray);
+      maxGenes[p] = maxGenes[v];
       }
-    collapsedArray->InsertValue(newChild, 0);
     }
-  else
+}
+
+void vtkTreeCollapseFilterInternals::Rebuild(vtkTree* input)
+{
+  this->Builder = vtkSmartPointer<vtkMutableDirectedGraph>::New();
+  this->Builder->GetVertexData()->CopyAllocate(input->GetVertexData());
+  this->Builder->GetEdgeData()->CopyAllocate(input->GetEdgeData());
+  this->CollapsedArray = vtkCharArray::New();
+  this->CollapsedArray->SetName("Collapsed");
+  this->Builder->GetVertexData()->AddArray(this->CollapsedArray);
+  this->CollapsedArray->Delete();
+  this->OutputStatistics.clear();
+  for ( vtksys_stl::vector<vtkSmartPointer<vtkDataArray> >::size_type a = 0;
+        a < this->Statistics.size(); ++a )
     {
-    collapsedArray->InsertValue(newChild, 1);
+    vtkDataArray* arr = this->Statistics[a]->NewInstance();
+    arr->SetName(this->Statistics[a]->GetName());
+    this->Builder->GetVertexData()->AddArray(arr);
+    this->OutputStatistics.push_back(arr);
+    arr->Delete();
     }
+
+  vtkIdType numVertices = input->GetNumberOfVertices();
+  this->InputToOutput.assign(numVertices, -1);
+  this->OutputToInput.clear();
+  this->AddSubtree(input, 0, numVertices);
+}
+
+// Adds the vertices at preorder positions [first, last) that are visible,
+// skipping whole subtrees below collapsed or hidden vertices. Parents come
+// before their children in preorder, so they are always placed already.
+void vtkTreeCollapseFilterInternals::AddSubtree(vtkTree* input,
+  vtkIdType first, vtkIdType last)
+{
+  const vtkIdType* parent = this->Index->GetParent()->GetPointer(0);
+  const vtkIdType* preVertex = this->Index->GetPreorderVertex()->GetPointer(0);
+  const vtkIdType* subtreeEnd = this->Index->GetSubtreeEnd()->GetPointer(0);
+  vtkMutableDirectedGraph* output = this->Builder;
+  for ( vtkIdType i = first; i < last; ++i )
+    {
+    vtkIdType idx = preVertex[i];
+    vtkIdType p = parent[idx];
+    if ( p >= 0 && (this->InputToOutput[p] < 0 || this->IsCollapsed(p)) )
+      {
+      i = subtreeEnd[idx] - 1;
+      continue;
+      }
+    if ( this->InputToOutput[idx] >= 0 )
+      {
+      continue;
+      }
+
+    vtkIdType newChild = output->AddVertex();
+    if ( p >= 0 )
+      {
+      vtkEdgeType newEdge = output->AddEdge(this->InputToOutput[p], newChild);
+      vtkEdgeType oldEdge = input->GetParentEdge(idx);
+      output->GetEdgeData()->CopyData(input->GetEdgeData(),oldEdge.Id,newEdge.Id);
+      }
+    output->GetVertexData()->CopyData(input->GetVertexData(),idx,newChild);
+    this->CollapsedArray->InsertValue(newChild, this->IsCollapsed(idx) ? 1 : 0);
+    for ( vtksys_stl::vector<vtkDataArray*>::size_type a = 0;
+          a < this->OutputStatistics.size(); ++a )
+      {
+      this->OutputStatistics[a]->InsertTuple(newChild, idx, this->Statistics[a]);
+      }
+    this->InputToOutput[idx] = newChild;
+    this->OutputToInput.push_back(idx);
+    }
+}
+
+// Removes the visible descendants of v. The graph fills the slot of each
+// removed vertex with its last vertex, so removing in decreasing id order
+// never moves a vertex that is still to be removed.
+void vtkTreeCollapseFilterInternals::RemoveSubtree(vtkIdType v)
+{
+  const vtkIdType* preVertex = this->Index->GetPreorderVertex()->GetPointer(0);
+  vtkIdType first = this->Index->GetPreorderIndex()->GetValue(v) + 1;
+  vtkIdType last = this->Index->GetSubtreeEnd()->GetValue(v);
+  vtksys_stl::vector<vtkIdType> removed;
+  for ( vtkIdType i = first; i < last; ++i )
+    {
+    vtkIdType idx = preVertex[i];
+    if ( this->InputToOutput[idx] >= 0 )
+      {
+      removed.push_back(this->InputToOutput[idx]);
+      this->InputToOutput[idx] = -1;
+      }
+    }
+  vtksys_stl::sort(removed.begin(), removed.end(), vtksys_stl::greater<vtkIdType>());
+
+  vtksys_stl::vector<vtkIdType>::iterator it;
+  for ( it = removed.begin(); it != removed.end(); ++it )
+    {
+    vtkIdType lastVertex = this->Builder->GetNumberOfVertices() - 1;
+    this->Builder->RemoveVertex(*it);
+    if ( *it != lastVertex )
+      {
+      vtkIdType moved = this->OutputToInput[lastVertex];
+      this->OutputToInput[*it] = moved;
+      this->InputToOutput[moved] = *it;
+      }
+    this->OutputToInput.pop_back();
+    }
+}
+
+vtkTreeCollapseFilter::vtkTreeCollapseFilter()
+{
+  this->CollapsedNodes = 0;
+  this->Internals = new vtkTreeCollapseFilterInternals;
+  this->Internals->Index = vtkSmartPointer<vtkLineageTreeIndex>::New();
+  this->Internals->CollapsedArray = 0;
+  this->Internals->Input = 0;
+  this->Internals->InputMTime = 0;
+}
+
+vtkTreeCollapseFilter::~vtkTreeCollapseFilter()
+{
+  this->SetCollapsedNodes(0);
+  delete this->Internals;
 }
 
 int vtkTreeCollapseFilter::RequestData(
@@ -96,44 +308,251 @@ int vtkTreeCollapseFilter::RequestData(
   vtkTree* outputTree = vtkTree::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
+  vtkTreeCollapseFilterInternals* internals = this->Internals;
   if (inputTree->GetNumberOfVertices() == 0)
     {
+    internals->Builder = 0;
+    internals->Input = 0;
     return 1;
     }
 
-  vtkSmartPointer<vtkMutableDirectedGraph> builder =
-    vtkSmartPointer<vtkMutableDirectedGraph>::New();
-
-  // Copy collapsed nodes to the set
-  vtksys_stl::set<vtkIdType> collapsedNodes;
+  // Sorted list of the collapsed pedigree ids
+  vtksys_stl::vector<vtkIdType> collapsedList;
   vtkIdType cc;
-  for ( cc = 0; cc < this->CollapsedNodes->GetNumberOfTuples(); ++ cc )
+  vtkIdType numCollapsed =
+    this->CollapsedNodes ? this->CollapsedNodes->GetNumberOfTuples() : 0;
+  for ( cc = 0; cc < numCollapsed; ++ cc )
     {
-    collapsedNodes.insert(this->CollapsedNodes->GetValue(cc));
+    vtkIdType pedId = this->CollapsedNodes->GetValue(cc);
+    if ( pedId >= 0 )
+      {
+      collapsedList.push_back(pedId);
+      }
     }
+  vtksys_stl::sort(collapsedList.begin(), collapsedList.end());
+  collapsedList.erase(vtksys_stl::unique(collapsedList.begin(), collapsedList.end()),
+    collapsedList.end());
 
-  builder->GetVertexData()->CopyAllocate(inputTree->GetVertexData());
-  builder->GetEdgeData()->CopyAllocate(inputTree->GetEdgeData());
-  vtkCharArray* collapsedArray = vtkCharArray::New();
-  collapsedArray->SetName("Collapsed");
-  builder->GetVertexData()->AddArray(collapsedArray);
-  collapsedArray->Delete();
+  internals->Index->Build(inputTree);
+  if ( !internals->Builder || internals->Input != inputTree ||
+       internals->InputMTime != inputTree->GetMTime() )
+    {
+    // New input, build the whole collapsed tree.
+    internals->SetCollapsed(collapsedList);
+    internals->ComputeStatistics(inputTree);
+    internals->Rebuild(inputTree);
+    internals->Builder->Squeeze();
+    internals->Input = inputTree;
+    internals->InputMTime = inputTree->GetMTime();
+    }
+  else
+    {
+    // Only splice the subtrees of the nodes that changed state, collapsing
+    // first so that expanded subtrees are added with the final state.
+    vtksys_stl::vector<vtkIdType> changed;
+    vtksys_stl::set_symmetric_difference(
+      internals->CollapsedList.begin(), internals->CollapsedList.end(),
+      collapsedList.begin(), collapsedList.end(),
+      vtksys_stl::back_inserter(changed));
+    internals->SetCollapsed(collapsedList);
 
+    vtkLineageTreeIndex* index = internals->Index;
+    vtksys_stl::vector<vtkIdType>::iterator it;
+    for ( int collapse = 1; collapse >= 0; --collapse )
+      {
+      for ( it = changed.begin(); it != changed.end(); ++it )
+        {
+        vtkIdType v = index->GetVertexFromPedigree(*it);
+        if ( v < 0 || internals->IsCollapsed(v) != (collapse == 1) ||
+             internals->InputToOutput[v] < 0 )
+          {
+          continue;
+          }
+        internals->CollapsedArray->SetValue(internals->InputToOutput[v],
+          static_cast<char>(collapse));
+        if ( collapse )
+          {
+          internals->RemoveSubtree(v);
+          }
+        else
+          {
+          internals->AddSubtree(inputTree,
+            index->GetPreorderIndex()->GetValue(v) + 1,
+            index->GetSubtreeEnd()->GetValue(v));
+          }
+        }
+      }
+    }
+  internals->CollapsedList.swap(collapsedList);
+
+  // Points follow the output to input map.
+  vtkIdType numOutput = static_cast<vtkIdType>(internals->OutputToInput.size());
   vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-  vtkIdTypeArray* ped = vtkIdTypeArray::SafeDownCast(
-    inputTree->GetVertexData()->GetAbstractArray("PedigreeVertexId"));
-  vtkTreeCollapseFilterCollapsedDFS(inputTree, 0, -1, builder, collapsedNodes, points,
-    ped, collapsedArray);
-  builder->SetPoints(points);
-  builder->Squeeze();
+  points->SetNumberOfPoints(numOutput);
+  double pt[3];
+  for ( vtkIdType v = 0; v < numOutput; ++v )
+    {
+    inputTree->GetPoint(internals->OutputToInput[v], pt);
+    points->SetPoint(v, pt);
+    }
+  internals->Builder->SetPoints(points);
 
-  outputTree->CheckedShallowCopy(builder);
+  outputTree->CheckedShallowCopy(internals->Builder);
 
   return 1;
 }
 
+vtkTree* vtkTreeCollapseFilter::UpdateInputIndex()
+{
+  if ( this->GetNumberOfInputConnections(0) == 0 )
+    {
+    return 0;
+    }
+  this->GetInputConnection(0, 0)->GetProducer()->Update();
+  vtkTree* inputTree = vtkTree::SafeDownCast(this->GetInputDataObject(0, 0));
+  if ( inputTree )
+    {
+    this->Internals->Index->Build(inputTree);
+    }
+  return inputTree;
+}
+
+vtkLineageTreeIndex* vtkTreeCollapseFilter::GetInputIndex()
+{
+  return this->UpdateInputIndex() ? this->Internals->Index.GetPointer() : 0;
+}
+
+void vtkTreeCollapseFilter::ToggleCollapsedNodes(vtkIdTypeArray* ids)
+{
+  vtksys_stl::vector<vtkIdType> current;
+  vtksys_stl::vector<vtkIdType> toggled;
+  vtkIdType cc;
+  if ( this->CollapsedNodes )
+    {
+    for ( cc = 0; cc < this->CollapsedNodes->GetNumberOfTuples(); ++cc )
+      {
+      current.push_back(this->CollapsedNodes->GetValue(cc));
+      }
+    }
+  for ( cc = 0; ids && cc < ids->GetNumberOfTuples(); ++cc )
+    {
+    toggled.push_back(ids->GetValue(cc));
+    }
+  vtksys_stl::sort(current.begin(), current.end());
+  current.erase(vtksys_stl::unique(current.begin(), current.end()), current.end());
+  vtksys_stl::sort(toggled.begin(), toggled.end());
+  toggled.erase(vtksys_stl::unique(toggled.begin(), toggled.end()), toggled.end());
+
+  vtkIdTypeArray* collapsed = vtkIdTypeArray::New();
+  collapsed->Allocate(static_cast<vtkIdType>(current.size() + toggled.size()));
+  vtksys_stl::vector<vtkIdType> result;
+  vtksys_stl::set_symmetric_difference(current.begin(), current.end(),
+    toggled.begin(), toggled.end(), vtksys_stl::back_inserter(result));
+  for ( vtksys_stl::vector<vtkIdType>::size_type i = 0; i < result.size(); ++i )
+    {
+    collapsed->InsertNextValue(result[i]);
+    }
+  this->SetCollapsedNodes(collapsed);
+  collapsed->Delete();
+}
+
+void vtkTreeCollapseFilter::CollapseGeneration(int generation)
+{
+  vtkTree* inputTree = this->UpdateInputIndex();
+  vtkIdTypeArray* collapsed = vtkIdTypeArray::New();
+  if ( inputTree )
+    {
+    // Walk down to the generation only, jumping over the subtree interval
+    // of every vertex found there.
+    vtkLineageTreeIndex* index = this->Internals->Index;
+    const vtkIdType* preVertex = index->GetPreorderVertex()->GetPointer(0);
+    const vtkIdType* subtreeEnd = index->GetSubtreeEnd()->GetPointer(0);
+    const vtkIdType* depth = index->GetDepth()->GetPointer(0);
+    vtkIdType numVertices = index->GetNumberOfVertices();
+    for ( vtkIdType i = 0; i < numVertices; ++i )
+      {
+      vtkIdType v = preVertex[i];
+      if ( depth[v] < generation )
+        {
+        continue;
+        }
+      if ( subtreeEnd[v] > i + 1 )
+        {
+        collapsed->InsertNextValue(index->GetPedigree(v));
+        }
+      i = subtreeEnd[v] - 1;
+      }
+    }
+  this->SetCollapsedNodes(collapsed);
+  collapsed->Delete();
+}
+
+void vtkTreeCollapseFilter::CollapseAfterTime(double time, const char* arrayName)
+{
+  vtkTree* inputTree = this->UpdateInputIndex();
+  vtkDataArray* times = inputTree ?
+    inputTree->GetVertexData()->GetArray(arrayName) : 0;
+  if ( inputTree && !times )
+    {
+    vtkErrorMacro("No vertex array named " << (arrayName ? arrayName : "(null)"));
+    return;
+    }
+  vtkIdTypeArray* collapsed = vtkIdTypeArray::New();
+  if ( inputTree )
+    {
+    // Stop at the first vertex born after time along every path.
+    vtkLineageTreeIndex* index = this->Internals->Index;
+    const vtkIdType* preVertex = index->GetPreorderVertex()->GetPointer(0);
+    const vtkIdType* subtreeEnd = index->GetSubtreeEnd()->GetPointer(0);
+    vtkIdType numVertices = index->GetNumberOfVertices();
+    for ( vtkIdType i = 0; i < numVertices; ++i )
+      {
+      vtkIdType v = preVertex[i];
+      if ( times->GetTuple1(v) <= time )
+        {
+        continue;
+        }
+      if ( subtreeEnd[v] > i + 1 )
+        {
+        collapsed->InsertNextValue(index->GetPedigree(v));
+        }
+      i = subtreeEnd[v] - 1;
+      }
+    }
+  this->SetCollapsedNodes(collapsed);
+  collapsed->Delete();
+}
+
+vtkDataArray* vtkTreeCollapseFilter::GetSubtreeStatistic(const char* name)
+{
+  if ( !name )
+    {
+    return 0;
+    }
+  for ( vtksys_stl::vector<vtkSmartPointer<vtkDataArray> >::size_type a = 0;
+        a < this->Internals->Statistics.size(); ++a )
+    {
+    const char* arrName = this->Internals->Statistics[a]->GetName();
+    if ( arrName && !strcmp(arrName, name) )
+      {
+      return this->Internals->Statistics[a];
+      }
+    }
+  return 0;
+}
+
+void vtkTreeCollapseFilter::ExpandAll()
+{
+  vtkIdTypeArray* collapsed = vtkIdTypeArray::New();
+  this->SetCollapsedNodes(collapsed);
+  collapsed->Delete();
+}
+
 void vtkTreeCollapseFilter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
-  os << indent << *this->CollapsedNodes << endl;
+  if ( this->CollapsedNodes )
+    {
+    os << indent << *this->CollapsedNodes << endl;
+    }
 }
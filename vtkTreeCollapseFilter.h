@@ -6,12 +6,30 @@
 // .SECTION Description
 // This filter takes input list of nodes and collapses (hides) the subtrees
 // rooted at those nodes.
+//
+// The filter keeps the tree it produced between executions. When only the
+// list of collapsed nodes changed, it compares it with the previous list
+// and splices the affected subtrees out of, or back into, that tree instead
+// of rebuilding it. Vertices outside the affected subtrees keep their ids,
+// except for the few moved into the slots of removed vertices.
+//
+// Every output vertex also carries statistics about its subtree in the
+// input tree, so that collapsed vertices can show what they hide:
+// "DescendantCount", "LeafCount", "SubtreeHeight" (generations below the
+// vertex), "SubtreeMinStartTime", "SubtreeMaxEndTime" and, when the input
+// has a "GeneCount" vertex array, "SubtreeMaxGeneCount". They are computed
+// once per input tree, so collapsing or expanding only looks them up.
 
 #ifndef __vtkTreeCollapseFilter_h
 #define __vtkTreeCollapseFilter_h
 
 #include "vtkTreeAlgorithm.h"
 
+class vtkDataArray;
+class vtkLineageTreeIndex;
+class vtkTreeCollapseFilterInternals;
+class vtkTree;
+
 class vtkTreeCollapseFilter : public vtkTreeAlgorithm
 {
 public:
@@ -24,6 +42,32 @@ public:
   virtual void SetCollapsedNodes(vtkIdTypeArray* ids);
   vtkGetObjectMacro(CollapsedNodes, vtkIdTypeArray);
 
+  // Description:
+  // Toggle the collapsed state of the given pedigree ids.
+  void ToggleCollapsedNodes(vtkIdTypeArray* ids);
+
+  // Description:
+  // Bulk operations replacing the list of collapsed nodes, computed in one
+  // pass over the current input. CollapseGeneration collapses every vertex
+  // of the given generation (the root is generation 0), hiding all deeper
+  // ones. CollapseAfterTime collapses the topmost vertices whose value in
+  // the given vertex array is greater than time, hiding every subtree born
+  // after it. ExpandAll clears the list.
+  void CollapseGeneration(int generation);
+  void CollapseAfterTime(double time, const char* arrayName = "StartTime");
+  void ExpandAll();
+
+  // Description:
+  // The subtree statistic with the given name, for every input vertex.
+  // Valid after the filter has executed on its current input.
+  vtkDataArray* GetSubtreeStatistic(const char* name);
+
+  // Description:
+  // Bring the input up to date and return the index of the input tree, or
+  // null without input. The index is shared with the filter, so it is only
+  // rebuilt when the input changes.
+  vtkLineageTreeIndex* GetInputIndex();
+
 protected:
   vtkTreeCollapseFilter();
   ~vtkTreeCollapseFilter();
@@ -32,7 +76,12 @@ protected:
   // Convert the vtkGraph into vtkPolyData.
   int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
 
+  // Description:
+  // Bring the input up to date and index it.
+  vtkTree* UpdateInputIndex();
+
   vtkIdTypeArray* CollapsedNodes;
+  vtkTreeCollapseFilterInternals* Internals;
 
 private:
   vtkTreeCollapseFilter(const vtkTreeCollapseFilter&);  // Not implemented.
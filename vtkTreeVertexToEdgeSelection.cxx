@@ -5,6 +5,7 @@
 
 #include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkSelection.h"
@@ -12,14 +13,115 @@
 #include "vtkSmartPointer.h"
 #include "vtkTree.h"
 
-#include <vtksys/stl/map>
+#include <vtksys/stl/algorithm>
+#include <vtksys/stl/utility>
+#include <vtksys/stl/vector>
+
+// Entry of the pedigree table for ids that are not in the tree. The root
+// has no parent edge and its entry is -1.
+#define VTK_TREE_VERTEX_TO_EDGE_MISS -2
 
 class vtkTreeVertexToEdgeSelectionInternals
 {
 public:
-  vtksys_stl::map<vtkIdType, vtkIdType> PedigreeToId;
+  // Pedigree ids of the vertices, and the parent edge of every vertex.
+  vtksys_stl::vector<vtkIdType> Pedigrees;
+  vtksys_stl::vector<vtkIdType> ParentEdge;
+
+  // Dense table from pedigree id - Offset to parent edge, used when the
+  // pedigree ids are compact enough. Otherwise (pedigree id, vertex) pairs
+  // sorted by pedigree id.
+  vtkIdType Offset;
+  vtksys_stl::vector<vtkIdType> PedigreeToEdge;
+  vtksys_stl::vector<vtksys_stl::pair<vtkIdType, vtkIdType> > Sorted;
+
+  vtkIdType Lookup(vtkIdType pedigree)
+    {
+    vtksys_stl::vector<vtksys_stl::pair<vtkIdType, vtkIdType> >::iterator it =
+      vtksys_stl::lower_bound(this->Sorted.begin(), this->Sorted.end(),
+        vtksys_stl::make_pair(pedigree, static_cast<vtkIdType>(-1)));
+    if (it == this->Sorted.end() || it->first != pedigree)
+      {
+      return VTK_TREE_VERTEX_TO_EDGE_MISS;
+      }
+    return this->ParentEdge[it->second];
+    }
+};
+
+// Shared state of the threads indexing the tree, each working on its own
+// range of vertices. The first pass finds the range of the pedigree ids
+// and the parent edges, the second scatters the vertices into the dense
+// table and the third counts vertices that lost their slot to
+// another vertex with the same pedigree id. Which of these wins the
+// scatter is arbitrary, BuildIndex rescatters serially when there are any.
+class vtkTreeVertexToEdgeSelectionIndexer
+{
+public:
+  enum
+    {
+    RANGE_PASS,
+    SCATTER_PASS,
+    VALIDATE_PASS
+    };
+
+  int Pass;
+  vtkTree* Tree;
+  vtkIdType NumberOfVertices;
+  const vtkIdType* Pedigrees;
+  vtkIdType* ParentEdge;
+  vtkIdType Offset;
+  vtkIdType* PedigreeToEdge;
+  vtksys_stl::vector<vtkIdType> Minimum;
+  vtksys_stl::vector<vtkIdType> Maximum;
+  vtksys_stl::vector<vtkIdType> Duplicates;
+
+  static VTK_THREAD_RETURN_TYPE Execute(void* arg);
 };
 
+VTK_THREAD_RETURN_TYPE vtkTreeVertexToEdgeSelectionIndexer::Execute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkTreeVertexToEdgeSelectionIndexer* self =
+    static_cast<vtkTreeVertexToEdgeSelectionIndexer*>(info->UserData);
+  int thread = info->ThreadID;
+  vtkIdType begin = self->NumberOfVertices * thread / info->NumberOfThreads;
+  vtkIdType end = self->NumberOfVertices * (thread + 1) / info->NumberOfThreads;
+  const vtkIdType* pedigrees = self->Pedigrees;
+  if (self->Pass == RANGE_PASS)
+    {
+    vtkIdType minimum = VTK_ID_MAX;
+    vtkIdType maximum = VTK_ID_MIN;
+    for (vtkIdType v = begin; v < end; v++)
+      {
+      minimum = pedigrees[v] < minimum ? pedigrees[v] : minimum;
+      maximum = pedigrees[v] > maximum ? pedigrees[v] : maximum;
+      self->ParentEdge[v] = self->Tree->GetParentEdge(v).Id;
+      }
+    self->Minimum[thread] = minimum;
+    self->Maximum[thread] = maximum;
+    }
+  else if (self->Pass == SCATTER_PASS)
+    {
+    // Vertices with the same pedigree id race for their slot, the
+    // validation pass only counts the losers.
+    for (vtkIdType v = begin; v < end; v++)
+      {
+      self->PedigreeToEdge[pedigrees[v] - self->Offset] = v;
+      }
+    }
+  else
+    {
+    vtkIdType duplicates = 0;
+    for (vtkIdType v = begin; v < end; v++)
+      {
+      duplicates += self->PedigreeToEdge[pedigrees[v] - self->Offset] != v;
+      }
+    self->Duplicates[thread] = duplicates;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 vtkCxxRevisionMacro(vtkTreeVertexToEdgeSelection, "$Revision$");
 vtkStandardNewMacro(vtkTreeVertexToEdgeSelection);
 
@@ -29,6 +131,8 @@ vtkTreeVertexToEdgeSelection::vtkTreeVertexToEdgeSelection()
   this->Internals = new vtkTreeVertexToEdgeSelectionInternals;
   this->Tree = NULL;
   this->TreeMTime = 0;
+  this->NumberOfMisses = 0;
+  this->NumberOfDuplicates = 0;
 }
 
 vtkTreeVertexToEdgeSelection::~vtkTreeVertexToEdgeSelection()
@@ -39,6 +143,125 @@ vtkTreeVertexToEdgeSelection::~vtkTreeVertexToEdgeSelection()
 void vtkTreeVertexToEdgeSelection::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfMisses: " << this->NumberOfMisses << endl;
+  os << indent << "NumberOfDuplicates: " << this->NumberOfDuplicates << endl;
+}
+
+void vtkTreeVertexToEdgeSelection::BuildIndex(vtkTree* tree)
+{
+  vtkTreeVertexToEdgeSelectionInternals* internals = this->Internals;
+  vtkIdType numVertices = tree->GetNumberOfVertices();
+
+  // Without pedigree ids, vertices are their own pedigree
+  vtkDataArray* ped = vtkDataArray::SafeDownCast(
+    tree->GetVertexData()->GetAbstractArray("PedigreeVertexId"));
+  vtkIdTypeArray* idPed = vtkIdTypeArray::SafeDownCast(ped);
+  internals->Pedigrees.resize(numVertices);
+  if (!idPed)
+    {
+    for (vtkIdType v = 0; v < numVertices; v++)
+      {
+      internals->Pedigrees[v] =
+        ped ? static_cast<vtkIdType>(ped->GetTuple1(v)) : v;
+      }
+    }
+  internals->ParentEdge.resize(numVertices);
+  internals->PedigreeToEdge.clear();
+  internals->Sorted.clear();
+  internals->Offset = 0;
+  this->NumberOfDuplicates = 0;
+  if (numVertices == 0)
+    {
+    return;
+    }
+
+  vtkSmartPointer<vtkMultiThreader> threader =
+    vtkSmartPointer<vtkMultiThreader>::New();
+  if (numVertices < 4096)
+    {
+    threader->SetNumberOfThreads(1);
+    }
+  int numThreads = threader->GetNumberOfThreads();
+
+  vtkTreeVertexToEdgeSelectionIndexer indexer;
+  indexer.Tree = tree;
+  indexer.NumberOfVertices = numVertices;
+  indexer.Pedigrees = idPed ? idPed->GetPointer(0) : &internals->Pedigrees[0];
+  indexer.ParentEdge = &internals->ParentEdge[0];
+  indexer.Minimum.resize(numThreads);
+  indexer.Maximum.resize(numThreads);
+  indexer.Duplicates.resize(numThreads);
+  threader->SetSingleMethod(vtkTreeVertexToEdgeSelectionIndexer::Execute, &indexer);
+
+  indexer.Pass = vtkTreeVertexToEdgeSelectionIndexer::RANGE_PASS;
+  threader->SingleMethodExecute();
+  vtkIdType minimum = *vtksys_stl::min_element(
+    indexer.Minimum.begin(), indexer.Minimum.end());
+  vtkIdType maximum = *vtksys_stl::max_element(
+    indexer.Maximum.begin(), indexer.Maximum.end());
+
+  // Arbitrary pedigree ids could make the dense table huge, fall back to
+  // binary search when it would be mostly empty.
+  if (maximum - minimum > 4*numVertices + 1024)
+    {
+    if (idPed)
+      {
+      internals->Pedigrees.assign(indexer.Pedigrees, indexer.Pedigrees + numVertices);
+      }
+    internals->Sorted.resize(numVertices);
+    for (vtkIdType v = 0; v < numVertices; v++)
+      {
+      internals->Sorted[v] = vtksys_stl::make_pair(internals->Pedigrees[v], v);
+      }
+    vtksys_stl::sort(internals->Sorted.begin(), internals->Sorted.end());
+    for (vtkIdType i = 1; i < numVertices; i++)
+      {
+      if (internals->Sorted[i].first == internals->Sorted[i-1].first)
+        {
+        ++this->NumberOfDuplicates;
+        }
+      }
+    }
+  else
+    {
+    internals->Offset = minimum;
+    internals->PedigreeToEdge.assign(maximum - minimum + 1,
+      VTK_TREE_VERTEX_TO_EDGE_MISS);
+    indexer.Offset = minimum;
+    indexer.PedigreeToEdge = &internals->PedigreeToEdge[0];
+    indexer.Pass = vtkTreeVertexToEdgeSelectionIndexer::SCATTER_PASS;
+    threader->SingleMethodExecute();
+    indexer.Pass = vtkTreeVertexToEdgeSelectionIndexer::VALIDATE_PASS;
+    threader->SingleMethodExecute();
+    for (int t = 0; t < numThreads; t++)
+      {
+      this->NumberOfDuplicates += indexer.Duplicates[t];
+      }
+    if (this->NumberOfDuplicates > 0)
+      {
+      // Make the first vertex with a pedigree id win its slot, as with
+      // the sorted pairs, whatever the thread scheduling was.
+      for (vtkIdType v = numVertices - 1; v >= 0; v--)
+        {
+        indexer.PedigreeToEdge[indexer.Pedigrees[v] - minimum] = v;
+        }
+      }
+
+    // The table now holds vertices, replace them by their parent edges.
+    vtkIdType* table = &internals->PedigreeToEdge[0];
+    const vtkIdType* parentEdge = &internals->ParentEdge[0];
+    vtkIdType size = static_cast<vtkIdType>(internals->PedigreeToEdge.size());
+    for (vtkIdType i = 0; i < size; i++)
+      {
+      table[i] = table[i] >= 0 ? parentEdge[table[i]] : table[i];
+      }
+    }
+
+  if (this->NumberOfDuplicates > 0)
+    {
+    vtkWarningMacro(<< this->NumberOfDuplicates
+      << " vertices share their pedigree id with another vertex.");
+    }
 }
 
 int vtkTreeVertexToEdgeSelection::RequestData(
@@ -53,17 +276,12 @@ int vtkTreeVertexToEdgeSelection::RequestData(
   // Update mapping
   if (tree != this->Tree || tree->GetMTime() > this->TreeMTime)
     {
-    this->Internals->PedigreeToId.clear();
-    vtkIdTypeArray* ped = vtkIdTypeArray::SafeDownCast(
-      tree->GetVertexData()->GetAbstractArray("PedigreeVertexId"));
-    for (vtkIdType v = 0; v < tree->GetNumberOfVertices(); v++)
-      {
-      this->Internals->PedigreeToId[ped->GetValue(v)] = v;
-      }
+    this->BuildIndex(tree);
     this->Tree = tree;
     this->TreeMTime = tree->GetMTime();
     }
 
+  this->NumberOfMisses = 0;
   vtkSelectionNode* node = input->GetNode(0);
   if (node)
     {
@@ -74,16 +292,53 @@ int vtkTreeVertexToEdgeSelection::RequestData(
         vtkSmartPointer<vtkIdTypeArray>::New();
       vtkSmartPointer<vtkSelectionNode> outNode =
         vtkSmartPointer<vtkSelectionNode>::New();
-      for (vtkIdType i = 0; i < arr->GetNumberOfTuples(); i++)
+      vtkIdType numSelected = arr->GetNumberOfTuples();
+      outArr->SetNumberOfValues(numSelected);
+      const vtkIdType* selected = arr->GetPointer(0);
+      vtkIdType* edges = outArr->GetPointer(0);
+      vtkIdType numEdges = 0;
+      vtkIdType misses = 0;
+      vtkTreeVertexToEdgeSelectionInternals* internals = this->Internals;
+      if (!internals->PedigreeToEdge.empty())
+        {
+        // One table lookup per id, ids outside of the table are misses.
+        const vtkIdType* table = &internals->PedigreeToEdge[0];
+        vtkIdType size = static_cast<vtkIdType>(internals->PedigreeToEdge.size());
+        vtkIdType offset = internals->Offset;
+        for (vtkIdType i = 0; i < numSelected; i++)
+          {
+          vtkIdType p = selected[i] - offset;
+          vtkIdType e = (p >= 0 && p < size) ? table[p] :
+            VTK_TREE_VERTEX_TO_EDGE_MISS;
+          edges[numEdges] = e;
+          numEdges += e >= 0;
+          misses += e == VTK_TREE_VERTEX_TO_EDGE_MISS;
+          }
+        }
+      else if (!internals->Sorted.empty())
         {
-        vtkIdType pedigree = arr->GetValue(i);
-        vtkIdType vertId = this->Internals->PedigreeToId[pedigree];
-        vtkEdgeType edgeId = tree->GetParentEdge(vertId);
-        if (edgeId.Id >= 0)
+        for (vtkIdType i = 0; i < numSelected; i++)
           {
-          outArr->InsertNextValue(edgeId.Id);
+          vtkIdType e = internals->Lookup(selected[i]);
+          edges[numEdges] = e;
+          numEdges += e >= 0;
+          misses += e == VTK_TREE_VERTEX_TO_EDGE_MISS;
           }
         }
+      else
+        {
+        misses = numSelected;
+        }
+      outArr->SetNumberOfValues(numEdges);
+      outArr->Squeeze();
+
+      // Selections often hold vertices of collapsed subtrees, which are
+      // not in the tree, so misses are only counted and reported as debug
+      // output.
+      this->NumberOfMisses = misses;
+      vtkDebugMacro(<< misses << " of " << numSelected
+        << " selected pedigree ids are not in the tree.");
+
       outNode->SetSelectionList(outArr);
       outNode->GetProperties()->Copy(node->GetProperties());
       outNode->SetContentType(vtkSelectionNode::INDICES);
@@ -109,4 +364,3 @@ int vtkTreeVertexToEdgeSelection::FillInputPortInformation(
     }
   return 1;
 }
-
@@ -5,6 +5,12 @@
 // selection.
 //
 // .SECTION Description
+// The first input is a selection of pedigree ids, the second the tree they
+// belong to. The output selects the edges going to the selected vertices
+// from their parents. The tree is indexed by pedigree id once per
+// modification, in parallel, and every selection is then converted with
+// one table lookup per id. Ids that are not in the tree are counted as
+// misses instead of being mapped to a vertex.
 
 #ifndef __vtkTreeVertexToEdgeSelection_h
 #define __vtkTreeVertexToEdgeSelection_h
@@ -21,6 +27,13 @@ public:
   vtkTypeRevisionMacro(vtkTreeVertexToEdgeSelection, vtkSelectionAlgorithm);
   void PrintSelf(ostream& os, vtkIndent indent);
 
+  // Description:
+  // The number of selected pedigree ids that were not found in the tree
+  // during the last execution, and the number of vertices of the tree
+  // sharing their pedigree id with another vertex.
+  vtkGetMacro(NumberOfMisses, vtkIdType);
+  vtkGetMacro(NumberOfDuplicates, vtkIdType);
+
 protected:
   vtkTreeVertexToEdgeSelection();
   ~vtkTreeVertexToEdgeSelection();
@@ -36,6 +49,12 @@ protected:
   vtkTreeVertexToEdgeSelectionInternals* Internals;
   vtkTree* Tree;
   unsigned long TreeMTime;
+  vtkIdType NumberOfMisses;
+  vtkIdType NumberOfDuplicates;
+
+  // Description:
+  // Index the pedigree ids of the tree.
+  void BuildIndex(vtkTree* tree);
     
 private:
   vtkTreeVertexToEdgeSelection(const vtkTreeVertexToEdgeSelection&); // Not implemented